@@ -1,5 +1,11 @@
 #include "thor/astarheuristic.h"
 
+#include <valhalla/midgard/constants.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
 using namespace valhalla::midgard;
 
 namespace valhalla {
@@ -7,13 +13,17 @@ namespace thor {
 
 // Default constructor
 AStarHeuristic::AStarHeuristic()
-  : costfactor_(1.0f), distapprox_({}) {
+  : costfactor_(1.0f), distapprox_({}), destlat_(0.0f), destlng_(0.0f),
+    mperlngdeg_(0.0f) {
 }
 
 // Initializes the AStar heuristic
 void AStarHeuristic::Init(const PointLL& ll, const float factor) {
   distapprox_.SetTestPoint(ll);
   costfactor_ = factor;
+  destlat_ = ll.lat();
+  destlng_ = ll.lng();
+  mperlngdeg_ = DistanceApproximator::MetersPerLngDegree(ll.lat());
 }
 
 // Get the distance to the destination
@@ -31,5 +41,43 @@ float AStarHeuristic::Get(const float dist) const {
   return dist * costfactor_;
 }
 
+// Get the distances and A* heuristics for a batch of lat,lngs.
+void AStarHeuristic::Get(const PointLL* lls, const uint32_t n,
+                         float* distances, float* heuristics) const {
+  uint32_t i = 0;
+#ifdef __SSE__
+  // PointLL is a lng,lat pair of floats - load 2 points per register and
+  // shuffle into 4 lngs and 4 lats.
+  static_assert(sizeof(PointLL) == 2 * sizeof(float),
+                "PointLL must be a packed lng,lat pair");
+  const float* p = reinterpret_cast<const float*>(lls);
+  const __m128 destlat = _mm_set1_ps(destlat_);
+  const __m128 destlng = _mm_set1_ps(destlng_);
+  const __m128 mperlat = _mm_set1_ps(kMetersPerDegreeLat);
+  const __m128 mperlng = _mm_set1_ps(mperlngdeg_);
+  const __m128 factor  = _mm_set1_ps(costfactor_);
+  for ( ; i + 4 <= n; i += 4, p += 8) {
+    __m128 a = _mm_loadu_ps(p);
+    __m128 b = _mm_loadu_ps(p + 4);
+    __m128 lng = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 lat = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+    __m128 latm = _mm_mul_ps(_mm_sub_ps(lat, destlat), mperlat);
+    __m128 lngm = _mm_mul_ps(_mm_sub_ps(lng, destlng), mperlng);
+    __m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(latm, latm),
+                                         _mm_mul_ps(lngm, lngm)));
+    _mm_storeu_ps(distances + i, dist);
+    _mm_storeu_ps(heuristics + i, _mm_mul_ps(dist, factor));
+  }
+#endif
+
+  // Remaining lat,lngs (or all of them without SSE)
+  for ( ; i < n; i++) {
+    float latm = (lls[i].lat() - destlat_) * kMetersPerDegreeLat;
+    float lngm = (lls[i].lng() - destlng_) * mperlngdeg_;
+    distances[i]  = sqrtf(latm * latm + lngm * lngm);
+    heuristics[i] = distances[i] * costfactor_;
+  }
+}
+
 }
 }
@@ -0,0 +1,418 @@
+#include "thor/asynctileloader.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "config.h"
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+#include <valhalla/midgard/logging.h>
+#include "thor/memorytile.h"
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// Open a tile file and allocate a buffer for its contents. Returns -1 if
+// the file does not exist.
+int open_tile(const std::string& file, std::shared_ptr<char>& data,
+              size_t& size) {
+  int fd = open(file.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return -1;
+  }
+  size = st.st_size;
+  data.reset(new char[size > 0 ? size : 1], std::default_delete<char[]>());
+  return fd;
+}
+
+#ifdef HAVE_LIBURING
+
+// User data of cancel requests (reads have their index in the batch)
+constexpr uintptr_t kCancelData = UINTPTR_MAX;
+
+// Number of times to retry waiting for completions while cancelling
+constexpr uint32_t kMaxCancelRetries = 1000;
+
+// Cancel the reads in flight on a ring and reap their completions, after
+// which the kernel no longer writes to their buffers. Reaped reads are
+// cleared from inflight_reads. Waiting on the ring may fail (the reason to
+// cancel) so completions are also polled, for a bounded number of retries.
+// Returns false if reads may still be in flight.
+bool cancel_reads(io_uring* ring, std::vector<bool>& inflight_reads) {
+  uint32_t inflight = 0, cancels = 0;
+  for (uint32_t i = 0; i < inflight_reads.size(); i++) {
+    if (!inflight_reads[i]) {
+      continue;
+    }
+    inflight++;
+    io_uring_sqe* sqe = io_uring_get_sqe(ring);
+    if (sqe != nullptr) {
+      io_uring_prep_cancel(sqe, reinterpret_cast<void*>(static_cast<uintptr_t>(i)), 0);
+      io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(kCancelData));
+      cancels++;
+    }
+  }
+  io_uring_submit(ring);
+
+  // Entries the kernel did not take never complete. They are the last ones
+  // queued - the cancels and then any reads queued before them.
+  uint32_t unsubmitted = io_uring_sq_ready(ring);
+  if (unsubmitted > cancels) {
+    inflight -= std::min(inflight, unsubmitted - cancels);
+  }
+
+  uint32_t retries = 0;
+  while (inflight > 0) {
+    io_uring_cqe* cqe = nullptr;
+    if (io_uring_peek_cqe(ring, &cqe) != 0 || cqe == nullptr) {
+      if (io_uring_wait_cqe(ring, &cqe) < 0 || cqe == nullptr) {
+        if (++retries > kMaxCancelRetries) {
+          return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+    }
+    uintptr_t data = reinterpret_cast<uintptr_t>(io_uring_cqe_get_data(cqe));
+    if (data != kCancelData) {
+      inflight_reads[data] = false;
+      inflight--;
+    }
+    io_uring_cqe_seen(ring, cqe);
+  }
+  return true;
+}
+
+#endif
+
+}
+
+namespace valhalla {
+namespace thor {
+
+// Constructor - start the reader threads
+AsyncTileLoader::AsyncTileLoader(const TileHierarchy& hierarchy,
+                                 const uint32_t threads,
+                                 const uint32_t queue_depth,
+                                 const bool use_io_uring)
+    : hierarchy_(hierarchy),
+      queue_depth_(std::max(queue_depth, 1u)),
+      use_io_uring_(use_io_uring),
+      done_(false) {
+  // Check that io_uring works (it may be disabled in the kernel or
+  // blocked in containers)
+  if (use_io_uring_) {
+    io_uring* ring = AcquireRing();
+    use_io_uring_ = (ring != nullptr);
+    if (ring != nullptr) {
+      ReleaseRing(ring);
+    } else {
+      LOG_INFO("io_uring is not available - reading tiles on threads");
+    }
+  }
+  for (uint32_t i = 0; i < threads; i++) {
+    threads_.emplace_back(&AsyncTileLoader::Run, this);
+  }
+}
+
+// Destructor - stop the reader threads and free the rings
+AsyncTileLoader::~AsyncTileLoader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  condition_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+#ifdef HAVE_LIBURING
+  for (auto ring : rings_) {
+    io_uring_queue_exit(ring);
+    delete ring;
+  }
+#endif
+}
+
+// Load a tile
+GraphTile* AsyncTileLoader::Load(const GraphId& tileid) {
+  std::vector<GraphTile*> tiles;
+  LoadBatch({ tileid }, tiles);
+  return tiles.front();
+}
+
+// Load a batch of tiles with the reads in flight concurrently
+void AsyncTileLoader::LoadBatch(const std::vector<GraphId>& tileids,
+                                std::vector<GraphTile*>& tiles) {
+  std::vector<TileRead> reads(tileids.size());
+  for (uint32_t i = 0; i < tileids.size(); i++) {
+    reads[i].file = hierarchy_.tile_dir() + "/" +
+                    GraphTile::FileSuffix(tileids[i], hierarchy_);
+  }
+
+  // Reads io_uring could not complete are read on the threads
+  if (use_io_uring_) {
+    ReadIoUring(reads);
+  }
+  ReadThreads(reads);
+
+  tiles.assign(reads.size(), nullptr);
+  for (uint32_t i = 0; i < reads.size(); i++) {
+    if (reads[i].status != TileRead::Status::kDone) {
+      continue;
+    }
+    GraphTile* tile = new MemoryTile(reads[i].data, reads[i].size);
+    if (tile->size() == 0) {
+      delete tile;
+    } else {
+      tiles[i] = tile;
+    }
+  }
+}
+
+// Returns true if reads are submitted through io_uring
+bool AsyncTileLoader::uses_io_uring() const {
+  return use_io_uring_;
+}
+
+// Read a whole tile file
+bool AsyncTileLoader::ReadFile(const std::string& file,
+                               std::shared_ptr<char>& data, size_t& size) {
+  int fd = open_tile(file, data, size);
+  if (fd == -1) {
+    return false;
+  }
+  size_t offset = 0;
+  while (offset < size) {
+    ssize_t n = pread(fd, data.get() + offset, size - offset, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    offset += n;
+  }
+  close(fd);
+  return offset == size;
+}
+
+// Read the pending reads of a batch on the reader threads
+void AsyncTileLoader::ReadThreads(std::vector<TileRead>& reads) {
+  // Without reader threads read on this thread
+  if (threads_.empty()) {
+    for (auto& read : reads) {
+      if (read.status == TileRead::Status::kPending) {
+        read.status = ReadFile(read.file, read.data, read.size) ?
+            TileRead::Status::kDone : TileRead::Status::kMissing;
+      }
+    }
+    return;
+  }
+
+  uint32_t remaining = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (auto& read : reads) {
+    if (read.status == TileRead::Status::kPending) {
+      queue_.emplace_back(&read, &remaining);
+      remaining++;
+    }
+  }
+  if (remaining == 0) {
+    return;
+  }
+  condition_.notify_all();
+  finished_.wait(lock, [&remaining]() { return remaining == 0; });
+}
+
+// Reader thread - read files from the queue until stopped
+void AsyncTileLoader::Run() {
+  while (true) {
+    std::pair<TileRead*, uint32_t*> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return done_ || !queue_.empty(); });
+      if (done_) {
+        return;
+      }
+      job = queue_.front();
+      queue_.pop_front();
+    }
+    TileRead* read = job.first;
+    bool ok = ReadFile(read->file, read->data, read->size);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      read->status = ok ? TileRead::Status::kDone : TileRead::Status::kMissing;
+      (*job.second)--;
+    }
+    finished_.notify_all();
+  }
+}
+
+#ifdef HAVE_LIBURING
+
+// Read the pending reads of a batch through io_uring
+void AsyncTileLoader::ReadIoUring(std::vector<TileRead>& reads) {
+  io_uring* ring = AcquireRing();
+  if (ring == nullptr) {
+    return;
+  }
+
+  // Open the files (metadata is usually cached) and queue the reads
+  std::vector<int> fds(reads.size(), -1);
+  std::vector<size_t> offsets(reads.size(), 0);
+  std::deque<uint32_t> submit;
+  for (uint32_t i = 0; i < reads.size(); i++) {
+    if (reads[i].status != TileRead::Status::kPending) {
+      continue;
+    }
+    fds[i] = open_tile(reads[i].file, reads[i].data, reads[i].size);
+    if (fds[i] == -1) {
+      reads[i].status = TileRead::Status::kMissing;
+    } else if (reads[i].size == 0) {
+      reads[i].status = TileRead::Status::kDone;
+    } else {
+      submit.push_back(i);
+    }
+  }
+
+  // Keep up to queue depth reads in flight. Short reads are resubmitted
+  // for the rest of the file.
+  uint32_t inflight = 0;
+  std::vector<bool> inflight_reads(reads.size(), false);
+  bool failed = false;
+  while (!failed && (!submit.empty() || inflight > 0)) {
+    while (!submit.empty() && inflight < queue_depth_) {
+      io_uring_sqe* sqe = io_uring_get_sqe(ring);
+      if (sqe == nullptr) {
+        break;
+      }
+      uint32_t i = submit.front();
+      submit.pop_front();
+      io_uring_prep_read(sqe, fds[i], reads[i].data.get() + offsets[i],
+                         reads[i].size - offsets[i], offsets[i]);
+      io_uring_sqe_set_data(sqe, reinterpret_cast<void*>(static_cast<uintptr_t>(i)));
+      inflight_reads[i] = true;
+      inflight++;
+    }
+    io_uring_submit(ring);
+
+    io_uring_cqe* cqe = nullptr;
+    int ret;
+    do {
+      ret = io_uring_wait_cqe(ring, &cqe);
+    } while (ret == -EINTR);
+    if (ret < 0) {
+      failed = true;
+      break;
+    }
+    uint32_t i = static_cast<uint32_t>(
+        reinterpret_cast<uintptr_t>(io_uring_cqe_get_data(cqe)));
+    int res = cqe->res;
+    io_uring_cqe_seen(ring, cqe);
+    inflight_reads[i] = false;
+    inflight--;
+    if (res > 0) {
+      offsets[i] += res;
+      if (offsets[i] < reads[i].size) {
+        submit.push_back(i);
+      } else {
+        reads[i].status = TileRead::Status::kDone;
+      }
+    } else if (res == -EINTR || res == -EAGAIN) {
+      submit.push_back(i);
+    } else {
+      // Read error or unexpected end of file - read again on the threads
+      reads[i].data.reset();
+    }
+  }
+
+  if (failed) {
+    // The ring is unusable. Reads still in flight may write to their
+    // buffers (and read from their files) so they are cancelled and reaped
+    // before the buffers are freed and the files closed. Buffers of reads
+    // that cannot be reaped are leaked rather than freed while the kernel
+    // may still write to them. The pending reads are redone on the threads.
+    LOG_ERROR("io_uring wait failed - reading tiles on threads");
+    if (!cancel_reads(ring, inflight_reads)) {
+      uint32_t leaked = 0;
+      for (uint32_t i = 0; i < reads.size(); i++) {
+        if (inflight_reads[i]) {
+          new std::shared_ptr<char>(reads[i].data);  // never freed
+          leaked++;
+        }
+      }
+      LOG_ERROR("io_uring reads could not be cancelled - leaking " +
+                std::to_string(leaked) + " tile buffers");
+    }
+    for (auto& read : reads) {
+      if (read.status == TileRead::Status::kPending) {
+        read.data.reset();
+      }
+    }
+    io_uring_queue_exit(ring);
+    delete ring;
+  } else {
+    ReleaseRing(ring);
+  }
+  for (auto fd : fds) {
+    if (fd != -1) {
+      close(fd);
+    }
+  }
+}
+
+// Get a ring for a batch
+io_uring* AsyncTileLoader::AcquireRing() {
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex_);
+    if (!rings_.empty()) {
+      io_uring* ring = rings_.back();
+      rings_.pop_back();
+      return ring;
+    }
+  }
+  io_uring* ring = new io_uring;
+  if (io_uring_queue_init(queue_depth_, ring, 0) < 0) {
+    delete ring;
+    return nullptr;
+  }
+  return ring;
+}
+
+// Return a ring after a batch
+void AsyncTileLoader::ReleaseRing(io_uring* ring) {
+  std::lock_guard<std::mutex> lock(rings_mutex_);
+  rings_.push_back(ring);
+}
+
+#else
+
+// Without liburing reads always use the reader threads
+void AsyncTileLoader::ReadIoUring(std::vector<TileRead>& reads) {
+}
+
+io_uring* AsyncTileLoader::AcquireRing() {
+  return nullptr;
+}
+
+void AsyncTileLoader::ReleaseRing(io_uring* ring) {
+}
+
+#endif
+
+}
+}
@@ -0,0 +1,330 @@
+#include "thor/concurrenttilecache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// Evict down to this fraction of the size limit (so eviction is not run on
+// every load once the cache is full)
+constexpr float kLowWaterMark = 0.9f;
+
+// Hit counter used by the calling thread
+uint32_t hit_counter(const uint32_t count) {
+  static thread_local uint32_t counter =
+      std::hash<std::thread::id>()(std::this_thread::get_id()) % count;
+  return counter;
+}
+
+}
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+ConcurrentTileCache::ConcurrentTileCache(const TileHierarchy& hierarchy,
+                                         const size_t max_bytes,
+                                         TileLoader* loader,
+                                         const uint32_t max_readers)
+    : hierarchy_(hierarchy),
+      loader_(loader),
+      max_bytes_(max_bytes),
+      pinned_level_(hierarchy.levels().begin()->second.level),
+      hand_(0),
+      epoch_(0),
+      max_readers_(std::max(max_readers, 1u)),
+      reader_epochs_(new std::atomic<uint64_t>[max_readers_]),
+      reader_depths_(new uint32_t[max_readers_]),
+      readers_(0),
+      misses_(0),
+      evictions_(0),
+      size_(0) {
+  if (loader_ == nullptr) {
+    file_loader_.reset(new FileTileLoader(hierarchy_));
+    loader_ = file_loader_.get();
+  }
+  for (uint32_t level = 0; level < 8; level++) {
+    tilecounts_[level] = 0;
+  }
+  for (const auto& level : hierarchy_.levels()) {
+    uint32_t count = level.second.tiles.TileCount();
+    uint32_t l = level.second.level;
+    tilecounts_[l] = count;
+    slots_[l].reset(new std::atomic<const GraphTile*>[count]);
+    referenced_[l].reset(new std::atomic<bool>[count]);
+    for (uint32_t i = 0; i < count; i++) {
+      slots_[l][i].store(nullptr);
+      referenced_[l][i].store(false);
+    }
+  }
+  for (uint32_t i = 0; i < max_readers_; i++) {
+    reader_epochs_[i].store(kInactive);
+    reader_depths_[i] = 0;
+  }
+  for (uint32_t i = 0; i < kHitCounters; i++) {
+    hits_[i].count.store(0);
+  }
+}
+
+// Destructor
+ConcurrentTileCache::~ConcurrentTileCache() {
+  for (uint32_t level = 0; level < 8; level++) {
+    for (uint32_t i = 0; i < tilecounts_[level]; i++) {
+      const GraphTile* tile = slots_[level][i].load();
+      if (tile != &missing_) {
+        delete tile;
+      }
+    }
+  }
+  for (const auto& retired : retired_) {
+    delete retired.first;
+  }
+}
+
+// Get the graph tile containing the given GraphId
+const GraphTile* ConcurrentTileCache::Get(const GraphId& id) {
+  uint32_t level = id.level();
+  uint32_t tileid = id.tileid();
+  if (tileid >= tilecounts_[level]) {
+    return nullptr;
+  }
+
+  // Cached tiles only need a load. Set the referenced flag only if it is
+  // not already set to avoid writing to a shared cache line on every hit.
+  std::atomic<const GraphTile*>& slot = slots_[level][tileid];
+  const GraphTile* tile = slot.load(std::memory_order_acquire);
+  if (tile != nullptr) {
+    std::atomic<bool>& referenced = referenced_[level][tileid];
+    if (!referenced.load(std::memory_order_relaxed)) {
+      referenced.store(true, std::memory_order_relaxed);
+    }
+    hits_[hit_counter(kHitCounters)].count.fetch_add(1, std::memory_order_relaxed);
+    return (tile == &missing_) ? nullptr : tile;
+  }
+
+  // Load the tile. Check again under the lock in case another thread
+  // loaded it.
+  GraphId base = id.Tile_Base();
+  bool loaded = false;
+  {
+    std::lock_guard<std::mutex> lock(load_mutexes_[tileid % kLoadLocks]);
+    tile = slot.load(std::memory_order_acquire);
+    if (tile == nullptr) {
+      misses_++;
+      tile = &missing_;
+      GraphTile* newtile = loader_->Load(base);
+      if (newtile != nullptr) {
+        size_ += newtile->size();
+        tile = newtile;
+        loaded = true;
+      }
+      referenced_[level][tileid].store(true, std::memory_order_relaxed);
+      slot.store(tile, std::memory_order_release);
+    }
+  }
+  if (loaded) {
+    Loaded(base);
+  }
+  return (tile == &missing_) ? nullptr : tile;
+}
+
+// Load tiles into the cache ahead of use
+void ConcurrentTileCache::Preload(const std::vector<GraphId>& tileids) {
+  // Tiles that are not cached (or known to be missing)
+  std::vector<GraphId> load;
+  for (const auto& id : tileids) {
+    if (id.tileid() < tilecounts_[id.level()] &&
+        slots_[id.level()][id.tileid()].load(std::memory_order_acquire) == nullptr) {
+      load.push_back(id.Tile_Base());
+    }
+  }
+  if (load.empty()) {
+    return;
+  }
+
+  // Read the batch without holding load locks. Publish each tile unless
+  // another thread loaded it in the meantime.
+  std::vector<GraphTile*> tiles;
+  loader_->LoadBatch(load, tiles);
+  for (uint32_t i = 0; i < load.size(); i++) {
+    uint32_t level = load[i].level();
+    uint32_t tileid = load[i].tileid();
+    bool loaded = false;
+    {
+      std::lock_guard<std::mutex> lock(load_mutexes_[tileid % kLoadLocks]);
+      std::atomic<const GraphTile*>& slot = slots_[level][tileid];
+      if (slot.load(std::memory_order_acquire) == nullptr) {
+        misses_++;
+        const GraphTile* tile = &missing_;
+        if (tiles[i] != nullptr) {
+          size_ += tiles[i]->size();
+          tile = tiles[i];
+          loaded = true;
+        }
+        referenced_[level][tileid].store(true, std::memory_order_relaxed);
+        slot.store(tile, std::memory_order_release);
+      } else {
+        delete tiles[i];
+      }
+    }
+    if (loaded) {
+      Loaded(load[i]);
+    }
+  }
+}
+
+// Register a reader - reuse a released reader Id if possible
+uint32_t ConcurrentTileCache::RegisterReader() {
+  std::lock_guard<std::mutex> lock(reader_mutex_);
+  if (!free_readers_.empty()) {
+    uint32_t reader = free_readers_.back();
+    free_readers_.pop_back();
+    return reader;
+  }
+  if (readers_.load() >= max_readers_) {
+    throw std::runtime_error("Too many tile cache readers");
+  }
+  return readers_++;
+}
+
+// Release a reader Id for reuse
+void ConcurrentTileCache::ReleaseReader(const uint32_t reader) {
+  std::lock_guard<std::mutex> lock(reader_mutex_);
+  free_readers_.push_back(reader);
+}
+
+// Begin a read section - announce the current epoch
+void ConcurrentTileCache::BeginRead(const uint32_t reader) {
+  if (reader_depths_[reader]++ == 0) {
+    reader_epochs_[reader].store(epoch_.load());
+    // The epoch must be visible to reclaiming threads before this reader
+    // loads any tile pointer (a store-load ordering that acquire loads of
+    // the tile slots do not give)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+}
+
+// End a read section
+void ConcurrentTileCache::EndRead(const uint32_t reader) {
+  if (--reader_depths_[reader] == 0) {
+    reader_epochs_[reader].store(kInactive);
+  }
+}
+
+// Get statistics about the cache
+TileCacheStats ConcurrentTileCache::stats() const {
+  TileCacheStats stats;
+  for (uint32_t i = 0; i < kHitCounters; i++) {
+    stats.hits += hits_[i].count.load(std::memory_order_relaxed);
+  }
+  stats.misses    = misses_.load();
+  stats.evictions = evictions_.load();
+  stats.bytes     = size_.load();
+  return stats;
+}
+
+// Evict a tile
+bool ConcurrentTileCache::Evict(const GraphId& id) {
+  uint32_t level = id.level();
+  uint32_t tileid = id.tileid();
+  if (tileid >= tilecounts_[level]) {
+    return false;
+  }
+  // Leave tiles known to be missing marked as missing
+  std::atomic<const GraphTile*>& slot = slots_[level][tileid];
+  const GraphTile* tile = slot.load();
+  if (tile == nullptr || tile == &missing_ ||
+      !slot.compare_exchange_strong(tile, nullptr)) {
+    return false;
+  }
+  size_ -= tile->size();
+  evictions_++;
+  Retire(tile);
+  return true;
+}
+
+// Add a newly loaded tile to the evictable tiles and evict if needed
+void ConcurrentTileCache::Loaded(const GraphId& id) {
+  if (id.level() == pinned_level_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(clock_mutex_);
+  evictable_.push_back(id);
+  if (max_bytes_ > 0 && size_.load() > max_bytes_) {
+    EvictToFit();
+  }
+}
+
+// Evict tiles using the CLOCK algorithm. The hand sweeps over the evictable
+// tiles: a referenced tile has its flag cleared and is skipped, otherwise it
+// is evicted. At most two sweeps are made (after one sweep every flag has
+// been cleared).
+void ConcurrentTileCache::EvictToFit() {
+  size_t target = static_cast<size_t>(max_bytes_ * kLowWaterMark);
+  size_t steps = 2 * evictable_.size();
+  while (size_.load() > target && !evictable_.empty() && steps-- > 0) {
+    if (hand_ >= evictable_.size()) {
+      hand_ = 0;
+    }
+    const GraphId& id = evictable_[hand_];
+    std::atomic<bool>& referenced = referenced_[id.level()][id.tileid()];
+    const GraphTile* tile = slots_[id.level()][id.tileid()].load();
+    if (tile != nullptr && referenced.exchange(false)) {
+      hand_++;
+      continue;
+    }
+
+    // Evict (the tile may already have been evicted) and remove it from the
+    // evictable tiles
+    Evict(id);
+    evictable_[hand_] = evictable_.back();
+    evictable_.pop_back();
+  }
+}
+
+// Retire an evicted tile
+void ConcurrentTileCache::Retire(const GraphTile* tile) {
+  std::lock_guard<std::mutex> lock(retired_mutex_);
+  retired_.emplace_back(tile, epoch_++);
+  FreeRetired();
+}
+
+// Free evicted tiles that no reader can be using
+void ConcurrentTileCache::Reclaim() {
+  std::lock_guard<std::mutex> lock(retired_mutex_);
+  FreeRetired();
+}
+
+// Free retired tiles. A reader that got an evicted tile began its read
+// section at or before the epoch the tile was evicted in, so tiles evicted
+// before the oldest active reader began are safe to free.
+void ConcurrentTileCache::FreeRetired() {
+  uint32_t n = readers_.load();
+  uint64_t oldest = kInactive;
+  for (uint32_t i = 0; i < n; i++) {
+    oldest = std::min(oldest, reader_epochs_[i].load());
+  }
+  size_t i = 0;
+  while (i < retired_.size()) {
+    if (retired_[i].second < oldest) {
+      delete retired_[i].first;
+      retired_[i] = retired_.back();
+      retired_.pop_back();
+    } else {
+      i++;
+    }
+  }
+}
+
+// Get the total size of the cached tiles
+size_t ConcurrentTileCache::size() const {
+  return size_.load();
+}
+
+}
+}
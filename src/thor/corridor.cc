@@ -0,0 +1,63 @@
+#include "thor/corridor.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <valhalla/midgard/constants.h>
+#include <valhalla/midgard/distanceapproximator.h>
+
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+Corridor::Corridor() {
+}
+
+// Form the corridor around a route
+void Corridor::Build(const TileHierarchy& hierarchy,
+                     const std::vector<PointLL>& shape, const float radius) {
+  tiles_.clear();
+  if (shape.empty()) {
+    return;
+  }
+
+  // Add the tiles around points along the route, at most the radius apart
+  // so long edges between the shape points are covered
+  auto add = [this, &hierarchy, radius](const PointLL& ll) {
+    float dlat = radius / kMetersPerDegreeLat;
+    float dlng = radius / std::max(
+        DistanceApproximator::MetersPerLngDegree(ll.lat()), 1.0f);
+    AABB2<PointLL> box(ll.lng() - dlng, ll.lat() - dlat,
+                       ll.lng() + dlng, ll.lat() + dlat);
+    for (const auto& level : hierarchy.levels()) {
+      for (auto tileid : level.second.tiles.TileList(box)) {
+        tiles_.insert(GraphId(tileid, level.second.level, 0).value);
+      }
+    }
+  };
+  add(shape.front());
+  for (uint32_t i = 1; i < shape.size(); i++) {
+    const PointLL& a = shape[i - 1];
+    const PointLL& b = shape[i];
+    uint32_t steps = std::ceil(a.Distance(b) / std::max(radius, 1.0f));
+    for (uint32_t j = 1; j <= steps; j++) {
+      float t = static_cast<float>(j) / steps;
+      add(PointLL(a.lng() + (b.lng() - a.lng()) * t,
+                  a.lat() + (b.lat() - a.lat()) * t));
+    }
+    if (steps == 0) {
+      add(b);
+    }
+  }
+}
+
+// Get the number of tiles in the corridor
+uint32_t Corridor::size() const {
+  return tiles_.size();
+}
+
+}
+}
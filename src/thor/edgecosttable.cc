@@ -0,0 +1,68 @@
+#include "thor/edgecosttable.h"
+
+#include <valhalla/midgard/logging.h>
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+EdgeCostTable::EdgeCostTable()
+    : fingerprint_(0),
+      generation_(0),
+      computed_(0) {
+}
+
+// Customize the table for a costing
+void EdgeCostTable::Customize(const RoutingGraph& graph,
+                              const std::shared_ptr<DynamicCost>& costing,
+                              const uint64_t fingerprint, const bool eager) {
+  if (entries_.size() == graph.edgecount() && generation_ != 0 &&
+      fingerprint == fingerprint_) {
+    return;
+  }
+
+  // Make all entries stale. Entries start at generation 0 so they are
+  // reset when the generation wraps.
+  if (entries_.size() != graph.edgecount() || ++generation_ == 0) {
+    Entry stale;
+    stale.cost = Cost(0.0f, 0.0f);
+    stale.generation = 0;
+    entries_.assign(graph.edgecount(), stale);
+    generation_ = 1;
+  }
+  fingerprint_ = fingerprint;
+  computed_ = 0;
+
+  // Compute all edge costs (with the density of each edge's start node)
+  if (eager) {
+    const DynamicCost& cost = *costing;
+    for (uint32_t node = 0; node < graph.nodecount(); node++) {
+      uint32_t density = graph.nodeinfo(node)->density();
+      for (uint32_t e = graph.edge_index(node); e < graph.edge_index(node + 1); e++) {
+        Get(e, graph.directededge(e), density, cost);
+      }
+    }
+    LOG_INFO("Computed " + std::to_string(computed_) + " edge costs");
+  }
+}
+
+// Get the fingerprint the table is customized for
+uint64_t EdgeCostTable::fingerprint() const {
+  return fingerprint_;
+}
+
+// Get the number of entries
+uint32_t EdgeCostTable::size() const {
+  return entries_.size();
+}
+
+// Get the number of edge costs computed since the last customization
+uint64_t EdgeCostTable::computed() const {
+  return computed_;
+}
+
+}
+}
@@ -32,5 +32,21 @@ EdgeStatusInfo EdgeStatus::Get(const baldr::GraphId& edgeid) const {
   }*/
 }
 
+// Constructor
+DenseEdgeStatus::DenseEdgeStatus()
+    : generation_(0) {
+}
+
+// Clear current edge status (all become unreached). Entries set in an older
+// generation read as unreached. The array is only cleared when the number
+// of edges changes or the generation wraps.
+void DenseEdgeStatus::Init(const uint32_t edgecount) {
+  generation_++;
+  if (status_.size() != edgecount || generation_ == 0) {
+    status_.assign(edgecount, std::make_pair(0u, EdgeStatusInfo()));
+    generation_ = 1;
+  }
+}
+
 }
 }
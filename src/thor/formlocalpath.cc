@@ -19,7 +19,7 @@ constexpr uint32_t kLocalLevel = 2;
 GraphId PathAlgorithm::GetStartNode(GraphReader& graphreader,
                      const DirectedEdge* directededge) {
   // Get the end node of directed edge
-  const GraphTile* tile = graphreader.GetGraphTile(directededge->endnode());
+  const GraphTile* tile = GetGraphTile(graphreader, shared_tilecache_, directededge->endnode());
   const NodeInfo* nodeinfo = tile->node(directededge->endnode());
 
   // Get the opposing edge and then get its endnode
@@ -31,7 +31,7 @@ GraphId PathAlgorithm::GetStartNode(GraphReader& graphreader,
   while (endnode.level() != kLocalLevel) {
     // The transition down edge will be one of the last edges (transition up
     // edges are last if they exist)
-    tile = graphreader.GetGraphTile(endnode);
+    tile = GetGraphTile(graphreader, shared_tilecache_, endnode);
     nodeinfo = tile->node(endnode);
     edge = tile->directededge(nodeinfo->edge_index() +
                               nodeinfo->edge_count() - 1);
@@ -67,7 +67,7 @@ std::vector<GraphId> PathAlgorithm::FormLocalPath(const uint32_t dest,
               kInvalidLabel) {
     // Get the GraphId of the directed edge and and get the directed edge info
     GraphId edgeid = edgelabels_[edgelabel_index].edgeid();
-    const GraphTile* tile = graphreader.GetGraphTile(edgeid);
+    const GraphTile* tile = GetGraphTile(graphreader, shared_tilecache_, edgeid);
     const DirectedEdge* directededge = tile->directededge(edgeid);
 
     // Store the end node if a downward transition to the local level
@@ -89,7 +89,17 @@ std::vector<GraphId> PathAlgorithm::FormLocalPath(const uint32_t dest,
 
       // Recover the path on the local level between this start node and
       // the prior local node
-      if (directededge->shortcut()) {
+      shortcut_edges_.clear();
+      if (directededge->shortcut() && shortcuts_ != nullptr &&
+          shortcuts_->Expand(edgeid, shortcut_edges_) > 0) {
+        // Get the edges on the local level that make up the shortcut from
+        // the shortcut table (add them in reverse order)
+        for (auto it = shortcut_edges_.rbegin(); it != shortcut_edges_.rend();
+             it++) {
+          edgesonpath.push_back(it->first);
+        }
+        prior_local_node = startnode;
+      } else if (directededge->shortcut()) {
         // Recover a set of edges on the local level that make up the shortcut
         prior_local_node = RecoverShortcut(graphreader, startnode,
                                            prior_local_node,
@@ -103,7 +113,7 @@ std::vector<GraphId> PathAlgorithm::FormLocalPath(const uint32_t dest,
         // Get the directed edge on the local level that ends at the
         // prior local node
         uint32_t n = 0;
-        const GraphTile* tile = graphreader.GetGraphTile(startnode);
+        const GraphTile* tile = GetGraphTile(graphreader, shared_tilecache_, startnode);
         const NodeInfo* nodeinfo = tile->node(startnode);
         uint32_t edgeindex = nodeinfo->edge_index();
         directededge = tile->directededge(edgeindex);
@@ -155,12 +165,12 @@ GraphId PathAlgorithm::RecoverShortcut(GraphReader& graphreader,
   }
 
   // Get the end node lat,lng
-  const GraphTile* tile = graphreader.GetGraphTile(endnode);
+  const GraphTile* tile = GetGraphTile(graphreader, shared_tilecache_, endnode);
   const NodeInfo* nodeinfo = tile->node(endnode);
   const PointLL& endll = nodeinfo->latlng();
 
   // Expand from the start node
-  tile = graphreader.GetGraphTile(startnode);
+  tile = GetGraphTile(graphreader, shared_tilecache_, startnode);
   nodeinfo = tile->node(startnode);
   GraphId edgeid(startnode.tileid(), startnode.level(),
                  nodeinfo->edge_index());
@@ -197,7 +207,7 @@ GraphId PathAlgorithm::RecoverShortcut(GraphReader& graphreader,
       found = false;
 
       // Get the nodeinfo and check if we might be on the wrong initial path
-      tile = graphreader.GetGraphTile(connectededge->endnode());
+      tile = GetGraphTile(graphreader, shared_tilecache_, connectededge->endnode());
       nodeinfo = tile->node(connectededge->endnode());
       if (nodeinfo->latlng().Distance(endll) > (shortcutedge->length())) {
         break;
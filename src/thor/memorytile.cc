@@ -0,0 +1,94 @@
+#include "thor/memorytile.h"
+
+using namespace valhalla::baldr;
+
+namespace valhalla {
+namespace thor {
+
+// Constructor - tile over data that is not owned
+MemoryTile::MemoryTile(const char* data, const size_t size)
+    : GraphTile() {
+  if (data == nullptr) {
+    return;
+  }
+
+  // The data is not owned so it is not deleted with the tile
+  graphtile_.reset(const_cast<char*>(data), [](char*) {});
+  Init(size);
+}
+
+// Constructor - tile over data that the tile shares ownership of
+MemoryTile::MemoryTile(const std::shared_ptr<char>& data, const size_t size)
+    : GraphTile() {
+  if (!data) {
+    return;
+  }
+  graphtile_ = data;
+  Init(size);
+}
+
+// Set pointers into the tile data
+void MemoryTile::Init(const size_t size) {
+  if (size < sizeof(GraphTileHeader)) {
+    graphtile_.reset();
+    return;
+  }
+
+  // Set a pointer to the header (first structure in the binary data).
+  char* ptr = graphtile_.get();
+  header_ = reinterpret_cast<GraphTileHeader*>(ptr);
+  if (header_->edgeinfo_offset() > header_->textlist_offset() ||
+      header_->textlist_offset() > size) {
+    header_ = nullptr;
+    graphtile_.reset();
+    return;
+  }
+  ptr += sizeof(GraphTileHeader);
+
+  // Set a pointer to the node list
+  nodes_ = reinterpret_cast<NodeInfo*>(ptr);
+  ptr += header_->nodecount() * sizeof(NodeInfo);
+
+  // Set a pointer to the directed edge list
+  directededges_ = reinterpret_cast<DirectedEdge*>(ptr);
+  ptr += header_->directededgecount() * sizeof(DirectedEdge);
+
+  // Set a pointer to the transit departure list
+  departures_ = reinterpret_cast<TransitDeparture*>(ptr);
+  ptr += header_->departurecount() * sizeof(TransitDeparture);
+
+  // Set a pointer to the transit trip list
+  transit_trips_ = reinterpret_cast<TransitTrip*>(ptr);
+  ptr += header_->tripcount() * sizeof(TransitTrip);
+
+  // Set a pointer to the transit stop list
+  transit_stops_ = reinterpret_cast<TransitStop*>(ptr);
+  ptr += header_->stopcount() * sizeof(TransitStop);
+
+  // Set a pointer to the transit route list
+  transit_routes_ = reinterpret_cast<TransitRoute*>(ptr);
+  ptr += header_->routecount() * sizeof(TransitRoute);
+
+  // Set a pointer to the transit transfer list
+  transit_transfers_ = reinterpret_cast<TransitTransfer*>(ptr);
+  ptr += header_->transfercount() * sizeof(TransitTransfer);
+
+  // Set a pointer to the sign list
+  signs_ = reinterpret_cast<Sign*>(ptr);
+  ptr += header_->signcount() * sizeof(Sign);
+
+  // Set a pointer to the administrative information
+  admins_ = reinterpret_cast<Admin*>(ptr);
+
+  // Start of edge information and name list
+  edgeinfo_ = graphtile_.get() + header_->edgeinfo_offset();
+  edgeinfo_size_ = header_->textlist_offset() - header_->edgeinfo_offset();
+  textlist_ = graphtile_.get() + header_->textlist_offset();
+  textlist_size_ = size - header_->textlist_offset();
+
+  // Set the size to indicate success
+  size_ = size;
+}
+
+}
+}
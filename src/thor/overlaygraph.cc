@@ -0,0 +1,75 @@
+#include "thor/overlaygraph.h"
+
+#include <valhalla/midgard/logging.h>
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+OverlayGraph::OverlayGraph()
+    : graph_(nullptr),
+      partition_(nullptr) {
+}
+
+// Build the overlay of a partitioned graph
+void OverlayGraph::Build(const RoutingGraph& graph,
+                         const Partition& partition) {
+  graph_ = &graph;
+  partition_ = &partition;
+  levels_.assign(partition.levels(), Level());
+  for (uint32_t l = 0; l < partition.levels(); l++) {
+    Level& level = levels_[l];
+    uint32_t cellcount = partition.cellcount(l);
+    level.entry_offsets.assign(cellcount + 1, 0);
+    level.exit_offsets.assign(cellcount + 1, 0);
+    level.entry_index.assign(graph.edgecount(), RoutingGraph::kInvalidNode);
+    level.exit_index.assign(graph.edgecount(), RoutingGraph::kInvalidNode);
+
+    // Count the edges crossing cell boundaries (entries of the end node's
+    // cell and exits of the start node's cell). Transition edges never
+    // cross a boundary.
+    for (uint32_t node = 0; node < graph.nodecount(); node++) {
+      uint32_t cell = partition.cell(l, node);
+      for (uint32_t e = graph.edge_index(node); e < graph.edge_index(node + 1); e++) {
+        const RoutingEdge& edge = graph.edge(e);
+        if (edge.is_shortcut || edge.endnode == RoutingGraph::kInvalidNode) {
+          continue;
+        }
+        uint32_t endcell = partition.cell(l, edge.endnode);
+        if (endcell != cell) {
+          level.entry_index[e] = level.entry_offsets[endcell + 1]++;
+          level.exit_index[e] = level.exit_offsets[cell + 1]++;
+        }
+      }
+    }
+
+    // Form the entry and exit lists of each cell and the clique offsets
+    level.clique_offsets.assign(cellcount + 1, 0);
+    for (uint32_t cell = 0; cell < cellcount; cell++) {
+      level.clique_offsets[cell + 1] = level.clique_offsets[cell] +
+          static_cast<uint64_t>(level.entry_offsets[cell + 1]) *
+          level.exit_offsets[cell + 1];
+      level.entry_offsets[cell + 1] += level.entry_offsets[cell];
+      level.exit_offsets[cell + 1] += level.exit_offsets[cell];
+    }
+    level.entries.resize(level.entry_offsets[cellcount]);
+    level.exits.resize(level.exit_offsets[cellcount]);
+    for (uint32_t node = 0; node < graph.nodecount(); node++) {
+      uint32_t cell = partition.cell(l, node);
+      for (uint32_t e = graph.edge_index(node); e < graph.edge_index(node + 1); e++) {
+        if (level.entry_index[e] != RoutingGraph::kInvalidNode) {
+          uint32_t endcell = partition.cell(l, graph.edge(e).endnode);
+          level.entries[level.entry_offsets[endcell] + level.entry_index[e]] = e;
+          level.exits[level.exit_offsets[cell] + level.exit_index[e]] = e;
+        }
+      }
+    }
+    LOG_INFO("Overlay level " + std::to_string(l) + ": " +
+             std::to_string(cellcount) + " cells, " +
+             std::to_string(level.entries.size()) + " boundary edges, " +
+             std::to_string(level.clique_offsets[cellcount]) + " clique arcs");
+  }
+}
+
+}
+}
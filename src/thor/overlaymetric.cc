@@ -0,0 +1,306 @@
+#include "thor/overlaymetric.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+
+#include <valhalla/midgard/logging.h>
+#include <valhalla/sif/edgelabel.h>
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace valhalla {
+namespace thor {
+
+constexpr float OverlayMetric::kUnreachable;
+
+namespace {
+
+// Priority queue of (cost, item) with the lowest cost on top
+using CostQueue = std::priority_queue<std::pair<float, uint32_t>,
+                                      std::vector<std::pair<float, uint32_t>>,
+                                      std::greater<std::pair<float, uint32_t>>>;
+
+// Search of the routing graph inside a cell from an entry edge. This is
+// the expansion of the routing graph search without hierarchy limits or
+// shortcuts. Exits of the cell are labeled but not expanded.
+class GraphCellSearch {
+ public:
+  // Search from the entry until the target edge is settled (or the whole
+  // cell if the target is kInvalidNode)
+  void Run(const OverlayGraph& overlay, const DynamicCost& costing,
+           const uint32_t level, const uint32_t entry, const uint32_t target) {
+    const RoutingGraph& graph = overlay.graph();
+    const Partition& partition = overlay.partition();
+    uint32_t cell = partition.cell(level, graph.edge(entry).endnode);
+    mode_ = costing.travelmode();
+    labels_.clear();
+    label_edges_.clear();
+    label_index_.clear();
+    done_.clear();
+    queue_ = CostQueue();
+    const DirectedEdge* directededge = graph.directededge(entry);
+    Relax(entry, EdgeLabel(kInvalidLabel, graph.edgeid(entry), directededge,
+                           Cost(0.0f, 0.0f), 0.0f, 0.0f,
+                           directededge->restrictions(),
+                           directededge->opp_local_idx(), mode_, 0));
+    while (!queue_.empty()) {
+      uint32_t predindex = queue_.top().second;
+      queue_.pop();
+      if (done_[predindex]) {
+        continue;
+      }
+      done_[predindex] = true;
+      uint32_t prededge = label_edges_[predindex];
+      uint32_t node = graph.edge(prededge).endnode;
+      if (prededge == target) {
+        return;
+      }
+      if (partition.cell(level, node) != cell) {
+        continue;
+      }
+      const NodeInfo* nodeinfo = graph.nodeinfo(node);
+      if (!costing.Allowed(nodeinfo)) {
+        continue;
+      }
+
+      // Expand from the end node (transition edges keep the predecessor's
+      // cost and turn information)
+      const EdgeLabel pred = labels_[predindex];
+      for (uint32_t e = graph.edge_index(node); e < graph.edge_index(node + 1); e++) {
+        const RoutingEdge& edge = graph.edge(e);
+        if (edge.is_shortcut || edge.endnode == RoutingGraph::kInvalidNode) {
+          continue;
+        }
+        directededge = graph.directededge(e);
+        if (edge.trans_up || edge.trans_down) {
+          Relax(e, EdgeLabel(predindex, graph.edgeid(e), directededge,
+                             pred.cost(), 0.0f, 0.0f, pred.restrictions(),
+                             pred.opp_local_idx(), mode_, 0));
+          continue;
+        }
+        if (!costing.Allowed(directededge, pred)) {
+          continue;
+        }
+        Cost newcost = pred.cost() +
+                       costing.EdgeCost(directededge, nodeinfo->density()) +
+                       costing.TransitionCost(directededge, nodeinfo, pred);
+        Relax(e, EdgeLabel(predindex, graph.edgeid(e), directededge, newcost,
+                           0.0f, 0.0f, directededge->restrictions(),
+                           directededge->opp_local_idx(), mode_, 0));
+      }
+    }
+  }
+
+  // Cost of an edge (kUnreachable if not reached)
+  Cost cost(const uint32_t edge) const {
+    auto it = label_index_.find(edge);
+    return (it == label_index_.end()) ?
+        Cost(OverlayMetric::kUnreachable, OverlayMetric::kUnreachable) :
+        labels_[it->second].cost();
+  }
+
+  // Edges from the entry (excluded) to an edge with their costs
+  bool Path(const uint32_t edge,
+            std::vector<std::pair<uint32_t, Cost>>& edges) const {
+    auto it = label_index_.find(edge);
+    if (it == label_index_.end()) {
+      return false;
+    }
+    edges.clear();
+    for (uint32_t index = it->second; labels_[index].predecessor() != kInvalidLabel;
+         index = labels_[index].predecessor()) {
+      edges.emplace_back(label_edges_[index], labels_[index].cost());
+    }
+    std::reverse(edges.begin(), edges.end());
+    return true;
+  }
+
+ protected:
+  // Add a label for an edge or lower the cost of its label
+  void Relax(const uint32_t edge, const EdgeLabel& label) {
+    auto it = label_index_.find(edge);
+    if (it == label_index_.end()) {
+      label_index_.emplace(edge, labels_.size());
+      queue_.emplace(label.cost().cost, labels_.size());
+      labels_.push_back(label);
+      label_edges_.push_back(edge);
+      done_.push_back(false);
+    } else if (!done_[it->second] &&
+               label.cost().cost < labels_[it->second].cost().cost) {
+      labels_[it->second] = label;
+      queue_.emplace(label.cost().cost, it->second);
+    }
+  }
+
+  TravelMode mode_;
+  std::vector<EdgeLabel> labels_;
+  std::vector<uint32_t> label_edges_;
+  std::unordered_map<uint32_t, uint32_t> label_index_;
+  std::vector<bool> done_;
+  CostQueue queue_;
+};
+
+// Search of the cliques of the level below inside a cell from an entry
+// edge. The states are the boundary edges of the level below.
+class OverlayCellSearch {
+ public:
+  void Run(const OverlayGraph& overlay, const std::vector<Cost>& cliques,
+           const uint32_t level, const uint32_t entry) {
+    const RoutingGraph& graph = overlay.graph();
+    const Partition& partition = overlay.partition();
+    states_.clear();
+    queue_ = CostQueue();
+    states_.emplace(entry, State{Cost(0.0f, 0.0f), false});
+    queue_.emplace(0.0f, entry);
+    while (!queue_.empty()) {
+      uint32_t edge = queue_.top().second;
+      queue_.pop();
+      State& state = states_[edge];
+      if (state.done) {
+        continue;
+      }
+      state.done = true;
+
+      // Exits of the cell are not expanded
+      if (edge != entry &&
+          overlay.exit_index(level, edge) != RoutingGraph::kInvalidNode) {
+        continue;
+      }
+
+      // Follow the clique of the cell (of the level below) the edge enters
+      uint32_t sub = partition.cell(level - 1, graph.edge(edge).endnode);
+      uint32_t count = overlay.exit_count(level - 1, sub);
+      const uint32_t* exits = overlay.exits(level - 1, sub);
+      const Cost* row = &cliques[overlay.clique_offset(level - 1, sub) +
+          static_cast<uint64_t>(overlay.entry_index(level - 1, edge)) * count];
+      Cost cost = state.cost;
+      for (uint32_t j = 0; j < count; j++) {
+        if (row[j].cost == OverlayMetric::kUnreachable) {
+          continue;
+        }
+        Cost newcost = cost + row[j];
+        auto it = states_.find(exits[j]);
+        if (it == states_.end()) {
+          states_.emplace(exits[j], State{newcost, false});
+          queue_.emplace(newcost.cost, exits[j]);
+        } else if (!it->second.done && newcost.cost < it->second.cost.cost) {
+          it->second.cost = newcost;
+          queue_.emplace(newcost.cost, exits[j]);
+        }
+      }
+    }
+  }
+
+  // Cost of an edge (kUnreachable if not reached)
+  Cost cost(const uint32_t edge) const {
+    auto it = states_.find(edge);
+    return (it == states_.end()) ?
+        Cost(OverlayMetric::kUnreachable, OverlayMetric::kUnreachable) :
+        it->second.cost;
+  }
+
+ protected:
+  struct State {
+    Cost cost;
+    bool done;
+  };
+  std::unordered_map<uint32_t, State> states_;
+  CostQueue queue_;
+};
+
+}
+
+// Constructor
+OverlayMetric::OverlayMetric()
+    : fingerprint_(0) {
+}
+
+// Customize the overlay for a costing
+void OverlayMetric::Customize(const OverlayGraph& overlay,
+                              const std::shared_ptr<DynamicCost>& costing,
+                              const uint64_t fingerprint,
+                              const uint32_t threads) {
+  if (fingerprint_ != 0 && fingerprint == fingerprint_ &&
+      costs_.size() == overlay.levels()) {
+    return;
+  }
+
+  // Levels are customized bottom up, the cells of each level in parallel
+  auto t1 = std::chrono::high_resolution_clock::now();
+  costs_.resize(overlay.levels());
+  for (uint32_t level = 0; level < overlay.levels(); level++) {
+    uint32_t cellcount = overlay.partition().cellcount(level);
+    costs_[level].assign(overlay.clique_offset(level, cellcount),
+                         Cost(kUnreachable, kUnreachable));
+    std::atomic<uint32_t> next(0);
+    std::vector<std::thread> workers;
+    for (uint32_t i = 1; i < std::min(threads, cellcount); i++) {
+      workers.emplace_back(&OverlayMetric::CustomizeCells, this,
+                           std::cref(overlay), std::cref(*costing), level,
+                           &next);
+    }
+    CustomizeCells(overlay, *costing, level, &next);
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+  fingerprint_ = fingerprint;
+  auto t2 = std::chrono::high_resolution_clock::now();
+  LOG_INFO("Customized overlay in " + std::to_string(
+      std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count()) +
+      " ms");
+}
+
+// Get the fingerprint the metric is customized for
+uint64_t OverlayMetric::fingerprint() const {
+  return fingerprint_;
+}
+
+// Customize the cells of a level
+void OverlayMetric::CustomizeCells(const OverlayGraph& overlay,
+                                   const DynamicCost& costing,
+                                   const uint32_t level,
+                                   std::atomic<uint32_t>* next) {
+  GraphCellSearch graphsearch;
+  OverlayCellSearch overlaysearch;
+  uint32_t cellcount = overlay.partition().cellcount(level);
+  for (uint32_t cell = (*next)++; cell < cellcount; cell = (*next)++) {
+    uint32_t entry_count = overlay.entry_count(level, cell);
+    uint32_t exit_count = overlay.exit_count(level, cell);
+    const uint32_t* entries = overlay.entries(level, cell);
+    const uint32_t* exits = overlay.exits(level, cell);
+    Cost* clique = &costs_[level][overlay.clique_offset(level, cell)];
+    for (uint32_t i = 0; i < entry_count; i++, clique += exit_count) {
+      if (level == 0) {
+        graphsearch.Run(overlay, costing, level, entries[i],
+                        RoutingGraph::kInvalidNode);
+        for (uint32_t j = 0; j < exit_count; j++) {
+          clique[j] = graphsearch.cost(exits[j]);
+        }
+      } else {
+        overlaysearch.Run(overlay, costs_[level - 1], level, entries[i]);
+        for (uint32_t j = 0; j < exit_count; j++) {
+          clique[j] = overlaysearch.cost(exits[j]);
+        }
+      }
+    }
+  }
+}
+
+// Unpack a clique arc into the edges of the routing graph
+bool OverlayMetric::Unpack(const OverlayGraph& overlay,
+                           const DynamicCost& costing, const uint32_t level,
+                           const uint32_t entry, const uint32_t exit,
+                           std::vector<std::pair<uint32_t, Cost>>& edges) const {
+  GraphCellSearch search;
+  search.Run(overlay, costing, level, entry, exit);
+  return search.Path(exit, edges);
+}
+
+}
+}
@@ -0,0 +1,181 @@
+#include "thor/partition.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <valhalla/midgard/logging.h>
+
+using namespace valhalla::midgard;
+
+namespace valhalla {
+namespace thor {
+
+constexpr uint32_t Partition::kPartitionVersion;
+
+namespace {
+
+// Snapshot section tags
+constexpr uint32_t kPartitionHeaderTag = SnapshotTag("PTHD");
+constexpr uint32_t kCellSizesTag       = SnapshotTag("PTSZ");
+constexpr uint32_t kCellCountsTag      = SnapshotTag("PTCC");
+constexpr uint32_t kCellsTag           = SnapshotTag("PTCL");
+
+// Find the root of a node in the union-find forest (halving the path)
+uint32_t Root(std::vector<uint32_t>& parent, uint32_t node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
+  }
+  return node;
+}
+
+// Copy an array section into a vector, checking its size
+bool CopySection(const Snapshot& snapshot, const uint32_t tag,
+                 const size_t count, std::vector<uint32_t>& array) {
+  size_t size = 0;
+  const char* data = snapshot.Section(tag, size);
+  if (data == nullptr || size != count * sizeof(uint32_t)) {
+    return false;
+  }
+  const uint32_t* values = reinterpret_cast<const uint32_t*>(data);
+  array.assign(values, values + count);
+  return true;
+}
+
+}
+
+// Constructor
+Partition::Partition()
+    : nodecount_(0) {
+}
+
+// Partition the nodes of a graph
+void Partition::Build(const RoutingGraph& graph,
+                      const std::vector<uint32_t>& cell_sizes) {
+  nodecount_ = graph.nodecount();
+  cell_sizes_ = cell_sizes;
+  cell_counts_.assign(cell_sizes_.size(), 0);
+  cells_.assign(cell_sizes_.size() * nodecount_, 0);
+  if (cell_sizes_.empty() || nodecount_ == 0) {
+    return;
+  }
+
+  // Group nodes connected by transition edges into locations
+  std::vector<uint32_t> parent(nodecount_);
+  std::iota(parent.begin(), parent.end(), 0);
+  for (uint32_t node = 0; node < nodecount_; node++) {
+    for (uint32_t e = graph.edge_index(node); e < graph.edge_index(node + 1); e++) {
+      const RoutingEdge& edge = graph.edge(e);
+      if ((edge.trans_up || edge.trans_down) &&
+          edge.endnode != RoutingGraph::kInvalidNode) {
+        parent[Root(parent, edge.endnode)] = Root(parent, node);
+      }
+    }
+  }
+  std::vector<uint32_t> node_locs(nodecount_, RoutingGraph::kInvalidNode);
+  std::vector<PointLL> lls;
+  for (uint32_t node = 0; node < nodecount_; node++) {
+    uint32_t root = Root(parent, node);
+    if (node_locs[root] == RoutingGraph::kInvalidNode) {
+      node_locs[root] = lls.size();
+      lls.push_back(graph.latlng(root));
+    }
+    node_locs[node] = node_locs[root];
+  }
+
+  // Split the locations into cells from the top level down
+  std::vector<uint32_t> locs(lls.size());
+  std::iota(locs.begin(), locs.end(), 0);
+  std::vector<uint32_t> loc_cells(cell_sizes_.size() * lls.size());
+  Split(lls, locs, 0, locs.size(), cell_sizes_.size() - 1, loc_cells);
+  for (uint32_t level = 0; level < cell_sizes_.size(); level++) {
+    for (uint32_t node = 0; node < nodecount_; node++) {
+      cells_[static_cast<size_t>(level) * nodecount_ + node] =
+          loc_cells[static_cast<size_t>(level) * lls.size() + node_locs[node]];
+    }
+    LOG_INFO("Partition level " + std::to_string(level) + ": " +
+             std::to_string(cell_counts_[level]) + " cells");
+  }
+}
+
+// Split a range of locations into cells of a level and the levels below
+void Partition::Split(const std::vector<PointLL>& lls,
+                      std::vector<uint32_t>& locs, const uint32_t begin,
+                      const uint32_t end, const uint32_t level,
+                      std::vector<uint32_t>& loc_cells) {
+  // Bisect at the median of the longer side of the bounding box
+  if (end - begin > cell_sizes_[level]) {
+    float minx = lls[locs[begin]].lng(), maxx = minx;
+    float miny = lls[locs[begin]].lat(), maxy = miny;
+    for (uint32_t i = begin + 1; i < end; i++) {
+      const PointLL& ll = lls[locs[i]];
+      minx = std::min(minx, ll.lng());
+      maxx = std::max(maxx, ll.lng());
+      miny = std::min(miny, ll.lat());
+      maxy = std::max(maxy, ll.lat());
+    }
+    bool by_lng = (maxx - minx) >= (maxy - miny);
+    uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(locs.begin() + begin, locs.begin() + mid,
+                     locs.begin() + end,
+                     [&lls, by_lng](const uint32_t a, const uint32_t b) {
+                       return by_lng ? lls[a].lng() < lls[b].lng() :
+                                       lls[a].lat() < lls[b].lat();
+                     });
+    Split(lls, locs, begin, mid, level, loc_cells);
+    Split(lls, locs, mid, end, level, loc_cells);
+    return;
+  }
+
+  // The range is a cell of this level. Split it into cells of the level
+  // below.
+  uint32_t cell = cell_counts_[level]++;
+  for (uint32_t i = begin; i < end; i++) {
+    loc_cells[static_cast<size_t>(level) * lls.size() + locs[i]] = cell;
+  }
+  if (level > 0) {
+    Split(lls, locs, begin, end, level - 1, loc_cells);
+  }
+}
+
+// Add the partition to a snapshot
+void Partition::Write(SnapshotWriter& writer) const {
+  header_.version = kPartitionVersion;
+  header_.levels = cell_sizes_.size();
+  header_.nodecount = nodecount_;
+  header_.spare = 0;
+  writer.Add(kPartitionHeaderTag, &header_, sizeof(header_));
+  writer.Add(kCellSizesTag, cell_sizes_);
+  writer.Add(kCellCountsTag, cell_counts_);
+  writer.Add(kCellsTag, cells_);
+}
+
+// Load the partition from a snapshot
+bool Partition::Load(const Snapshot& snapshot, const uint32_t nodecount) {
+  size_t size = 0;
+  const char* data = snapshot.Section(kPartitionHeaderTag, size);
+  if (data == nullptr || size != sizeof(Header)) {
+    LOG_INFO("Snapshot has no partition");
+    return false;
+  }
+  const Header* header = reinterpret_cast<const Header*>(data);
+  if (header->version != kPartitionVersion || header->nodecount != nodecount) {
+    LOG_ERROR("Snapshot partition has a different version or graph");
+    return false;
+  }
+  nodecount_ = nodecount;
+  if (!CopySection(snapshot, kCellSizesTag, header->levels, cell_sizes_) ||
+      !CopySection(snapshot, kCellCountsTag, header->levels, cell_counts_) ||
+      !CopySection(snapshot, kCellsTag,
+                   static_cast<size_t>(header->levels) * nodecount, cells_)) {
+    LOG_ERROR("Snapshot partition is invalid");
+    cell_sizes_.clear();
+    cell_counts_.clear();
+    cells_.clear();
+    return false;
+  }
+  return true;
+}
+
+}
+}
@@ -16,12 +16,23 @@ namespace {
 constexpr uint32_t kBucketCount = 20000;
 constexpr uint64_t kInitialEdgeLabelCount = 500000;
 
+// Number of expansions between updates of the tile prefetcher
+constexpr uint32_t kPrefetchInterval = 1024;
+
+// Anytime search: number of expansions between deadline checks, factor
+// epsilon is lowered by after each iteration and the epsilon below which
+// the next iteration is the unweighted search
+constexpr uint32_t kDeadlineInterval = 256;
+constexpr float kAnytimeEpsilonFactor = 0.5f;
+constexpr float kAnytimeMinEpsilon = 0.02f;
+
 // If the destination is at a node we want the incoming edge Ids
 // with distance = 1.0 (the full edge). This returns and updated
 // destination PathLocation.
 // TODO - move this logic into Loki
 // TODO - fail the route if no dest edges
 PathLocation update_destinations(GraphReader& graphreader,
+                                 valhalla::thor::TileCache* tilecache,
                                  const PathLocation& destination,
                                  const EdgeFilter& filter) {
   if (destination.IsNode()) {
@@ -32,14 +43,17 @@ PathLocation update_destinations(GraphReader& graphreader,
     // Get the node. Iterate through the edges and get opposing edges. Add
     // to the destination edges if it is allowed by the costing model
     GraphId destedge = destination.edges()[0].id;
-    GraphId opposing_edge = graphreader.GetOpposingEdgeId(destedge);
-    GraphId endnode = graphreader.GetGraphTile(opposing_edge)->directededge(opposing_edge)->endnode();
-    const GraphTile* tile = graphreader.GetGraphTile(endnode);
+    GraphId opposing_edge = valhalla::thor::GetOpposingEdgeId(graphreader,
+                                  tilecache, destedge);
+    GraphId endnode = valhalla::thor::GetGraphTile(graphreader, tilecache,
+                          opposing_edge)->directededge(opposing_edge)->endnode();
+    const GraphTile* tile = valhalla::thor::GetGraphTile(graphreader, tilecache, endnode);
     const NodeInfo* nodeinfo = tile->node(endnode);
     GraphId edgeid(endnode.tileid(), endnode.level(), nodeinfo->edge_index());
     for (uint32_t i = 0; i < nodeinfo->edge_count(); i++, edgeid++) {
-      GraphId opposing_edge = graphreader.GetOpposingEdgeId(edgeid);
-      tile = graphreader.GetGraphTile(opposing_edge);
+      GraphId opposing_edge = valhalla::thor::GetOpposingEdgeId(graphreader,
+                                    tilecache, edgeid);
+      tile = valhalla::thor::GetGraphTile(graphreader, tilecache, opposing_edge);
       const DirectedEdge* edge = tile->directededge(opposing_edge);
       if (!filter(edge)) {
         dest.CorrelateEdge(PathLocation::PathEdge{opposing_edge, 1.0f});
@@ -69,6 +83,17 @@ GraphId trivial(const PathLocation& origin, const PathLocation& destination) {
   return {};
 }
 
+// Distance along an edge (fraction of its length) of a location on it
+// (0 if the location is not on the edge)
+float edge_dist(const PathLocation& location, const GraphId& edgeid) {
+  for (const auto& edge : location.edges()) {
+    if (edge.id == edgeid) {
+      return edge.dist;
+    }
+  }
+  return 0.0f;
+}
+
 GraphId loop(const PathLocation& origin, const PathLocation& destination) {
   //if we end up with locations where there is a trivial path but you would have to
   //traverse the edge in reverse to do it we need to mark this as a loop so that
@@ -88,24 +113,110 @@ GraphId loop(const PathLocation& origin, const PathLocation& destination) {
   return {};
 }
 
+// Costs of the edges expanded by a routing graph search. The customized
+// tables used are template parameters so each combination of tables has its
+// own instantiation of the search kernel: edge and transition costs from a
+// table are inlined lookups rather than calls through DynamicCost. Origin
+// edges have no transition cost row and use the costing.
+template <bool edge_table, bool transition_table>
+class GraphCosts {
+ public:
+  GraphCosts(const valhalla::thor::RoutingGraph& graph, const DynamicCost& cost,
+             valhalla::thor::EdgeCostTable* edgecosts,
+             valhalla::thor::TransitionCostTable* transitioncosts)
+      : graph_(graph),
+        cost_(cost),
+        edgecosts_(edgecosts),
+        transitioncosts_(transitioncosts),
+        nodeinfo_(nullptr),
+        first_edge_(0),
+        transitions_(nullptr) {
+  }
+
+  // Set the node whose edges are expanded and the predecessor edge
+  void SetNode(const uint32_t node, const NodeInfo* nodeinfo,
+               const uint32_t prededge, const EdgeLabel& pred) {
+    nodeinfo_ = nodeinfo;
+    first_edge_ = graph_.edge_index(node);
+    transitions_ = (transition_table && pred.predecessor() != kInvalidLabel) ?
+        transitioncosts_->Row(node, prededge, pred.opp_local_idx(), graph_, cost_) :
+        nullptr;
+  }
+
+  // Get the cost of an edge leaving the node (edge and transition cost)
+  Cost Get(const uint32_t edge, const DirectedEdge* directededge,
+           const EdgeLabel& pred) {
+    uint32_t density = nodeinfo_->density();
+    return (edge_table ? edgecosts_->Get(edge, directededge, density, cost_) :
+                         cost_.EdgeCost(directededge, density)) +
+           ((transition_table && transitions_ != nullptr) ?
+              transitions_[edge - first_edge_] :
+              cost_.TransitionCost(directededge, nodeinfo_, pred));
+  }
+
+ protected:
+  const valhalla::thor::RoutingGraph& graph_;
+  const DynamicCost& cost_;
+  valhalla::thor::EdgeCostTable* edgecosts_;
+  valhalla::thor::TransitionCostTable* transitioncosts_;
+  const NodeInfo* nodeinfo_;
+  uint32_t first_edge_;
+  const Cost* transitions_;
+};
+
+// Get the start node of an edge of a routing graph (the last node whose
+// edges start at or before the edge)
+uint32_t start_node(const valhalla::thor::RoutingGraph& graph,
+                    const uint32_t edge) {
+  uint32_t lo = 0, hi = graph.nodecount();
+  while (hi - lo > 1) {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (graph.edge_index(mid) <= edge) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
 }
 
 namespace valhalla {
 namespace thor {
 
+constexpr uint8_t PathAlgorithm::kGraphArc;
+constexpr uint32_t PathAlgorithm::kUnsettled;
+
 // Default constructor
 PathAlgorithm::PathAlgorithm()
     : allow_transitions_(false),
+      epsilon_(0.0f),
       edgelabel_index_(0),
       adjacencylist_(nullptr),
       edgestatus_(nullptr),
-      best_destination_{kInvalidLabel, Cost(std::numeric_limits<float>::max(), 0.0f)} {
+      shared_tilecache_(nullptr),
+      shared_tilecache_reader_(0),
+      expansions_(0),
+      cost_bound_(std::numeric_limits<float>::max()),
+      pruned_(0),
+      coarse_(false),
+      corridor_(nullptr),
+      cost_only_(false),
+      prefetcher_(nullptr),
+      shortcuts_(nullptr),
+      warm_start_max_labels_(0),
+      warm_start_key_(0),
+      warm_start_epsilon_(0.0f),
+      best_destination_{kInvalidLabel, Cost(std::numeric_limits<float>::max(), 0.0f)},
+      iteration_(0) {
   edgelabels_.reserve(kInitialEdgeLabelCount);
 }
 
 // Destructor
 PathAlgorithm::~PathAlgorithm() {
   Clear();
+  SetTileCache(nullptr);
 }
 
 // Clear the temporary information generated during path construction.
@@ -116,6 +227,14 @@ void PathAlgorithm::Clear() {
   best_destination_ = std::make_pair(kInvalidLabel,
                          Cost(std::numeric_limits<float>::max(), 0.0f));
   destinations_.clear();
+  tilecache_.Clear();
+  expansions_ = 0;
+  pruned_ = 0;
+  warm_start_key_ = 0;
+  deferred_.clear();
+  reroute_edges_.clear();
+  graph_label_edges_.clear();
+  overlay_label_levels_.clear();
 
   // Clear elements from the adjacency list
   if(adjacencylist_ != nullptr) {
@@ -130,6 +249,58 @@ void PathAlgorithm::Clear() {
   }
 }
 
+// Get statistics about the most recent search
+SearchStats PathAlgorithm::stats() const {
+  SearchStats stats;
+  stats.expansions   = expansions_;
+  stats.labels       = edgelabel_index_;
+  stats.pruned       = pruned_;
+  stats.tile_lookups = tilecache_.lookups();
+  stats.tile_reads   = tilecache_.reads();
+  stats.path_cost    = (best_destination_.first == kInvalidLabel) ? 0.0f :
+                       best_destination_.second.cost;
+  return stats;
+}
+
+// Set the tile prefetcher
+void PathAlgorithm::SetPrefetcher(TilePrefetcher* prefetcher) {
+  prefetcher_ = prefetcher;
+}
+
+// Set the shortcut table
+void PathAlgorithm::SetShortcutTable(const ShortcutTable* shortcuts) {
+  shortcuts_ = shortcuts;
+}
+
+// Set the shared tile cache. The reader Id on a previous cache is
+// released, and setting the same cache again keeps the reader Id.
+void PathAlgorithm::SetTileCache(TileCache* tilecache) {
+  if (tilecache == shared_tilecache_) {
+    return;
+  }
+  if (shared_tilecache_ != nullptr) {
+    shared_tilecache_->ReleaseReader(shared_tilecache_reader_);
+  }
+  shared_tilecache_ = tilecache;
+  shared_tilecache_reader_ = (shared_tilecache_ != nullptr) ?
+      shared_tilecache_->RegisterReader() : 0;
+}
+
+// Set the tile manifest
+void PathAlgorithm::SetTileManifest(TileManifest* manifest) {
+  tilecache_.SetManifest(manifest);
+}
+
+// Enable warm start
+void PathAlgorithm::SetWarmStart(const uint32_t max_labels) {
+  warm_start_max_labels_ = max_labels;
+}
+
+// Set the suboptimality allowed (weight of the A* heuristic)
+void PathAlgorithm::SetEpsilon(const float epsilon) {
+  epsilon_ = std::max(epsilon, 0.0f);
+}
+
 // Initialize prior to finding best path
 void PathAlgorithm::Init(const PointLL& origll, const PointLL& destll,
     const std::shared_ptr<DynamicCost>& costing, const bool multimodal) {
@@ -141,8 +312,9 @@ void PathAlgorithm::Init(const PointLL& origll, const PointLL& destll,
     // Disable A* for multimodal
     astarheuristic_.Init(destll, 0.0f);
   } else {
-    // Set the destination and cost factor in the A* heuristic
-    astarheuristic_.Init(destll, costing->AStarCostFactor());
+    // Set the destination and cost factor in the A* heuristic (weighted
+    // for a faster, suboptimal search if epsilon is set)
+    astarheuristic_.Init(destll, costing->AStarCostFactor() * (1.0f + epsilon_));
 
     // Get the initial cost based on A* heuristic from origin
     mincost = astarheuristic_.Get(origll);
@@ -159,15 +331,27 @@ void PathAlgorithm::Init(const PointLL& origll, const PointLL& destll,
   // transition counts (i.e., this is not a const reference).
   allow_transitions_ = costing->AllowTransitions();
   hierarchy_limits_  = costing->GetHierarchyLimits();
+
+  // A coarse route stops expanding the arterial and local levels once the
+  // search has transitioned up from them
+  if (coarse_) {
+    for (uint32_t level = 1; level < hierarchy_limits_.size(); level++) {
+      hierarchy_limits_[level].max_up_transitions = 0;
+    }
+  }
 }
 
 // Calculate best path.
 std::vector<PathInfo> PathAlgorithm::GetBestPath(const PathLocation& origin,
              const PathLocation& destination, GraphReader& graphreader,
-             const std::shared_ptr<DynamicCost>& costing) {
+             const std::shared_ptr<DynamicCost>& costing,
+             const uint64_t warm_start_key, const float cost_bound) {
+  // Tiles from the shared cache must remain valid during the search
+  TileCacheReadGuard guard(shared_tilecache_, shared_tilecache_reader_);
+
   // Alter the destination edges if at a node - loki always gives edges
   // leaving a node, but when a destination we want edges entering the node
-  PathLocation dest = update_destinations(graphreader, destination,
+  PathLocation dest = update_destinations(graphreader, shared_tilecache_, destination,
                                           costing->GetFilter());
 
   // Check for trivial path
@@ -183,13 +367,227 @@ std::vector<PathInfo> PathAlgorithm::GetBestPath(const PathLocation& origin,
   // Check for loop path
   PathInfo loop_edge_info(mode_, 0.0f, loop(origin, dest), 0);
 
-  // Initialize - create adjacency list, edgestatus support, A*, etc.
-  Init(origin.vertex(), dest.vertex(), costing, false);
+  // Reuse the search tree retained from the prior route if possible. Trees
+  // of bounded searches lack the pruned edges so are not reused.
+  cost_bound_ = cost_bound;
+  bool warm_start = CanWarmStart(origin,
+      (cost_bound < std::numeric_limits<float>::max()) ? 0 : warm_start_key,
+      loop_edge_info);
+
+  // Run the search
+  std::vector<PathInfo> path = AStar(origin, dest, graphreader, costing,
+                                     loop_edge_info, warm_start);
+
+  // Do not reuse the search tree of a failed search
+  if (path.empty()) {
+    warm_start_key_ = 0;
+  }
+  return path;
+}
+
+// Get the cost bound labels are pruned with. Labels of destination edges
+// end past the destination, where the heuristic does not bound the cost,
+// so the bound is widened by the cost of those edges.
+float PathAlgorithm::PruneCost(const PathLocation& dest,
+                               const DynamicCost& cost) {
+  float prune_cost = cost_bound_;
+  if (prune_cost < std::numeric_limits<float>::max()) {
+    float margin = 0.0f;
+    for (const auto& edge : dest.edges()) {
+      const GraphTile* desttile = tilecache_.Get(edge.id);
+      if (desttile != nullptr) {
+        margin = std::max(margin, cost.EdgeCost(
+                     desttile->directededge(edge.id), 0.0f).cost);
+      }
+    }
+    prune_cost += margin;
+  }
+  return prune_cost;
+}
+
+// Expand the edges leaving the end node of a settled label.
+template <bool anytime>
+void PathAlgorithm::Expand(const uint32_t predindex, const EdgeLabel& pred,
+                           const GraphTile* tile, const NodeInfo* nodeinfo,
+                           const DynamicCost& cost, const float prune_cost,
+                           const float heuristic_scale) {
+  const bool pedestrian = (mode_ == TravelMode::kPedestrian);
+  const GraphId node = pred.endnode();
+  const float dist2dest = pred.distance();
+  uint32_t shortcuts = 0;
+  candidates_.clear();
+  candidate_lls_.clear();
+  GraphId edgeid(node.tileid(), node.level(), nodeinfo->edge_index());
+  const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
+  for (uint32_t i = 0, n = nodeinfo->edge_count(); i < n;
+              i++, directededge++, edgeid++) {
+    // Transition edges either get skipped or added to the adjacency list
+    // using the predecessor info. Queue them with the other candidates so
+    // labels are added in edge order (they need no A* heuristic). Anytime
+    // searches first check if they are labeled (they may be searched again).
+    bool transition = directededge->trans_up() || directededge->trans_down();
+    if (transition && !anytime) {
+      candidates_.push_back({edgeid, directededge, pred.cost(), 0});
+      continue;
+    }
+    if (!transition) {
+      // Skip shortcut edges when near the destination.
+      // TODO - do not think this is needed - moved this out of autocost.
+      // If needed should base it on a hierarchy limit...
+      if (directededge->is_shortcut() && dist2dest < 10000.0f)
+        continue;
+
+      // Skip any superseded edges that match the shortcut mask. Also skip
+      // if no access is allowed to this edge (based on costing method)
+      if ((shortcuts & directededge->superseded()) ||
+          !cost.Allowed(directededge, pred)) {
+        continue;
+      }
+    }
+
+    // Get the current set. Skip this edge if permanently labeled (best
+    // path already found to this directed edge) unless searching anytime.
+    EdgeStatusInfo edgestatus = edgestatus_->Get(edgeid);
+    if (edgestatus.status.set == kPermanent && !anytime) {
+      continue;
+    }
+
+    // Get cost (transition edges keep the predecessor's cost) and update
+    // the walking distance
+    Cost newcost = transition ? pred.cost() : pred.cost() +
+                   cost.EdgeCost(directededge, nodeinfo->density()) +
+                   cost.TransitionCost(directededge, nodeinfo, pred);
+    walking_distance_ = (pedestrian && !transition) ?
+                  pred.walking_distance() + directededge->length() : 0;
+
+    // Anytime searches: a settled edge reached at lower cost is updated and
+    // searched again - in the next iteration if settled in this one,
+    // otherwise now
+    if (anytime && edgestatus.status.set == kPermanent) {
+      uint32_t idx = edgestatus.status.index;
+      EdgeLabel& label = edgelabels_[idx];
+      float dc = label.cost().cost - newcost.cost;
+      if (dc > 0.0f && settled_[idx] == iteration_) {
+        label.Update(predindex, newcost, label.sortcost() - dc,
+                     walking_distance_);
+        improved_.push_back(idx);
+      } else if (dc > 0.0f) {
+        float sortcost = newcost.cost + astarheuristic_.Get(label.distance());
+        label.Update(predindex, newcost, sortcost, walking_distance_);
+        adjacencylist_->Add(idx, sortcost);
+        edgestatus_->Set(edgeid, kTemporary, idx);
+      }
+      continue;
+    }
+
+    // Update the_shortcuts mask
+    if (!transition) {
+      shortcuts |= directededge->shortcut();
+    }
+
+    // Check if edge is temporarily labeled and this path has less cost. If
+    // less cost the predecessor is updated and the sort cost is decremented
+    // by the difference in real cost (A* heuristic doesn't change)
+    if (edgestatus.status.set == kTemporary) {
+      CheckIfLowerCostPath(edgestatus.status.index, predindex, newcost);
+      continue;
+    }
+    if (transition) {
+      candidates_.push_back({edgeid, directededge, newcost, 0});
+      continue;
+    }
+
+    // Get the lat,lng at the end node of the directed edge for the A*
+    // heuristic. Most end nodes are in the same tile as the node being
+    // expanded. Skip if tile not found or outside the corridor.
+    bool sametile = (directededge->endnode().tileid() == node.tileid() &&
+                     directededge->endnode().level() == node.level());
+    if (!sametile && corridor_ != nullptr &&
+        !corridor_->Contains(directededge->endnode())) {
+      continue;
+    }
+    const GraphTile* endtile = sametile ? tile :
+                               tilecache_.Get(directededge->endnode());
+    if (endtile == nullptr) {
+      continue;
+    }
+    candidates_.push_back({edgeid, directededge, newcost, walking_distance_});
+    candidate_lls_.push_back(endtile->node(directededge->endnode())->latlng());
+  }
+
+  // Find the distance to the destination and the A* heuristic for all
+  // candidate end nodes (other than transition edges) at once
+  uint32_t count = candidate_lls_.size();
+  candidate_dists_.resize(count);
+  candidate_heuristics_.resize(count);
+  astarheuristic_.Get(candidate_lls_.data(), count,
+                      candidate_dists_.data(), candidate_heuristics_.data());
+
+  // Add edge labels, add to the adjacency list and set edge status
+  uint32_t h = 0;
+  for (const auto& candidate : candidates_) {
+    if (candidate.directededge->trans_up() ||
+        candidate.directededge->trans_down()) {
+      HandleTransitionEdge(node.level(), candidate.edgeid,
+                           candidate.directededge, pred, predindex);
+      continue;
+    }
+    float heuristic = candidate_heuristics_[h];
+    float dist = candidate_dists_[h++];
+    if (candidate.cost.cost + heuristic * heuristic_scale > prune_cost) {
+      pruned_++;
+      continue;
+    }
+    float sortcost = candidate.cost.cost + heuristic;
+    edgelabels_.emplace_back(predindex, candidate.edgeid,
+                  candidate.directededge, candidate.cost, sortcost,
+                  dist, candidate.directededge->restrictions(),
+                  candidate.directededge->opp_local_idx(), mode_,
+                  candidate.walking_distance);
+    adjacencylist_->Add(edgelabel_index_, sortcost);
+    edgestatus_->Set(candidate.edgeid, kTemporary, edgelabel_index_);
+    edgelabel_index_++;
+  }
+
+  // New labels of an anytime search are not settled yet
+  if (anytime) {
+    settled_.resize(edgelabel_index_, kUnsettled);
+  }
+}
+
+// A* search kernel.
+std::vector<PathInfo> PathAlgorithm::AStar(const PathLocation& origin,
+             const PathLocation& dest, GraphReader& graphreader,
+             const std::shared_ptr<DynamicCost>& costing,
+             const PathInfo& loop_edge_info, const bool warm_start) {
+  const DynamicCost& cost = *costing;
+
+  // Initialize - create adjacency list, edgestatus support, A*, etc. and
+  // the origin and destination locations. When warm starting, the retained
+  // search tree is prepared for the new destination instead.
+  tilecache_.Init(graphreader, shared_tilecache_);
+  if (warm_start) {
+    if (ResumeSearch(graphreader, dest, costing)) {
+      return FormPath(best_destination_.first, graphreader, loop_edge_info);
+    }
+  } else {
+    Init(origin.vertex(), dest.vertex(), costing, false);
+    SetOrigin(graphreader, origin, costing, loop_edge_info);
+    SetDestination(graphreader, dest, costing);
+
+    // Edges of a previous route are also destinations when rerouting
+    for (const auto& edge : reroute_edges_) {
+      if (destinations_.find(edge.first) == destinations_.end()) {
+        destinations_[edge.first] = edge.second.second;
+      }
+    }
+  }
   float mindist = astarheuristic_.GetDistance(origin.vertex());
 
-  // Initialize the origin and destination locations
-  SetOrigin(graphreader, origin, costing, loop_edge_info);
-  SetDestination(graphreader, dest, costing);
+  // Edges are not labeled if their cost plus the unweighted heuristic
+  // exceeds the cost bound
+  const float prune_cost = PruneCost(dest, cost);
+  const float heuristic_scale = 1.0f / (1.0f + epsilon_);
 
   // Find shortest path
   uint32_t nc = 0;       // Count of iterations with no convergence
@@ -214,10 +612,13 @@ std::vector<PathInfo> PathAlgorithm::GetBestPath(const PathLocation& origin,
     // Remove label from adjacency list, mark it as done - copy the EdgeLabel
     // for use in costing
     EdgeLabel pred = edgelabels_[predindex];
-    edgestatus_->Set(pred.edgeid(), kPermanent, pred.edgeid());
+    edgestatus_->Set(pred.edgeid(), kPermanent, predindex);
+    expansions_++;
 
-    // Check for completion. Form path and return if complete.
+    // Check for completion. Form path and return if complete. The label
+    // was not expanded (needed if the search tree is reused).
     if (IsComplete(predindex)) {
+      deferred_.push_back(predindex);
       return FormPath(best_destination_.first, graphreader, loop_edge_info);
     }
 
@@ -242,98 +643,846 @@ std::vector<PathInfo> PathAlgorithm::GetBestPath(const PathLocation& origin,
       hierarchy_limits_[level+1].up_transition_count++;
     }
     if (hierarchy_limits_[level].StopExpanding(dist2dest)) {
+      deferred_.push_back(predindex);
       continue;
     }
 
     // Skip if tile not found (can happen with regional data sets).
-    if ((tile = graphreader.GetGraphTile(node)) == nullptr) {
+    if ((tile = tilecache_.Get(node)) == nullptr) {
       continue;
     }
 
     // Check access at the node
     const NodeInfo* nodeinfo = tile->node(node);
+    if (!cost.Allowed(nodeinfo)) {
+      continue;
+    }
+
+    // Let the prefetcher know where the search frontier is
+    if (prefetcher_ != nullptr && expansions_ % kPrefetchInterval == 0) {
+      prefetcher_->Prefetch(nodeinfo->latlng(), dest.vertex());
+    }
+
+    // Expand from end node
+    Expand<false>(predindex, pred, tile, nodeinfo, cost, prune_cost,
+                  heuristic_scale);
+  }
+  return {};      // Should never get here
+}
+
+// Calculate best path from a new position, joining a previous route.
+std::vector<PathInfo> PathAlgorithm::GetBestPathReroute(
+             const PathLocation& position, const PathLocation& destination,
+             const std::vector<PathInfo>& path, GraphReader& graphreader,
+             const std::shared_ptr<DynamicCost>& costing) {
+  TileCacheReadGuard guard(shared_tilecache_, shared_tilecache_reader_);
+  PathLocation dest = update_destinations(graphreader, shared_tilecache_, destination,
+                                          costing->GetFilter());
+
+  // Trivial and loop paths are handled by GetBestPath
+  mode_ = costing->travelmode();
+  if (path.empty() || trivial(position, dest).Is_Valid() ||
+      loop(position, dest).Is_Valid()) {
+    return GetBestPath(position, destination, graphreader, costing);
+  }
+
+  // Discard any search tree retained for warm start and set the edges of
+  // the previous route
+  if (edgestatus_ != nullptr) {
+    Clear();
+  }
+  if (!SetRerouteEdges(graphreader, dest, path, costing)) {
+    return GetBestPath(position, destination, graphreader, costing);
+  }
+
+  // Search until the best way to join the previous route is found
+  PathInfo loop_edge_info(mode_, 0.0f, {}, 0);
+  std::vector<PathInfo> newpath = AStar(position, dest, graphreader,
+                    costing, loop_edge_info, false);
+
+  // Splice on the remainder of the previous route, with elapsed time
+  // continuing from the end of the edge where the routes join
+  if (!newpath.empty()) {
+    const EdgeLabel& join = edgelabels_[best_destination_.first];
+    auto edge = reroute_edges_.find(join.edgeid());
+    if (edge != reroute_edges_.end()) {
+      uint32_t k = edge->second.first;
+      for (uint32_t i = k + 1; i < path.size(); i++) {
+        uint32_t t = static_cast<uint32_t>(join.cost().secs) +
+                     path[i].elapsed_time - path[k].elapsed_time;
+        newpath.emplace_back(path[i].mode, t, path[i].edgeid, path[i].trip_id);
+      }
+    }
+  }
+  reroute_edges_.clear();
+  return newpath;
+}
+
+// Find the cost and length of the best path without forming the path.
+bool PathAlgorithm::GetBestCost(const PathLocation& origin,
+             const PathLocation& destination, GraphReader& graphreader,
+             const std::shared_ptr<DynamicCost>& costing, PathCost& pathcost,
+             const uint64_t warm_start_key) {
+  // Tiles from the shared cache must remain valid until the path length is
+  // summed (the search tile cache holds pointers to them)
+  TileCacheReadGuard guard(shared_tilecache_, shared_tilecache_reader_);
+
+  // The destination edges as searched (edges entering a node destination)
+  PathLocation dest = update_destinations(graphreader, shared_tilecache_, destination,
+                                          costing->GetFilter());
+
+  // Trivial path - the part of the edge between the locations
+  GraphId trivial_id = trivial(origin, dest);
+  if (trivial_id.Is_Valid()) {
+    const DirectedEdge* edge =
+        GetGraphTile(graphreader, shared_tilecache_, trivial_id)->directededge(trivial_id);
+    float fraction = edge_dist(dest, trivial_id) - edge_dist(origin, trivial_id);
+    pathcost.cost = costing->EdgeCost(edge, 0) * fraction;
+    pathcost.length = edge->length() * fraction;
+    return true;
+  }
+
+  // Search without forming the path. The destination label is only valid
+  // if set by this search.
+  best_destination_ = std::make_pair(kInvalidLabel,
+                         Cost(std::numeric_limits<float>::max(), 0.0f));
+  cost_only_ = true;
+  bool found = !GetBestPath(origin, destination, graphreader, costing,
+                            warm_start_key).empty();
+  cost_only_ = false;
+  if (!found || best_destination_.first == kInvalidLabel) {
+    return false;
+  }
+
+  // The destination label ends at the end of the destination edge. Remove
+  // the part of the edge past the destination.
+  const EdgeLabel& destlabel = edgelabels_[best_destination_.first];
+  const GraphTile* tile = tilecache_.Get(destlabel.edgeid());
+  const DirectedEdge* edge = tile->directededge(destlabel.edgeid());
+  float remaining = 1.0f - edge_dist(dest, destlabel.edgeid());
+  Cost past = costing->EdgeCost(edge, 0) * remaining;
+  pathcost.cost = Cost(destlabel.cost().cost - past.cost,
+                       destlabel.cost().secs - past.secs);
+  pathcost.length = -edge->length() * remaining;
+
+  // Sum the edge lengths back to the origin (origin edges start at the
+  // origin, a loop path also has the part of its edge after the origin)
+  for (uint32_t index = best_destination_.first; index != kInvalidLabel;
+       index = edgelabels_[index].predecessor()) {
+    const EdgeLabel& edgelabel = edgelabels_[index];
+    tile = tilecache_.Get(edgelabel.edgeid());
+    edge = tile->directededge(edgelabel.edgeid());
+    pathcost.length += edge->length();
+    if (edgelabel.predecessor() == kInvalidLabel) {
+      pathcost.length -= edge->length() * edge_dist(origin, edgelabel.edgeid());
+    }
+  }
+  GraphId loop_id = loop(origin, dest);
+  if (loop_id.Is_Valid()) {
+    edge = GetGraphTile(graphreader, shared_tilecache_, loop_id)->directededge(loop_id);
+    pathcost.length += edge->length() * (1.0f - edge_dist(origin, loop_id));
+  }
+  return true;
+}
+
+// Calculate best path with a search bounded by the cost of a coarse route.
+std::vector<PathInfo> PathAlgorithm::GetBestPathBounded(
+             const PathLocation& origin, const PathLocation& destination,
+             GraphReader& graphreader,
+             const std::shared_ptr<DynamicCost>& costing) {
+  // Find the coarse route and its cost
+  coarse_ = true;
+  std::vector<PathInfo> path = GetBestPath(origin, destination, graphreader,
+                                           costing);
+  coarse_ = false;
+  uint32_t expansions = expansions_;
+  float cost_bound = best_destination_.second.cost;
+
+  // Search with the bound (trivial paths have no search to bound)
+  if (!path.empty() && best_destination_.first != kInvalidLabel) {
+    Clear();
+    path = GetBestPath(origin, destination, graphreader, costing, 0, cost_bound);
+    expansions += expansions_;
+    if (path.empty()) {
+      LOG_INFO("Bounded search failed - trying without the bound");
+      Clear();
+      path = GetBestPath(origin, destination, graphreader, costing);
+      expansions += expansions_;
+    }
+  } else if (path.empty()) {
+    Clear();
+    path = GetBestPath(origin, destination, graphreader, costing);
+    expansions += expansions_;
+  }
+  expansions_ = expansions;
+  return path;
+}
+
+// Calculate best path within a corridor around a coarse route.
+std::vector<PathInfo> PathAlgorithm::GetBestPathCorridor(
+             const PathLocation& origin, const PathLocation& destination,
+             GraphReader& graphreader,
+             const std::shared_ptr<DynamicCost>& costing, const float radius) {
+  // Find the coarse route
+  coarse_ = true;
+  std::vector<PathInfo> path = GetBestPath(origin, destination, graphreader,
+                                           costing);
+  coarse_ = false;
+  uint32_t expansions = expansions_;
+
+  // Search within the corridor around the end nodes of the coarse route
+  if (!path.empty()) {
+    TileCacheReadGuard guard(shared_tilecache_, shared_tilecache_reader_);
+    std::vector<PointLL> shape = { origin.vertex() };
+    for (const auto& edge : path) {
+      const GraphTile* tile = GetGraphTile(graphreader, shared_tilecache_, edge.edgeid);
+      if (tile == nullptr) {
+        continue;
+      }
+      GraphId endnode = tile->directededge(edge.edgeid)->endnode();
+      const GraphTile* endtile = GetGraphTile(graphreader, shared_tilecache_, endnode);
+      if (endtile != nullptr) {
+        shape.push_back(endtile->node(endnode)->latlng());
+      }
+    }
+    shape.push_back(destination.vertex());
+    search_corridor_.Build(graphreader.GetTileHierarchy(), shape, radius);
+    Clear();
+    corridor_ = &search_corridor_;
+    path = GetBestPath(origin, destination, graphreader, costing);
+    corridor_ = nullptr;
+    expansions += expansions_;
+  }
+
+  // Fall back to the unrestricted search
+  if (path.empty()) {
+    LOG_INFO("Corridor search failed - trying without the corridor");
+    Clear();
+    path = GetBestPath(origin, destination, graphreader, costing);
+    expansions += expansions_;
+  }
+  expansions_ = expansions;
+  return path;
+}
+
+// Calculate best path with an anytime search.
+std::vector<PathInfo> PathAlgorithm::GetBestPathAnytime(
+             const PathLocation& origin, const PathLocation& destination,
+             GraphReader& graphreader,
+             const std::shared_ptr<DynamicCost>& costing,
+             const std::chrono::steady_clock::time_point& deadline,
+             const float epsilon, float& bound, const float cost_bound) {
+  // Tiles from the shared cache must remain valid during the search
+  TileCacheReadGuard guard(shared_tilecache_, shared_tilecache_reader_);
+  PathLocation dest = update_destinations(graphreader, shared_tilecache_, destination,
+                                          costing->GetFilter());
+
+  // Check for trivial path
+  bound = 0.0f;
+  mode_ = costing->travelmode();
+  auto trivial_id = trivial(origin, dest);
+  if (trivial_id.Is_Valid()) {
+    std::vector<PathInfo> trivialpath;
+    trivialpath.emplace_back(mode_, 0, trivial_id, 0);
+    return trivialpath;
+  }
+  PathInfo loop_edge_info(mode_, 0.0f, loop(origin, dest), 0);
+
+  // Start a new search (the search tree is not retained) weighted by the
+  // initial epsilon
+  CanWarmStart(origin, 0, loop_edge_info);
+  float current = std::max(epsilon, 0.0f);
+  float saved_epsilon = epsilon_;
+  epsilon_ = current;
+  tilecache_.Init(graphreader, shared_tilecache_);
+  Init(origin.vertex(), dest.vertex(), costing, false);
+  epsilon_ = saved_epsilon;
+  SetOrigin(graphreader, origin, costing, loop_edge_info);
+  SetDestination(graphreader, dest, costing);
+
+  // Best path found (destination label and cost) and its proven bound
+  best_destination_ = std::make_pair(kInvalidLabel,
+                         Cost(std::numeric_limits<float>::max(), 0.0f));
+  bound = std::numeric_limits<float>::max();
+  cost_bound_ = cost_bound;
+  const float prune_cost = PruneCost(dest, *costing);
+
+  // Iteration each label was settled in. An iteration searches as if only
+  // its own labels were settled (as anytime repairing A* does).
+  settled_.assign(edgelabel_index_, kUnsettled);
+  improved_.clear();
+  iteration_ = 0;
+  while (true) {
+    // An iteration ends when no label left can lead to a better path. The
+    // best path then costs at most (1 + current) times the optimal cost.
+    uint32_t predindex = adjacencylist_->Remove(edgelabels_);
+    if (predindex == kInvalidLabel ||
+        (best_destination_.first != kInvalidLabel &&
+         edgelabels_[predindex].sortcost() >= best_destination_.second.cost)) {
+      if (best_destination_.first == kInvalidLabel) {
+        LOG_ERROR("Route failed after iterations = " +
+                  std::to_string(edgelabel_index_));
+        return { };
+      }
+      bound = current;
+      if (current == 0.0f) {
+        break;
+      }
+      current *= kAnytimeEpsilonFactor;
+      if (current < kAnytimeMinEpsilon) {
+        current = 0.0f;
+      }
+      iteration_++;
+      if (!Reprioritize(dest.vertex(), costing, current, improved_)) {
+        // Nothing left to search - the best path is optimal
+        bound = 0.0f;
+        break;
+      }
+      continue;
+    }
+
+    // Mark the label as done. A label searched again (reached at lower
+    // cost after it was settled) was already settled in an earlier pass.
+    EdgeLabel pred = edgelabels_[predindex];
+    edgestatus_->Set(pred.edgeid(), kPermanent, predindex);
+    bool resettled = (settled_[predindex] != kUnsettled);
+    settled_[predindex] = iteration_;
+    expansions_++;
+
+    // Return the best path found so far at the deadline
+    if (expansions_ % kDeadlineInterval == 0 &&
+        std::chrono::steady_clock::now() >= deadline) {
+      if (best_destination_.first == kInvalidLabel) {
+        LOG_INFO("No route found before the deadline");
+        return { };
+      }
+      break;
+    }
+
+    // Destination edges update the best path. The search continues past
+    // them to improve it. A destination label settled by the search at the
+    // current weight costs at most (1 + current) times the optimal cost, so
+    // the bound holds even if the deadline comes before the iteration ends.
+    auto d = destinations_.find(pred.edgeid());
+    if (d != destinations_.end()) {
+      if (pred.cost() + d->second < best_destination_.second) {
+        best_destination_ = std::make_pair(predindex, pred.cost() + d->second);
+      }
+      bound = std::min(bound, current);
+    }
+
+    // Check hierarchy limits (as in GetBestPath). Upward transitions are
+    // counted once per label, not again when the label is searched again.
+    GraphId node   = pred.endnode();
+    uint32_t level = node.level();
+    if (pred.trans_up() && !resettled) {
+      hierarchy_limits_[level+1].up_transition_count++;
+    }
+    if (hierarchy_limits_[level].StopExpanding(pred.distance())) {
+      continue;
+    }
+    const GraphTile* tile = tilecache_.Get(node);
+    if (tile == nullptr) {
+      continue;
+    }
+    const NodeInfo* nodeinfo = tile->node(node);
     if (!costing->Allowed(nodeinfo)) {
       continue;
     }
 
-    // Expand from end node.
+    // Expand from end node (the heuristic is weighted by current)
+    Expand<true>(predindex, pred, tile, nodeinfo, *costing, prune_cost,
+                 1.0f / (1.0f + current));
+  }
+  return FormPath(best_destination_.first, graphreader, loop_edge_info);
+}
+
+// Calculate best path on a routing graph.
+std::vector<PathInfo> PathAlgorithm::GetBestPath(const PathLocation& origin,
+             const PathLocation& destination, const RoutingGraph& graph,
+             GraphReader& graphreader,
+             const std::shared_ptr<DynamicCost>& costing,
+             EdgeCostTable* edgecosts, TransitionCostTable* transitioncosts) {
+  // Tiles from the shared cache must remain valid during the search
+  TileCacheReadGuard guard(shared_tilecache_, shared_tilecache_reader_);
+
+  PathLocation dest = update_destinations(graphreader, shared_tilecache_, destination,
+                                          costing->GetFilter());
+
+  // Check for trivial path
+  mode_ = costing->travelmode();
+  auto trivial_id = trivial(origin, dest);
+  if (trivial_id.Is_Valid()) {
+    std::vector<PathInfo> trivialpath;
+    trivialpath.emplace_back(mode_, 0, trivial_id, 0);
+    return trivialpath;
+  }
+
+  // Loops and locations outside of the graph are routed on the tiles
+  bool in_graph = !loop(origin, dest).Is_Valid();
+  for (const auto& edge : origin.edges()) {
+    in_graph = in_graph &&
+               graph.EdgeIndex(edge.id) != RoutingGraph::kInvalidNode;
+  }
+  for (const auto& edge : dest.edges()) {
+    in_graph = in_graph &&
+               graph.EdgeIndex(edge.id) != RoutingGraph::kInvalidNode;
+  }
+  if (!in_graph) {
+    return GetBestPath(origin, destination, graphreader, costing);
+  }
+
+  // Discard any search tree retained for warm start
+  if (edgestatus_ != nullptr) {
+    Clear();
+  }
+
+  // Run the kernel instantiated for the customized tables given
+  if (edgecosts != nullptr && transitioncosts != nullptr) {
+    GraphCosts<true, true> costs(graph, *costing, edgecosts, transitioncosts);
+    return AStarGraph(origin, dest, graph, graphreader, costing, costs);
+  } else if (edgecosts != nullptr) {
+    GraphCosts<true, false> costs(graph, *costing, edgecosts, nullptr);
+    return AStarGraph(origin, dest, graph, graphreader, costing, costs);
+  } else if (transitioncosts != nullptr) {
+    GraphCosts<false, true> costs(graph, *costing, nullptr, transitioncosts);
+    return AStarGraph(origin, dest, graph, graphreader, costing, costs);
+  }
+  GraphCosts<false, false> costs(graph, *costing, nullptr, nullptr);
+  return AStarGraph(origin, dest, graph, graphreader, costing, costs);
+}
+
+// A* search kernel on a routing graph, instantiated per edge cost source.
+template <class costs_t>
+std::vector<PathInfo> PathAlgorithm::AStarGraph(const PathLocation& origin,
+             const PathLocation& dest, const RoutingGraph& graph,
+             GraphReader& graphreader,
+             const std::shared_ptr<DynamicCost>& costing, costs_t& costs) {
+  const DynamicCost& cost = *costing;
+  const bool pedestrian = (mode_ == TravelMode::kPedestrian);
+  const PathInfo loop_edge_info(mode_, 0.0f, {}, 0);
+
+  // Initialize and add the origin edges (as in SetOrigin)
+  Init(origin.vertex(), dest.vertex(), costing, false);
+  graph_edgestatus_.Init(graph.edgecount());
+  graph_label_edges_.clear();
+  float dist = astarheuristic_.GetDistance(origin.vertex());
+  float heuristic = astarheuristic_.Get(dist);
+  for (const auto& edge : origin.edges()) {
+    uint32_t e = graph.EdgeIndex(edge.id);
+    const DirectedEdge* directededge = graph.directededge(e);
+    Cost edgecost = costing->EdgeCost(directededge, 0) * (1.0f - edge.dist);
+    float sortcost = edgecost.cost + heuristic;
+    edgelabels_.emplace_back(kInvalidLabel, edge.id, directededge, edgecost,
+            sortcost, dist, 0, directededge->opp_local_idx(), mode_, 0);
+    adjacencylist_->Add(edgelabel_index_, sortcost);
+    graph_edgestatus_.Set(e, kTemporary, edgelabel_index_);
+    graph_label_edges_.push_back(e);
+    edgelabel_index_++;
+  }
+  SetDestination(graphreader, dest, costing);
+  float mindist = dist;
+
+  // Find shortest path
+  uint32_t nc = 0;
+  while (true) {
+    uint32_t predindex = adjacencylist_->Remove(edgelabels_);
+    if (predindex == kInvalidLabel) {
+      if(best_destination_.first != kInvalidLabel)
+        return FormPath(best_destination_.first, graphreader, loop_edge_info);
+      LOG_ERROR("Route failed after iterations = " +
+                   std::to_string(edgelabel_index_));
+      return { };
+    }
+
+    // Mark the edge as done and check for completion
+    EdgeLabel pred = edgelabels_[predindex];
+    uint32_t prededge = graph_label_edges_[predindex];
+    graph_edgestatus_.Set(prededge, kPermanent, predindex);
+    expansions_++;
+    if (IsComplete(predindex)) {
+      return FormPath(best_destination_.first, graphreader, loop_edge_info);
+    }
+
+    // Check that distance is converging towards the destination
+    float dist2dest = pred.distance();
+    if (dist2dest < mindist) {
+      mindist = dist2dest;
+      nc = 0;
+    } else if (nc++ > 500000) {
+      return {};
+    }
+
+    // Check hierarchy
+    uint32_t level = pred.endnode().level();
+    if (pred.trans_up()) {
+      hierarchy_limits_[level+1].up_transition_count++;
+    }
+    if (hierarchy_limits_[level].StopExpanding(dist2dest)) {
+      continue;
+    }
+
+    // Skip if the end node is outside of the graph (the tile search skips
+    // nodes whose tile is not found). Check access at the node.
+    uint32_t node = graph.edge(prededge).endnode;
+    if (node == RoutingGraph::kInvalidNode) {
+      continue;
+    }
+    const NodeInfo* nodeinfo = graph.nodeinfo(node);
+    if (!cost.Allowed(nodeinfo)) {
+      continue;
+    }
+
+    // Costs of the edges leaving the node (after the predecessor)
+    costs.SetNode(node, nodeinfo, prededge, pred);
+
+    // Expand from end node
     uint32_t shortcuts = 0;
-    GraphId edgeid(node.tileid(), node.level(), nodeinfo->edge_index());
-    const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
-    for (uint32_t i = 0, n = nodeinfo->edge_count(); i < n;
-                i++, directededge++, edgeid++) {
-      // Handle transition edges they either get skipped or added to the
-      // adjacency list using the predecessor info
-      if (directededge->trans_up() || directededge->trans_down()) {
-          HandleTransitionEdge(level, edgeid, directededge, pred,  predindex);
+    graph_candidates_.clear();
+    candidate_lls_.clear();
+    for (uint32_t e = graph.edge_index(node), end = graph.edge_index(node + 1);
+                e < end; e++) {
+      const RoutingEdge& edge = graph.edge(e);
+      if (edge.trans_up || edge.trans_down) {
+        graph_candidates_.push_back({e, pred.cost(), 0});
         continue;
       }
-
-      // Skip shortcut edges when near the destination.
-      // TODO - do not think this is needed - moved this out of autocost.
-      // If needed should base it on a hierarchy limit...
-      if (directededge->is_shortcut() && dist2dest < 10000.0f)
+      if (edge.is_shortcut && dist2dest < 10000.0f) {
         continue;
-
-      // Skip any superseded edges that match the shortcut mask. Also skip
-      // if no access is allowed to this edge (based on costing method)
-      if ((shortcuts & directededge->superseded()) ||
-          !costing->Allowed(directededge, pred)) {
+      }
+      const DirectedEdge* directededge = graph.directededge(e);
+      if ((shortcuts & edge.superseded) || !cost.Allowed(directededge, pred)) {
         continue;
       }
-
-      // Get the current set. Skip this edge if permanently labeled (best
-      // path already found to this directed edge).
-      EdgeStatusInfo edgestatus = edgestatus_->Get(edgeid);
+      EdgeStatusInfo edgestatus = graph_edgestatus_.Get(e);
       if (edgestatus.status.set == kPermanent) {
         continue;
       }
+      shortcuts |= edge.shortcut;
 
-      // Update the_shortcuts mask
-      shortcuts |= directededge->shortcut();
-
-      // Get cost
-      Cost newcost = pred.cost() +
-                     costing->EdgeCost(directededge, nodeinfo->density()) +
-                     costing->TransitionCost(directededge, nodeinfo, pred);
-
-      // Update walking distance
-      walking_distance_ = (mode_ == TravelMode::kPedestrian) ?
+      // Get cost and update walking distance
+      Cost newcost = pred.cost() + costs.Get(e, directededge, pred);
+      walking_distance_ = pedestrian ?
                     pred.walking_distance() + directededge->length() : 0;
-
-      // Check if edge is temporarily labeled and this path has less cost. If
-      // less cost the predecessor is updated and the sort cost is decremented
-      // by the difference in real cost (A* heuristic doesn't change)
       if (edgestatus.status.set == kTemporary) {
         CheckIfLowerCostPath(edgestatus.status.index, predindex, newcost);
         continue;
       }
+      if (edge.endnode == RoutingGraph::kInvalidNode) {
+        continue;
+      }
+      graph_candidates_.push_back({e, newcost, walking_distance_});
+      candidate_lls_.push_back(graph.latlng(edge.endnode));
+    }
 
-      // Find the sort cost (with A* heuristic) using the lat,lng at the
-      // end node of the directed edge. Skip if tile not found.
-      if ((tile = graphreader.GetGraphTile(directededge->endnode())) == nullptr) {
+    // Find the distance to the destination and the A* heuristic for all
+    // candidate end nodes (other than transition edges) at once
+    uint32_t count = candidate_lls_.size();
+    candidate_dists_.resize(count);
+    candidate_heuristics_.resize(count);
+    astarheuristic_.Get(candidate_lls_.data(), count,
+                        candidate_dists_.data(), candidate_heuristics_.data());
+
+    // Add edge labels, add to the adjacency list and set edge status.
+    // Transition edges are handled as in HandleTransitionEdge.
+    uint32_t h = 0;
+    for (const auto& candidate : graph_candidates_) {
+      const RoutingEdge& edge = graph.edge(candidate.edge);
+      const DirectedEdge* directededge = graph.directededge(candidate.edge);
+      if (edge.trans_up || edge.trans_down) {
+        if (!allow_transitions_ ||
+            (edge.trans_up &&
+             !hierarchy_limits_[level].AllowUpwardTransition(pred.distance())) ||
+            (edge.trans_down &&
+             !hierarchy_limits_[level].AllowDownwardTransition(pred.distance()))) {
+          continue;
+        }
+        edgelabels_.emplace_back(predindex, graph.edgeid(candidate.edge),
+                      directededge, pred.cost(), pred.sortcost(),
+                      pred.distance(), pred.restrictions(),
+                      pred.opp_local_idx(), mode_, 0);
+        adjacencylist_->Add(edgelabel_index_, pred.sortcost());
+      } else {
+        float sortcost = candidate.cost.cost + candidate_heuristics_[h];
+        edgelabels_.emplace_back(predindex, graph.edgeid(candidate.edge),
+                      directededge, candidate.cost, sortcost,
+                      candidate_dists_[h++], directededge->restrictions(),
+                      directededge->opp_local_idx(), mode_,
+                      candidate.walking_distance);
+        adjacencylist_->Add(edgelabel_index_, sortcost);
+      }
+      graph_edgestatus_.Set(candidate.edge, kTemporary, edgelabel_index_);
+      graph_label_edges_.push_back(candidate.edge);
+      edgelabel_index_++;
+    }
+  }
+  return {};      // Should never get here
+}
+
+// Calculate best path on a partition overlay.
+std::vector<PathInfo> PathAlgorithm::GetBestPath(const PathLocation& origin,
+             const PathLocation& destination, const OverlayGraph& overlay,
+             const OverlayMetric& metric, GraphReader& graphreader,
+             const std::shared_ptr<DynamicCost>& costing) {
+  // Tiles from the shared cache must remain valid during the search
+  TileCacheReadGuard guard(shared_tilecache_, shared_tilecache_reader_);
+
+  const RoutingGraph& graph = overlay.graph();
+  const Partition& partition = overlay.partition();
+  PathLocation dest = update_destinations(graphreader, shared_tilecache_, destination,
+                                          costing->GetFilter());
+
+  // Check for trivial path
+  mode_ = costing->travelmode();
+  auto trivial_id = trivial(origin, dest);
+  if (trivial_id.Is_Valid()) {
+    std::vector<PathInfo> trivialpath;
+    trivialpath.emplace_back(mode_, 0, trivial_id, 0);
+    return trivialpath;
+  }
+
+  // Loops and locations outside of the graph are routed on the tiles
+  bool in_graph = !loop(origin, dest).Is_Valid();
+  for (const auto& edge : origin.edges()) {
+    in_graph = in_graph &&
+               graph.EdgeIndex(edge.id) != RoutingGraph::kInvalidNode;
+  }
+  for (const auto& edge : dest.edges()) {
+    in_graph = in_graph &&
+               graph.EdgeIndex(edge.id) != RoutingGraph::kInvalidNode;
+  }
+  if (!in_graph) {
+    return GetBestPath(origin, destination, graphreader, costing);
+  }
+
+  // Discard any search tree retained for warm start
+  if (edgestatus_ != nullptr) {
+    Clear();
+  }
+
+  // Cells of each level holding the origin (end nodes of the origin edges)
+  // or the destination (start nodes of the destination edges). The search
+  // expands graph edges within these cells.
+  std::vector<uint32_t> endpoints;
+  for (const auto& edge : origin.edges()) {
+    uint32_t node = graph.edge(graph.EdgeIndex(edge.id)).endnode;
+    if (node != RoutingGraph::kInvalidNode) {
+      endpoints.push_back(node);
+    }
+  }
+  for (const auto& edge : dest.edges()) {
+    endpoints.push_back(start_node(graph, graph.EdgeIndex(edge.id)));
+  }
+  endpoint_cells_.resize(overlay.levels());
+  for (uint32_t level = 0; level < overlay.levels(); level++) {
+    endpoint_cells_[level].clear();
+    for (uint32_t node : endpoints) {
+      endpoint_cells_[level].push_back(partition.cell(level, node));
+    }
+  }
+
+  // Initialize and add the origin edges (as in SetOrigin)
+  const DynamicCost& cost = *costing;
+  const bool pedestrian = (mode_ == TravelMode::kPedestrian);
+  Init(origin.vertex(), dest.vertex(), costing, false);
+  graph_edgestatus_.Init(graph.edgecount());
+  graph_label_edges_.clear();
+  overlay_label_levels_.clear();
+  float dist = astarheuristic_.GetDistance(origin.vertex());
+  float heuristic = astarheuristic_.Get(dist);
+  for (const auto& edge : origin.edges()) {
+    uint32_t e = graph.EdgeIndex(edge.id);
+    const DirectedEdge* directededge = graph.directededge(e);
+    Cost edgecost = costing->EdgeCost(directededge, 0) * (1.0f - edge.dist);
+    float sortcost = edgecost.cost + heuristic;
+    edgelabels_.emplace_back(kInvalidLabel, edge.id, directededge, edgecost,
+            sortcost, dist, 0, directededge->opp_local_idx(), mode_, 0);
+    adjacencylist_->Add(edgelabel_index_, sortcost);
+    graph_edgestatus_.Set(e, kTemporary, edgelabel_index_);
+    graph_label_edges_.push_back(e);
+    overlay_label_levels_.push_back(kGraphArc);
+    edgelabel_index_++;
+  }
+  SetDestination(graphreader, dest, costing);
+
+  // Find shortest path
+  while (true) {
+    uint32_t predindex = adjacencylist_->Remove(edgelabels_);
+    if (predindex == kInvalidLabel) {
+      if(best_destination_.first != kInvalidLabel)
+        return FormOverlayPath(best_destination_.first, overlay, metric, costing);
+      LOG_ERROR("Route failed after iterations = " +
+                   std::to_string(edgelabel_index_));
+      return { };
+    }
+
+    // Mark the edge as done and check for completion
+    EdgeLabel pred = edgelabels_[predindex];
+    uint32_t prededge = graph_label_edges_[predindex];
+    graph_edgestatus_.Set(prededge, kPermanent, predindex);
+    expansions_++;
+    if (IsComplete(predindex)) {
+      return FormOverlayPath(best_destination_.first, overlay, metric, costing);
+    }
+    uint32_t node = graph.edge(prededge).endnode;
+    if (node == RoutingGraph::kInvalidNode) {
+      continue;
+    }
+
+    // Find the highest level cell the edge enters that holds neither the
+    // origin nor the destination (cells are nested, so lower levels qualify
+    // as well)
+    uint32_t level = kGraphArc;
+    for (uint32_t l = overlay.levels(); l > 0; l--) {
+      const auto& cells = endpoint_cells_[l - 1];
+      if (overlay.entry_index(l - 1, prededge) != RoutingGraph::kInvalidNode &&
+          std::find(cells.begin(), cells.end(),
+                    partition.cell(l - 1, node)) == cells.end()) {
+        level = l - 1;
+        break;
+      }
+    }
+
+    // Continue from the exits of the cell along its clique
+    if (level != kGraphArc) {
+      uint32_t cell = partition.cell(level, node);
+      uint32_t count = overlay.exit_count(level, cell);
+      const uint32_t* exits = overlay.exits(level, cell);
+      const Cost* row = metric.Row(overlay, level, prededge);
+      walking_distance_ = 0;
+      for (uint32_t j = 0; j < count; j++) {
+        if (row[j].cost == OverlayMetric::kUnreachable) {
+          continue;
+        }
+        uint32_t e = exits[j];
+        EdgeStatusInfo edgestatus = graph_edgestatus_.Get(e);
+        if (edgestatus.status.set == kPermanent) {
+          continue;
+        }
+        Cost newcost = pred.cost() + row[j];
+        if (edgestatus.status.set == kTemporary) {
+          if (newcost.cost < edgelabels_[edgestatus.status.index].cost().cost) {
+            CheckIfLowerCostPath(edgestatus.status.index, predindex, newcost);
+            overlay_label_levels_[edgestatus.status.index] = level;
+          }
+          continue;
+        }
+        const DirectedEdge* directededge = graph.directededge(e);
+        float dist = astarheuristic_.GetDistance(graph.latlng(graph.edge(e).endnode));
+        float sortcost = newcost.cost + astarheuristic_.Get(dist);
+        edgelabels_.emplace_back(predindex, graph.edgeid(e), directededge,
+                      newcost, sortcost, dist, directededge->restrictions(),
+                      directededge->opp_local_idx(), mode_, 0);
+        adjacencylist_->Add(edgelabel_index_, sortcost);
+        graph_edgestatus_.Set(e, kTemporary, edgelabel_index_);
+        graph_label_edges_.push_back(e);
+        overlay_label_levels_.push_back(level);
+        edgelabel_index_++;
+      }
+      continue;
+    }
+
+    // Expand the graph edges from the end node. Transition edges keep the
+    // predecessor's cost and turn information (there are no hierarchy
+    // limits, so they are always allowed).
+    const NodeInfo* nodeinfo = graph.nodeinfo(node);
+    if (!cost.Allowed(nodeinfo)) {
+      continue;
+    }
+    for (uint32_t e = graph.edge_index(node), end = graph.edge_index(node + 1);
+                e < end; e++) {
+      const RoutingEdge& edge = graph.edge(e);
+      if (edge.is_shortcut || edge.endnode == RoutingGraph::kInvalidNode) {
+        continue;
+      }
+      const DirectedEdge* directededge = graph.directededge(e);
+      EdgeStatusInfo edgestatus = graph_edgestatus_.Get(e);
+      if (edgestatus.status.set == kPermanent) {
+        continue;
+      }
+      Cost newcost = pred.cost();
+      uint32_t restrictions = pred.restrictions();
+      uint32_t opp_local_idx = pred.opp_local_idx();
+      walking_distance_ = pred.walking_distance();
+      if (!edge.trans_up && !edge.trans_down) {
+        if (!cost.Allowed(directededge, pred)) {
+          continue;
+        }
+        newcost = newcost +
+                  cost.EdgeCost(directededge, nodeinfo->density()) +
+                  cost.TransitionCost(directededge, nodeinfo, pred);
+        restrictions = directededge->restrictions();
+        opp_local_idx = directededge->opp_local_idx();
+        walking_distance_ = pedestrian ?
+                    pred.walking_distance() + directededge->length() : 0;
+      }
+      if (edgestatus.status.set == kTemporary) {
+        if (newcost.cost < edgelabels_[edgestatus.status.index].cost().cost) {
+          CheckIfLowerCostPath(edgestatus.status.index, predindex, newcost);
+          overlay_label_levels_[edgestatus.status.index] = kGraphArc;
+        }
         continue;
       }
-      float dist = astarheuristic_.GetDistance(tile->node(
-                directededge->endnode())->latlng());
+      float dist = astarheuristic_.GetDistance(graph.latlng(edge.endnode));
       float sortcost = newcost.cost + astarheuristic_.Get(dist);
-
-      // Add edge label, add to the adjacency list and set edge status
-      edgelabels_.emplace_back(predindex, edgeid, directededge,
-                    newcost, sortcost, dist, directededge->restrictions(),
-                    directededge->opp_local_idx(), mode_, walking_distance_);
+      edgelabels_.emplace_back(predindex, graph.edgeid(e), directededge,
+                    newcost, sortcost, dist, restrictions, opp_local_idx,
+                    mode_, walking_distance_);
       adjacencylist_->Add(edgelabel_index_, sortcost);
-      edgestatus_->Set(edgeid, kTemporary, edgelabel_index_);
+      graph_edgestatus_.Set(e, kTemporary, edgelabel_index_);
+      graph_label_edges_.push_back(e);
+      overlay_label_levels_.push_back(kGraphArc);
       edgelabel_index_++;
     }
   }
   return {};      // Should never get here
 }
 
+// Form the path of an overlay search, unpacking clique arcs.
+std::vector<PathInfo> PathAlgorithm::FormOverlayPath(const uint32_t dest,
+             const OverlayGraph& overlay, const OverlayMetric& metric,
+             const std::shared_ptr<DynamicCost>& costing) {
+  LOG_INFO("PathCost = " + std::to_string(edgelabels_[dest].cost().cost) +
+           "  Iterations = " + std::to_string(edgelabel_index_));
+
+  // Work backwards from the destination. Edges of a clique arc are added
+  // in reverse order with the elapsed time at the end of the arc's entry.
+  const RoutingGraph& graph = overlay.graph();
+  std::vector<PathInfo> path;
+  for(auto edgelabel_index = dest; edgelabel_index != kInvalidLabel;
+      edgelabel_index = edgelabels_[edgelabel_index].predecessor()) {
+    const EdgeLabel& edgelabel = edgelabels_[edgelabel_index];
+    path.emplace_back(edgelabel.mode(), edgelabel.cost().secs,
+                      edgelabel.edgeid(), edgelabel.tripid());
+    uint32_t level = overlay_label_levels_[edgelabel_index];
+    uint32_t predindex = edgelabel.predecessor();
+    if (level == kGraphArc || predindex == kInvalidLabel) {
+      continue;
+    }
+    if (!metric.Unpack(overlay, *costing, level,
+                       graph_label_edges_[predindex],
+                       graph_label_edges_[edgelabel_index], unpacked_edges_)) {
+      LOG_ERROR("Could not unpack an overlay clique arc");
+      return {};
+    }
+    float t0 = edgelabels_[predindex].cost().secs;
+    for (auto it = unpacked_edges_.rbegin() + 1; it != unpacked_edges_.rend();
+         it++) {
+      path.emplace_back(edgelabel.mode(), t0 + it->second.secs,
+                        graph.edgeid(it->first), edgelabel.tripid());
+    }
+  }
+
+  // Reverse the list and return
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
 // Calculate best path.
 std::vector<PathInfo> PathAlgorithm::GetBestPathMM(const PathLocation& origin,
              const PathLocation& destination, GraphReader& graphreader,
              const std::shared_ptr<DynamicCost>* mode_costing) {
+  TileCacheReadGuard guard(shared_tilecache_, shared_tilecache_reader_);
   // TODO - some means of setting an initial mode and probably a dest/end mode
    mode_ = TravelMode::kPedestrian;
    const auto& costing = mode_costing[static_cast<uint32_t>(mode_)];
@@ -343,7 +1492,7 @@ std::vector<PathInfo> PathAlgorithm::GetBestPathMM(const PathLocation& origin,
 
   // Alter the destination edges if at a node - loki always gives edges
   // leaving a node, but when a destination we want edges entering the node
-  PathLocation dest = update_destinations(graphreader, destination,
+  PathLocation dest = update_destinations(graphreader, shared_tilecache_, destination,
                                           costing->GetFilter());
 
   // Check for trivial path
@@ -367,11 +1516,17 @@ std::vector<PathInfo> PathAlgorithm::GetBestPathMM(const PathLocation& origin,
   // Check for loop path
   PathInfo loop_edge_info(mode_, 0.0f, loop(origin, dest), 0);
 
+  // Discard any search tree retained for warm start
+  if (edgestatus_ != nullptr) {
+    Clear();
+  }
+
   // Initialize - create adjacency list, edgestatus support, A*, etc.
   Init(origin.vertex(), dest.vertex(), costing, true);
   float mindist = astarheuristic_.GetDistance(origin.vertex());
 
   // Initialize the origin and destination locations
+  tilecache_.Init(graphreader, shared_tilecache_);
   SetOrigin(graphreader, origin, costing, loop_edge_info);
   SetDestination(graphreader, dest, costing);
 
@@ -399,7 +1554,8 @@ std::vector<PathInfo> PathAlgorithm::GetBestPathMM(const PathLocation& origin,
     // Remove label from adjacency list, mark it as done - copy the EdgeLabel
     // for use in costing
     EdgeLabel pred = edgelabels_[predindex];
-    edgestatus_->Set(pred.edgeid(), kPermanent, pred.edgeid());
+    edgestatus_->Set(pred.edgeid(), kPermanent, predindex);
+    expansions_++;
 
     // Check for completion. Form path and return if complete.
     if (IsComplete(predindex)) {
@@ -421,7 +1577,7 @@ std::vector<PathInfo> PathAlgorithm::GetBestPathMM(const PathLocation& origin,
     mode_ = pred.mode();
 
     // Skip if tile not found (can happen with regional data sets).
-    if ((tile = graphreader.GetGraphTile(node)) == nullptr) {
+    if ((tile = tilecache_.Get(node)) == nullptr) {
       continue;
     }
 
@@ -566,13 +1722,14 @@ std::vector<PathInfo> PathAlgorithm::GetBestPathMM(const PathLocation& origin,
       }
 
       // Skip if the end node tile is not found
-      if ((tile = graphreader.GetGraphTile(directededge->endnode())) == nullptr) {
+      const GraphTile* endtile = tilecache_.Get(directededge->endnode());
+      if (endtile == nullptr) {
         continue;
       }
 
       // Prohibit entering the same station as the prior. Could this be done in
       // costing?
-      const NodeInfo* endnode = tile->node(directededge->endnode());
+      const NodeInfo* endnode = endtile->node(directededge->endnode());
       if (directededge->use() == Use::kTransitConnection &&
           endnode->is_transit() &&
           endnode->stop_id() == pred.prior_stopid()) {
@@ -624,12 +1781,17 @@ void PathAlgorithm::CheckIfLowerCostPath(const uint32_t idx,
 void PathAlgorithm::HandleTransitionEdge(const uint32_t level,
                     const GraphId& edgeid, const DirectedEdge* edge,
                     const EdgeLabel& pred, const uint32_t predindex) {
-  // Skip any transition edges that are not allowed.
-  if (!allow_transitions_ ||
-      (edge->trans_up() &&
+  // Skip any transition edges that are not allowed. Transitions skipped
+  // due to hierarchy limits depend on the destination, so the predecessor
+  // is noted as not fully expanded.
+  if (!allow_transitions_) {
+    return;
+  }
+  if ((edge->trans_up() &&
        !hierarchy_limits_[level].AllowUpwardTransition(pred.distance())) ||
       (edge->trans_down() &&
        !hierarchy_limits_[level].AllowDownwardTransition(pred.distance()))) {
+    deferred_.push_back(predindex);
     return;
   }
 
@@ -645,6 +1807,242 @@ void PathAlgorithm::HandleTransitionEdge(const uint32_t level,
   edgelabel_index_++;
 }
 
+// Check if the retained search tree can be reused for a route.
+bool PathAlgorithm::CanWarmStart(const PathLocation& origin,
+                                 const uint64_t warm_start_key,
+                                 const PathInfo& loop_edge_info) {
+  bool same_origin = (origin.edges().size() == warm_start_origin_.size());
+  for (uint32_t i = 0; same_origin && i < warm_start_origin_.size(); i++) {
+    same_origin = origin.edges()[i].id == warm_start_origin_[i].first &&
+                  origin.edges()[i].dist == warm_start_origin_[i].second;
+  }
+  if (same_origin && warm_start_key != 0 &&
+      warm_start_key == warm_start_key_ && epsilon_ == warm_start_epsilon_ &&
+      !loop_edge_info.edgeid.Is_Valid() && edgestatus_ != nullptr &&
+      edgelabel_index_ <= warm_start_max_labels_) {
+    return true;
+  }
+
+  // Discard any retained search tree and record the new search
+  if (edgestatus_ != nullptr) {
+    Clear();
+  }
+  if (warm_start_max_labels_ > 0 && !loop_edge_info.edgeid.Is_Valid()) {
+    warm_start_key_ = warm_start_key;
+    warm_start_epsilon_ = epsilon_;
+    warm_start_origin_.clear();
+    for (const auto& edge : origin.edges()) {
+      warm_start_origin_.emplace_back(edge.id, edge.dist);
+    }
+  }
+  return false;
+}
+
+// Prepare the retained search tree for a new destination.
+bool PathAlgorithm::ResumeSearch(GraphReader& graphreader,
+                                 const PathLocation& dest,
+                                 const std::shared_ptr<DynamicCost>& costing) {
+  // Set the A* heuristic for the new destination. The hierarchy limits
+  // (with their transition counts) belong to the retained tree so they are
+  // kept, as if the search had continued.
+  astarheuristic_.Init(dest.vertex(),
+                       costing->AStarCostFactor() * (1.0f + epsilon_));
+  best_destination_ = std::make_pair(kInvalidLabel,
+                         Cost(std::numeric_limits<float>::max(), 0.0f));
+  destinations_.clear();
+  expansions_ = 0;
+
+  // Destination edges that are already settled have their best path
+  SetDestination(graphreader, dest, costing);
+  for (auto d = destinations_.begin(); d != destinations_.end(); ) {
+    EdgeStatusInfo edgestatus = edgestatus_->Get(d->first);
+    if (edgestatus.status.set == kPermanent) {
+      uint32_t idx = edgestatus.status.index;
+      Cost cost = edgelabels_[idx].cost() + d->second;
+      if (best_destination_.first == kInvalidLabel ||
+          cost < best_destination_.second) {
+        best_destination_ = std::make_pair(idx, cost);
+      }
+      d = destinations_.erase(d);
+    } else {
+      d++;
+    }
+  }
+  if (destinations_.empty()) {
+    return true;
+  }
+
+  // Labels to search from: temporarily labeled edges (the frontier) and
+  // settled labels that were not fully expanded
+  std::vector<uint32_t> labels;
+  for (uint32_t idx = 0; idx < edgelabel_index_; idx++) {
+    if (edgestatus_->Get(edgelabels_[idx].edgeid()).status.set == kTemporary) {
+      labels.push_back(idx);
+    }
+  }
+  for (const auto idx : deferred_) {
+    const GraphId& edgeid = edgelabels_[idx].edgeid();
+    if (edgestatus_->Get(edgeid).status.set == kPermanent) {
+      edgestatus_->Set(edgeid, kTemporary, idx);
+      labels.push_back(idx);
+    }
+  }
+  deferred_.clear();
+
+  // Update the distance to the destination and the sort cost of each label
+  float mincost = std::numeric_limits<float>::max();
+  for (auto it = labels.begin(); it != labels.end(); ) {
+    EdgeLabel& label = edgelabels_[*it];
+    const GraphTile* tile = tilecache_.Get(label.edgeid());
+    const GraphTile* endtile = tilecache_.Get(label.endnode());
+    if (tile == nullptr || endtile == nullptr) {
+      it = labels.erase(it);
+      continue;
+    }
+    float dist = astarheuristic_.GetDistance(
+                    endtile->node(label.endnode())->latlng());
+    float sortcost = label.cost().cost + astarheuristic_.Get(dist);
+    label = EdgeLabel(label.predecessor(), label.edgeid(),
+                      tile->directededge(label.edgeid()), label.cost(),
+                      sortcost, dist, label.restrictions(),
+                      label.opp_local_idx(), label.mode(),
+                      label.walking_distance());
+    mincost = std::min(mincost, sortcost);
+    it++;
+  }
+
+  // Form a new adjacency list
+  if (adjacencylist_ != nullptr) {
+    adjacencylist_->Clear();
+    delete adjacencylist_;
+  }
+  uint32_t bucketsize = costing->UnitSize();
+  adjacencylist_ = new AdjacencyList(labels.empty() ? 0.0f : mincost,
+                                     kBucketCount * bucketsize, bucketsize);
+  for (const auto idx : labels) {
+    adjacencylist_->Add(idx, edgelabels_[idx].sortcost());
+  }
+  return false;
+}
+
+// Prepare the next iteration of an anytime search.
+bool PathAlgorithm::Reprioritize(const PointLL& destll,
+                                 const std::shared_ptr<DynamicCost>& costing,
+                                 const float epsilon,
+                                 std::vector<uint32_t>& improved) {
+  // Labels to search from: temporarily labeled edges and the improved
+  // settled edges. The distance to the destination is unchanged.
+  astarheuristic_.Init(destll, costing->AStarCostFactor() * (1.0f + epsilon));
+  std::vector<uint32_t> labels;
+  for (uint32_t idx = 0; idx < edgelabel_index_; idx++) {
+    if (edgestatus_->Get(edgelabels_[idx].edgeid()).status.set == kTemporary) {
+      labels.push_back(idx);
+    }
+  }
+  for (const auto idx : improved) {
+    const GraphId& edgeid = edgelabels_[idx].edgeid();
+    if (edgestatus_->Get(edgeid).status.set == kPermanent) {
+      edgestatus_->Set(edgeid, kTemporary, idx);
+      labels.push_back(idx);
+    }
+  }
+  improved.clear();
+  if (labels.empty()) {
+    return false;
+  }
+
+  // Sort costs for the new weight and a new adjacency list
+  float mincost = std::numeric_limits<float>::max();
+  for (const auto idx : labels) {
+    EdgeLabel& label = edgelabels_[idx];
+    label.SetSortCost(label.cost().cost + astarheuristic_.Get(label.distance()));
+    mincost = std::min(mincost, label.sortcost());
+  }
+  adjacencylist_->Clear();
+  delete adjacencylist_;
+  uint32_t bucketsize = costing->UnitSize();
+  adjacencylist_ = new AdjacencyList(mincost, kBucketCount * bucketsize,
+                                     bucketsize);
+  for (const auto idx : labels) {
+    adjacencylist_->Add(idx, edgelabels_[idx].sortcost());
+  }
+  return true;
+}
+
+// Set the edges of a previous route as destinations for rerouting.
+bool PathAlgorithm::SetRerouteEdges(GraphReader& graphreader,
+                                    const PathLocation& dest,
+                                    const std::vector<PathInfo>& path,
+                                    const std::shared_ptr<DynamicCost>& costing) {
+  // The previous route must end on a destination edge
+  float dest_dist = -1.0f;
+  for (const auto& edge : dest.edges()) {
+    if (edge.id == path.back().edgeid) {
+      dest_dist = edge.dist;
+    }
+  }
+  if (dest_dist < 0.0f) {
+    return false;
+  }
+
+  // Tiles from the shared cache must remain valid while costing the route
+  TileCacheReadGuard guard(shared_tilecache_, shared_tilecache_reader_);
+
+  // Cost along the previous route to the end of each edge. Transition
+  // edges have no cost and keep the predecessor (as in the search).
+  std::vector<Cost> costs;
+  costs.reserve(path.size());
+  Cost cost(0.0f, 0.0f);
+  Cost dest_cost(0.0f, 0.0f);
+  EdgeLabel pred;
+  for (uint32_t i = 0; i < path.size(); i++) {
+    const GraphId& edgeid = path[i].edgeid;
+    const GraphTile* tile = GetGraphTile(graphreader, shared_tilecache_, edgeid);
+    if (tile == nullptr) {
+      return false;
+    }
+    const DirectedEdge* directededge = tile->directededge(edgeid);
+    if (directededge->trans_up() || directededge->trans_down()) {
+      costs.push_back(cost);
+      continue;
+    }
+
+    // Transition cost and density at the start node of the edge
+    uint32_t density = 0;
+    if (i > 0) {
+      const GraphTile* nodetile = GetGraphTile(graphreader, shared_tilecache_, pred.endnode());
+      if (nodetile == nullptr) {
+        return false;
+      }
+      const NodeInfo* nodeinfo = nodetile->node(pred.endnode());
+      density = nodeinfo->density();
+      cost += costing->TransitionCost(directededge, nodeinfo, pred);
+    }
+    Cost edgecost = costing->EdgeCost(directededge, density);
+    cost += edgecost;
+    dest_cost = cost + edgecost * dest_dist;
+    costs.push_back(cost);
+    pred = EdgeLabel(kInvalidLabel, edgeid, directededge, cost, 0.0f, 0.0f,
+                     directededge->restrictions(),
+                     directededge->opp_local_idx(), mode_, 0);
+  }
+
+  // Each edge (before the destination edge) is a destination with the cost
+  // from the end of the edge to the destination. Where an edge is on the
+  // route more than once the occurrence closest to the destination is used.
+  // The cost is measured as for destination edges (see IsComplete, the label
+  // cost plus the partial edge cost) so that joining the route compares
+  // correctly with reaching a destination edge directly.
+  for (int32_t i = path.size() - 2; i >= 0; i--) {
+    if (reroute_edges_.find(path[i].edgeid) == reroute_edges_.end()) {
+      Cost remaining(dest_cost.cost - costs[i].cost,
+                     dest_cost.secs - costs[i].secs);
+      reroute_edges_[path[i].edgeid] = std::make_pair(i, remaining);
+    }
+  }
+  return true;
+}
+
 // Add an edge at the origin to the adjacency list
 void PathAlgorithm::SetOrigin(GraphReader& graphreader,
                  const PathLocation& origin,
@@ -660,8 +2058,8 @@ void PathAlgorithm::SetOrigin(GraphReader& graphreader,
   Cost loop_edge_cost {0.0f, 0.0f};
   if (loop_edge_id.Is_Valid()) {
     //grab some info about the edge and whats connected to the end of it
-    const auto node_id = graphreader.GetGraphTile(loop_edge_id)->directededge(loop_edge_id)->endnode();
-    const auto tile = graphreader.GetGraphTile(node_id);
+    const auto node_id = GetGraphTile(graphreader, shared_tilecache_, loop_edge_id)->directededge(loop_edge_id)->endnode();
+    const auto tile = GetGraphTile(graphreader, shared_tilecache_, node_id);
     const auto node_info = tile->node(node_id);
     loop_edge_cost = costing->EdgeCost(tile->directededge(loop_edge_id), node_info->density()) *
                         (1.f - origin.edges().front().dist);
@@ -678,7 +2076,7 @@ void PathAlgorithm::SetOrigin(GraphReader& graphreader,
   for (const auto& edge : (loop_edges.size() ? loop_edges : origin.edges())) {
     // Get the directed edge
     GraphId edgeid = edge.id;
-    const GraphTile* tile = graphreader.GetGraphTile(edgeid);
+    const GraphTile* tile = GetGraphTile(graphreader, shared_tilecache_, edgeid);
     const DirectedEdge* directededge = tile->directededge(edgeid);
 
     // Get cost and sort cost
@@ -704,7 +2102,7 @@ void PathAlgorithm::SetDestination(GraphReader& graphreader,
   float seconds = 0.0f;
   for (const auto& edge : dest.edges()) {
     // Keep the id and the cost to traverse the partial distance
-    const GraphTile* tile = graphreader.GetGraphTile(edge.id);
+    const GraphTile* tile = GetGraphTile(graphreader, shared_tilecache_, edge.id);
     destinations_[edge.id] = (costing->EdgeCost(tile->directededge(edge.id), 0.0f) * edge.dist);
   }
 }
@@ -718,6 +2116,13 @@ bool PathAlgorithm::IsComplete(const uint32_t edge_label_index) {
   if(best_destination_.first != kInvalidLabel && edge_label.cost() > best_destination_.second)
     return true;
 
+  //when rerouting there are many destinations (the previous route). once the
+  //sort cost (cost plus a lower bound to the destination) reaches the best
+  //cost found no other way to join the route can be better
+  if(best_destination_.first != kInvalidLabel && !reroute_edges_.empty() &&
+     edge_label.sortcost() >= best_destination_.second.cost)
+    return true;
+
   //check if its a destination
   auto p = destinations_.find(edge_label.edgeid());
   //it is indeed one of the possible destination edges
@@ -738,6 +2143,13 @@ bool PathAlgorithm::IsComplete(const uint32_t edge_label_index) {
 // Form the path from the adjacency list.
 std::vector<PathInfo> PathAlgorithm::FormPath(const uint32_t dest,
              GraphReader& graphreader, const PathInfo& loop_edge_info) {
+  // Only the destination label is needed for the cost (see GetBestCost)
+  if (cost_only_) {
+    const EdgeLabel& edgelabel = edgelabels_[dest];
+    return { PathInfo(edgelabel.mode(), edgelabel.cost().secs,
+                      edgelabel.edgeid(), edgelabel.tripid()) };
+  }
+
   // TODO - leave in for now!
   LOG_INFO("PathCost = " + std::to_string(edgelabels_[dest].cost().cost) +
            "  Iterations = " + std::to_string(edgelabel_index_));
@@ -748,6 +2160,26 @@ std::vector<PathInfo> PathAlgorithm::FormPath(const uint32_t dest,
   for(auto edgelabel_index = dest; edgelabel_index != kInvalidLabel;
       edgelabel_index = edgelabels_[edgelabel_index].predecessor()) {
     const EdgeLabel& edgelabel = edgelabels_[edgelabel_index];
+
+    // Unpack shortcut edges using the shortcut table. Edges are added in
+    // reverse order (the path is formed backwards) and the elapsed time
+    // along the shortcut is apportioned by length.
+    if (shortcuts_ != nullptr) {
+      shortcut_edges_.clear();
+      if (shortcuts_->Expand(edgelabel.edgeid(), shortcut_edges_) > 0) {
+        uint32_t predindex = edgelabel.predecessor();
+        float t0 = (predindex == kInvalidLabel) ?
+                    0.0f : edgelabels_[predindex].cost().secs;
+        float t1 = edgelabel.cost().secs;
+        for (auto it = shortcut_edges_.rbegin(); it != shortcut_edges_.rend();
+             it++) {
+          path.emplace_back(edgelabel.mode(),
+                            static_cast<uint32_t>(t0 + (t1 - t0) * it->second),
+                            it->first, edgelabel.tripid());
+        }
+        continue;
+      }
+    }
     path.emplace_back(edgelabel.mode(), edgelabel.cost().secs,
                       edgelabel.edgeid(), edgelabel.tripid());
   }
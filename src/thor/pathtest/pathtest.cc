@@ -2,11 +2,20 @@
 #include <string>
 #include <vector>
 #include <queue>
+#include <algorithm>
 #include <boost/program_options.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/optional.hpp>
 #include <boost/format.hpp>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "config.h"
 
@@ -20,7 +29,13 @@
 #include <valhalla/proto/tripdirections.pb.h>
 #include <valhalla/proto/directions_options.pb.h>
 #include <valhalla/midgard/logging.h>
+#include "thor/edgecosttable.h"
+#include "thor/overlaygraph.h"
+#include "thor/overlaymetric.h"
+#include "thor/partition.h"
 #include "thor/pathalgorithm.h"
+#include "thor/routinggraph.h"
+#include "thor/transitioncosttable.h"
 #include "thor/trippathbuilder.h"
 
 using namespace valhalla::midgard;
@@ -65,6 +80,11 @@ TripPath PathTest(GraphReader& reader, const PathLocation& origin,
   msecs =
       std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
   LOG_INFO("PathAlgorithm GetBestPath took " + std::to_string(msecs) + " ms");
+  SearchStats stats = pathalgorithm.stats();
+  LOG_INFO("Expansions = " + std::to_string(stats.expansions) +
+           "  Labels = " + std::to_string(stats.labels));
+  LOG_INFO("Tile lookups = " + std::to_string(stats.tile_lookups) +
+           "  GetGraphTile calls = " + std::to_string(stats.tile_reads));
 
   // Form output information based on pathedges
   t1 = std::chrono::high_resolution_clock::now();
@@ -84,6 +104,19 @@ TripPath PathTest(GraphReader& reader, const PathLocation& origin,
       std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
   LOG_INFO("PathAlgorithm Clear took " + std::to_string(msecs) + " ms");
 
+  // Time and distance only (no path formed, no TripPath built)
+  t1 = std::chrono::high_resolution_clock::now();
+  PathCost pathcost;
+  if (pathalgorithm.GetBestCost(origin, dest, reader, cost, pathcost)) {
+    t2 = std::chrono::high_resolution_clock::now();
+    msecs =
+        std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
+    LOG_INFO("PathAlgorithm GetBestCost took " + std::to_string(msecs) +
+             " ms: time " + std::to_string(pathcost.cost.secs) + " s  length " +
+             std::to_string(pathcost.length) + " m");
+  }
+  pathalgorithm.Clear();
+
   // Run again to see benefits of caching
   uint32_t totalms = 0;
   for (uint32_t i = 0; i < 10; i++) {
@@ -99,6 +132,357 @@ TripPath PathTest(GraphReader& reader, const PathLocation& origin,
   return trip_path;
 }
 
+/**
+ * Compare weighted A* searches (see PathAlgorithm::SetEpsilon) with the
+ * regular search: reports the average time, the expansions saved and the
+ * ratio of the path cost to the regular path cost for each epsilon. Also
+ * reports the bound and cost ratio of anytime searches by deadline.
+ */
+void WeightedTest(GraphReader& reader, const PathLocation& origin,
+                  const PathLocation& dest, std::shared_ptr<DynamicCost> cost) {
+  PathAlgorithm pathalgorithm;
+  uint32_t base_expansions = 0;
+  float base_cost = 0.0f;
+  for (float epsilon : { 0.0f, 0.05f, 0.1f, 0.25f, 0.5f, 1.0f }) {
+    pathalgorithm.SetEpsilon(epsilon);
+    uint64_t us = 0;
+    SearchStats stats;
+    for (uint32_t i = 0; i < 10; i++) {
+      auto t1 = std::chrono::high_resolution_clock::now();
+      pathalgorithm.GetBestPath(origin, dest, reader, cost);
+      auto t2 = std::chrono::high_resolution_clock::now();
+      us += std::chrono::duration_cast<std::chrono::microseconds>(t2-t1).count();
+      stats = pathalgorithm.stats();
+      pathalgorithm.Clear();
+    }
+    if (epsilon == 0.0f) {
+      base_expansions = stats.expansions;
+      base_cost = stats.path_cost;
+    }
+    LOG_INFO("Epsilon " + std::to_string(epsilon) + ": GetBestPath average " +
+             std::to_string(us / 10000) + " ms  expansions " +
+             std::to_string(stats.expansions) + " (" + std::to_string(
+                base_expansions > 0 ? 100.0f * stats.expansions / base_expansions : 0.0f) +
+             "%)  cost ratio " + std::to_string(
+                base_cost > 0.0f ? stats.path_cost / base_cost : 1.0f));
+  }
+
+  // Anytime search with a range of deadlines
+  pathalgorithm.SetEpsilon(0.0f);
+  for (uint32_t ms : { 1, 5, 20, 100 }) {
+    float bound;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    std::vector<PathInfo> path = pathalgorithm.GetBestPathAnytime(origin, dest,
+                                     reader, cost, deadline, 1.0f, bound);
+    SearchStats stats = pathalgorithm.stats();
+    pathalgorithm.Clear();
+    LOG_INFO("Anytime " + std::to_string(ms) + " ms: " + (path.empty() ?
+             std::string("no path") : "bound " + std::to_string(bound) +
+             "  expansions " + std::to_string(stats.expansions) +
+             "  cost ratio " + std::to_string(base_cost > 0.0f ?
+                stats.path_cost / base_cost : 1.0f)));
+  }
+}
+
+/**
+ * Compare the corridor search (see PathAlgorithm::GetBestPathCorridor)
+ * with the regular search: reports the average time, the expansions of
+ * all phases relative to the regular search and if the paths match.
+ */
+void CorridorTest(GraphReader& reader, const PathLocation& origin,
+                  const PathLocation& dest, std::shared_ptr<DynamicCost> cost,
+                  const float radius) {
+  PathAlgorithm pathalgorithm;
+  std::vector<PathInfo> paths[2];
+  uint32_t expansions[2] = { 0, 0 };
+  for (uint32_t corridor = 0; corridor < 2; corridor++) {
+    uint64_t us = 0;
+    for (uint32_t i = 0; i < 10; i++) {
+      auto t1 = std::chrono::high_resolution_clock::now();
+      paths[corridor] = (corridor == 0) ?
+          pathalgorithm.GetBestPath(origin, dest, reader, cost) :
+          pathalgorithm.GetBestPathCorridor(origin, dest, reader, cost, radius);
+      auto t2 = std::chrono::high_resolution_clock::now();
+      us += std::chrono::duration_cast<std::chrono::microseconds>(t2-t1).count();
+      expansions[corridor] = pathalgorithm.stats().expansions;
+      pathalgorithm.Clear();
+    }
+    LOG_INFO(std::string(corridor == 0 ? "Regular" : "Corridor") +
+             ": GetBestPath average " + std::to_string(us / 10000) +
+             " ms  expansions " + std::to_string(expansions[corridor]));
+  }
+  bool same = (paths[0].size() == paths[1].size());
+  for (uint32_t i = 0; same && i < paths[0].size(); i++) {
+    same = (paths[0][i].edgeid == paths[1][i].edgeid);
+  }
+  LOG_INFO("Corridor: expansions " + std::to_string(expansions[0] > 0 ?
+           100.0f * expansions[1] / expansions[0] : 0.0f) +
+           "% of the regular search, path " +
+           (same ? "matches" : "DIFFERS FROM") + " the regular path");
+}
+
+/**
+ * Compare the search bounded by the cost of a coarse route (see
+ * PathAlgorithm::GetBestPathBounded) with the regular search: reports the
+ * labels, pruned edges and expansions and if the paths match.
+ */
+void BoundedTest(GraphReader& reader, const PathLocation& origin,
+                 const PathLocation& dest, std::shared_ptr<DynamicCost> cost) {
+  PathAlgorithm pathalgorithm;
+  std::vector<PathInfo> paths[2];
+  for (uint32_t bounded = 0; bounded < 2; bounded++) {
+    auto t1 = std::chrono::high_resolution_clock::now();
+    paths[bounded] = (bounded == 0) ?
+        pathalgorithm.GetBestPath(origin, dest, reader, cost) :
+        pathalgorithm.GetBestPathBounded(origin, dest, reader, cost);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    SearchStats stats = pathalgorithm.stats();
+    LOG_INFO(std::string(bounded == 0 ? "Regular" : "Bounded") + ": " +
+             std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+                 t2 - t1).count()) + " ms  labels " + std::to_string(stats.labels) +
+             "  pruned " + std::to_string(stats.pruned) +
+             "  expansions " + std::to_string(stats.expansions));
+    pathalgorithm.Clear();
+  }
+  bool same = (paths[0].size() == paths[1].size());
+  for (uint32_t i = 0; same && i < paths[0].size(); i++) {
+    same = (paths[0][i].edgeid == paths[1][i].edgeid);
+  }
+  LOG_INFO(std::string("Bounded: path ") +
+           (same ? "matches" : "DIFFERS FROM") + " the regular path");
+}
+
+/**
+ * Counts the hardware cache misses of this thread using Linux perf events.
+ * Counts are 0 where perf events are not available.
+ */
+class CacheMissCounter {
+ public:
+  CacheMissCounter() : fd_(-1) {
+#ifdef __linux__
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+  }
+
+  ~CacheMissCounter() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+#endif
+  }
+
+  void Start() {
+#ifdef __linux__
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  uint64_t Stop() {
+    uint64_t count = 0;
+#ifdef __linux__
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(fd_, &count, sizeof(count)) != sizeof(count)) {
+        count = 0;
+      }
+    }
+#endif
+    return count;
+  }
+
+ protected:
+  int fd_;
+};
+
+/**
+ * Time GetBestPath on a routing graph. Returns the path and optionally the
+ * average search time in microseconds.
+ */
+std::vector<PathInfo> RoutingGraphRun(const std::string& name,
+                      GraphReader& reader, const PathLocation& origin,
+                      const PathLocation& dest, const RoutingGraph* graph,
+                      std::shared_ptr<DynamicCost> cost,
+                      EdgeCostTable* edgecosts = nullptr,
+                      TransitionCostTable* transitioncosts = nullptr,
+                      uint64_t* average_us = nullptr) {
+  PathAlgorithm pathalgorithm;
+  CacheMissCounter counter;
+  std::vector<PathInfo> path;
+  uint64_t us = 0, misses = 0;
+  uint32_t expansions = 0;
+  for (uint32_t i = 0; i < 10; i++) {
+    counter.Start();
+    auto t1 = std::chrono::high_resolution_clock::now();
+    path = (graph == nullptr) ?
+              pathalgorithm.GetBestPath(origin, dest, reader, cost) :
+              pathalgorithm.GetBestPath(origin, dest, *graph, reader, cost,
+                                        edgecosts, transitioncosts);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    misses += counter.Stop();
+    us += std::chrono::duration_cast<std::chrono::microseconds>(t2-t1).count();
+    expansions = pathalgorithm.stats().expansions;
+    pathalgorithm.Clear();
+  }
+  LOG_INFO(name + ": GetBestPath average " + std::to_string(us / 10000) +
+           " ms  expansions/sec " + std::to_string(us > 0 ?
+              uint64_t(expansions) * 10000000 / us : 0) +
+           "  cache misses/expansion " + std::to_string(expansions > 0 ?
+              float(misses) / (10.0f * expansions) : 0.0f));
+  if (average_us != nullptr) {
+    *average_us = us / 10;
+  }
+  return path;
+}
+
+/**
+ * Compare the routing graph search with the tile search. Builds a routing
+ * graph of the region around the origin and destination, checks that
+ * searches on it find the same path as the tile search and reports the
+ * expansion rate and cache misses with tile, Morton and Hilbert node order
+ * and with edge costs customized for the costing. Also times the search of
+ * a partition overlay of the graph.
+ */
+void RoutingGraphTest(GraphReader& reader, const PathLocation& origin,
+                      const PathLocation& dest,
+                      std::shared_ptr<DynamicCost> cost) {
+  // Build the graph over the bounding box of the locations (padded by about
+  // 50km so the search does not reach the edge of the region)
+  const PointLL& a = origin.vertex();
+  const PointLL& b = dest.vertex();
+  AABB2<PointLL> region(std::min(a.lng(), b.lng()) - 0.5f,
+                        std::min(a.lat(), b.lat()) - 0.5f,
+                        std::max(a.lng(), b.lng()) + 0.5f,
+                        std::max(a.lat(), b.lat()) + 0.5f);
+  auto t1 = std::chrono::high_resolution_clock::now();
+  RoutingGraph graph;
+  if (!graph.Build(reader, region)) {
+    LOG_ERROR("Could not build the routing graph");
+    return;
+  }
+  auto t2 = std::chrono::high_resolution_clock::now();
+  uint32_t msecs = std::chrono::duration_cast<std::chrono::milliseconds>(
+      t2 - t1).count();
+  LOG_INFO("RoutingGraph Build took " + std::to_string(msecs) + " ms: " +
+           std::to_string(graph.nodecount()) + " nodes " +
+           std::to_string(graph.edgecount()) + " edges");
+
+  // Run the tile search and the routing graph search in each node order
+  std::vector<PathInfo> tilepath = RoutingGraphRun("Tiles", reader, origin,
+                                                   dest, nullptr, cost);
+  std::vector<std::pair<std::string, NodeOrder>> orders = {
+    { "Tile order", NodeOrder::kTile },
+    { "Morton order", NodeOrder::kMorton },
+    { "Hilbert order", NodeOrder::kHilbert } };
+  for (const auto& order : orders) {
+    t1 = std::chrono::high_resolution_clock::now();
+    graph.Reorder(order.second);
+    t2 = std::chrono::high_resolution_clock::now();
+    msecs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        t2 - t1).count();
+    LOG_INFO(order.first + ": Reorder took " + std::to_string(msecs) + " ms");
+    std::vector<PathInfo> graphpath = RoutingGraphRun(order.first, reader,
+                                           origin, dest, &graph, cost);
+    bool same = (tilepath.size() == graphpath.size());
+    for (uint32_t i = 0; same && i < tilepath.size(); i++) {
+      same = (tilepath[i].edgeid == graphpath[i].edgeid);
+    }
+    LOG_INFO(order.first + ": path " + (same ? "matches" : "DIFFERS FROM") +
+             " the tile path");
+  }
+
+  // Time the search calling the costing for every edge (in the last order)
+  // to compare with the kernels reading the customized tables
+  uint64_t costing_us = 0;
+  RoutingGraphRun("Costing calls", reader, origin, dest, &graph, cost,
+                  nullptr, nullptr, &costing_us);
+
+  // Run with the edge costs customized for the costing (in the last order)
+  t1 = std::chrono::high_resolution_clock::now();
+  EdgeCostTable edgecosts;
+  edgecosts.Customize(graph, cost, 1, true);
+  t2 = std::chrono::high_resolution_clock::now();
+  msecs = std::chrono::duration_cast<std::chrono::milliseconds>(
+      t2 - t1).count();
+  LOG_INFO("Edge cost customization took " + std::to_string(msecs) + " ms");
+  std::vector<PathInfo> graphpath = RoutingGraphRun("Edge cost table", reader,
+                                        origin, dest, &graph, cost, &edgecosts);
+  bool same = (tilepath.size() == graphpath.size());
+  for (uint32_t i = 0; same && i < tilepath.size(); i++) {
+    same = (tilepath[i].edgeid == graphpath[i].edgeid);
+  }
+  LOG_INFO(std::string("Edge cost table: path ") +
+           (same ? "matches" : "DIFFERS FROM") + " the tile path");
+
+  // Run with the transition costs customized as well
+  t1 = std::chrono::high_resolution_clock::now();
+  TransitionCostTable transitioncosts;
+  transitioncosts.Customize(graph, cost, 1, true);
+  t2 = std::chrono::high_resolution_clock::now();
+  msecs = std::chrono::duration_cast<std::chrono::milliseconds>(
+      t2 - t1).count();
+  LOG_INFO("Transition cost customization took " + std::to_string(msecs) +
+           " ms for " + std::to_string(transitioncosts.size()) + " costs");
+  uint64_t table_us = 0;
+  graphpath = RoutingGraphRun("Transition cost table", reader, origin, dest,
+                              &graph, cost, &edgecosts, &transitioncosts,
+                              &table_us);
+  LOG_INFO("Cost tables (static dispatch): search " +
+           std::to_string(table_us) + " us vs " + std::to_string(costing_us) +
+           " us calling the costing (" + std::to_string(table_us > 0 ?
+              float(costing_us) / table_us : 0.0f) + "x)");
+  same = (tilepath.size() == graphpath.size());
+  for (uint32_t i = 0; same && i < tilepath.size(); i++) {
+    same = (tilepath[i].edgeid == graphpath[i].edgeid);
+  }
+  LOG_INFO(std::string("Transition cost table: path ") +
+           (same ? "matches" : "DIFFERS FROM") + " the tile path");
+
+  // Partition the graph, customize the overlay for the costing and search
+  // it. Overlay paths are optimal (no hierarchy limits) so they are
+  // compared to the tile path by elapsed time.
+  t1 = std::chrono::high_resolution_clock::now();
+  Partition partition;
+  partition.Build(graph, { 256, 4096, 65536 });
+  OverlayGraph overlay;
+  overlay.Build(graph, partition);
+  t2 = std::chrono::high_resolution_clock::now();
+  msecs = std::chrono::duration_cast<std::chrono::milliseconds>(
+      t2 - t1).count();
+  LOG_INFO("Partition and overlay took " + std::to_string(msecs) + " ms");
+  OverlayMetric metric;
+  metric.Customize(overlay, cost, 1, 4);
+  PathAlgorithm pathalgorithm;
+  uint64_t us = 0;
+  uint32_t expansions = 0;
+  for (uint32_t i = 0; i < 10; i++) {
+    t1 = std::chrono::high_resolution_clock::now();
+    graphpath = pathalgorithm.GetBestPath(origin, dest, overlay, metric,
+                                          reader, cost);
+    t2 = std::chrono::high_resolution_clock::now();
+    us += std::chrono::duration_cast<std::chrono::microseconds>(t2-t1).count();
+    expansions = pathalgorithm.stats().expansions;
+    pathalgorithm.Clear();
+  }
+  LOG_INFO("Overlay: GetBestPath average " + std::to_string(us / 10000) +
+           " ms  expansions " + std::to_string(expansions) +
+           "  elapsed time " + std::to_string(graphpath.empty() ? 0 :
+              graphpath.back().elapsed_time) + " s (tiles " +
+           std::to_string(tilepath.empty() ? 0 : tilepath.back().elapsed_time) +
+           " s)");
+}
+
 namespace std {
 
 //TODO: maybe move this into location.h if its actually useful elsewhere than here?
@@ -250,6 +634,10 @@ int main(int argc, char *argv[]) {
   "\n");
 
   std::string origin, destination, routetype, json, config;
+  bool routing_graph = false;
+  bool weighted = false;
+  float corridor = 0.0f;
+  bool bounded = false;
 
   options.add_options()("help,h", "Print this help message.")(
       "version,v", "Print the version of this software.")(
@@ -264,6 +652,14 @@ int main(int argc, char *argv[]) {
       "json,j",
       boost::program_options::value<std::string>(&json),
       "JSON Example: '{\"locations\":[{\"lat\":40.748174,\"lon\":-73.984984,\"type\":\"break\",\"heading\":200,\"name\":\"Empire State Building\",\"street\":\"350 5th Avenue\",\"city\":\"New York\",\"state\":\"NY\",\"postal_code\":\"10118-0110\",\"country\":\"US\"},{\"lat\":40.749231,\"lon\":-73.968703,\"type\":\"break\",\"name\":\"United Nations Headquarters\",\"street\":\"405 East 42nd Street\",\"city\":\"New York\",\"state\":\"NY\",\"postal_code\":\"10017-3507\",\"country\":\"US\"}],\"costing\":\"auto\",\"directions_options\":{\"units\":\"miles\"}}'")
+  ("routing-graph", bpo::bool_switch(&routing_graph),
+      "Also route on a routing graph of the region in tile, Morton and Hilbert node order and with customized edge costs and compare with the tile search.")
+  ("corridor", bpo::value<float>(&corridor),
+      "Also route with the two phase corridor search using a corridor of this radius (meters) and compare the expansions with the regular search.")
+  ("bounded", bpo::bool_switch(&bounded),
+      "Also route with the search bounded by the cost of a coarse route and compare the labels and expansions with the regular search.")
+  ("weighted", bpo::bool_switch(&weighted),
+      "Also route with weighted A* for a range of epsilons and with the anytime search for a range of deadlines and compare the path cost and expansions with the regular search.")
   // positional arguments
   ("config", bpo::value<std::string>(&config), "Valhalla configuration file");
 
@@ -456,6 +852,19 @@ int main(int argc, char *argv[]) {
     msecs =
         std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count();
     LOG_INFO("PathTest took " + std::to_string(msecs) + " ms");
+
+    if (routing_graph) {
+      RoutingGraphTest(reader, pathOrigin, pathDest, cost);
+    }
+    if (weighted) {
+      WeightedTest(reader, pathOrigin, pathDest, cost);
+    }
+    if (corridor > 0.0f) {
+      CorridorTest(reader, pathOrigin, pathDest, cost, corridor);
+    }
+    if (bounded) {
+      BoundedTest(reader, pathOrigin, pathDest, cost);
+    }
   }
 
   // Try the the directions
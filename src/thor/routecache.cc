@@ -0,0 +1,168 @@
+#include "thor/routecache.h"
+
+using namespace valhalla::baldr;
+
+namespace {
+
+// Percent along an edge is quantized to this many steps
+constexpr float kDistQuantization = 10000.0f;
+
+// Append the bytes of a value to a key
+template <class T>
+void append(std::string& key, const T& value) {
+  key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Append the correlated edges of a location to a key
+void append_edges(std::string& key, const PathLocation& location) {
+  append(key, static_cast<uint32_t>(location.edges().size()));
+  for (const auto& edge : location.edges()) {
+    append(key, edge.id.value);
+    append(key, static_cast<uint32_t>(edge.dist * kDistQuantization + 0.5f));
+  }
+}
+
+}
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+RouteCache::RouteCache(const size_t max_entries, const size_t max_bytes,
+                       const uint32_t ttl)
+    : max_entries_(max_entries),
+      max_bytes_(max_bytes),
+      ttl_(ttl),
+      bytes_(0),
+      hits_(0),
+      misses_(0),
+      evictions_(0) {
+}
+
+// Form the cache key for a route request
+std::string RouteCache::Key(const PathLocation& origin,
+                            const PathLocation& dest,
+                            const uint64_t costing_fingerprint) {
+  // Do not cache trivial or loop paths
+  for (const auto& origin_edge : origin.edges()) {
+    for (const auto& dest_edge : dest.edges()) {
+      if (origin_edge.id == dest_edge.id) {
+        return "";
+      }
+    }
+  }
+
+  std::string key;
+  append(key, costing_fingerprint);
+  append(key, static_cast<uint8_t>(dest.IsNode()));
+  append_edges(key, origin);
+  append_edges(key, dest);
+  return key;
+}
+
+// Get a cached route
+bool RouteCache::Get(const std::string& key, std::vector<PathInfo>& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = index_.find(key);
+  if (found == index_.end()) {
+    misses_++;
+    return false;
+  }
+
+  // Remove the route if it has expired
+  auto it = found->second;
+  if (std::chrono::steady_clock::now() >= it->expires) {
+    Remove(it);
+    evictions_++;
+    misses_++;
+    return false;
+  }
+
+  // Move to the front (most recently used)
+  entries_.splice(entries_.begin(), entries_, it);
+  path = it->path;
+  hits_++;
+  return true;
+}
+
+// Add a route to the cache
+void RouteCache::Put(const std::string& key,
+                     const std::vector<PathInfo>& path) {
+  if (!enabled() || key.empty()) {
+    return;
+  }
+
+  Entry entry;
+  entry.key = key;
+  entry.path = path;
+  entry.expires = std::chrono::steady_clock::now() + ttl_;
+  entry.bytes = sizeof(Entry) + 2 * key.size() + path.size() * sizeof(PathInfo);
+  if (entry.bytes > max_bytes_) {
+    return;
+  }
+
+  // Replace any existing entry
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = index_.find(key);
+  if (found != index_.end()) {
+    Remove(found->second);
+  }
+
+  // Evict least recently used routes until there is room
+  while (!entries_.empty() && (entries_.size() >= max_entries_ ||
+         bytes_ + entry.bytes > max_bytes_)) {
+    Remove(std::prev(entries_.end()));
+    evictions_++;
+  }
+
+  bytes_ += entry.bytes;
+  entries_.push_front(std::move(entry));
+  index_[key] = entries_.begin();
+}
+
+// Remove all cached routes
+void RouteCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  index_.clear();
+  bytes_ = 0;
+}
+
+// Remove an entry
+void RouteCache::Remove(std::list<Entry>::iterator it) {
+  bytes_ -= it->bytes;
+  index_.erase(it->key);
+  entries_.erase(it);
+}
+
+bool RouteCache::enabled() const {
+  return max_entries_ > 0;
+}
+
+size_t RouteCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+size_t RouteCache::bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+uint64_t RouteCache::hits() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hits_;
+}
+
+uint64_t RouteCache::misses() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return misses_;
+}
+
+uint64_t RouteCache::evictions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return evictions_;
+}
+
+}
+}
@@ -0,0 +1,380 @@
+#include "thor/routinggraph.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/midgard/logging.h>
+
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+
+namespace valhalla {
+namespace thor {
+
+constexpr uint32_t RoutingGraph::kInvalidNode;
+constexpr uint32_t RoutingGraph::kGraphVersion;
+
+namespace {
+
+// Quantize a lat,lng to a 65536 x 65536 grid over the world
+void Quantize(const PointLL& ll, uint32_t& x, uint32_t& y) {
+  float fx = (ll.lng() + 180.0f) * (65535.0f / 360.0f);
+  float fy = (ll.lat() + 90.0f) * (65535.0f / 180.0f);
+  x = static_cast<uint32_t>(std::min(std::max(fx, 0.0f), 65535.0f));
+  y = static_cast<uint32_t>(std::min(std::max(fy, 0.0f), 65535.0f));
+}
+
+// Snapshot section tags
+constexpr uint32_t kGraphHeaderTag   = SnapshotTag("RGHD");
+constexpr uint32_t kTilesTag         = SnapshotTag("RGTL");
+constexpr uint32_t kNodeEdgesTag     = SnapshotTag("RGNE");
+constexpr uint32_t kNodeLLsTag       = SnapshotTag("RGNL");
+constexpr uint32_t kNodesTag         = SnapshotTag("RGNI");
+constexpr uint32_t kNodeIdsTag       = SnapshotTag("RGNG");
+constexpr uint32_t kEdgesTag         = SnapshotTag("RGED");
+constexpr uint32_t kDirectedEdgesTag = SnapshotTag("RGDE");
+constexpr uint32_t kEdgeIdsTag       = SnapshotTag("RGEG");
+constexpr uint32_t kNodeRankTag      = SnapshotTag("RGNR");
+constexpr uint32_t kEdgeRankTag      = SnapshotTag("RGER");
+
+// Spread the lower 16 bits of a value to the even bits
+uint32_t SpreadBits(uint32_t v) {
+  v = (v | (v << 8)) & 0x00ff00ff;
+  v = (v | (v << 4)) & 0x0f0f0f0f;
+  v = (v | (v << 2)) & 0x33333333;
+  v = (v | (v << 1)) & 0x55555555;
+  return v;
+}
+
+}
+
+// Constructor
+RoutingGraph::RoutingGraph() {
+  storage_.node_edges.push_back(0);
+  UseStorage();
+}
+
+// Use the arrays built by the graph
+void RoutingGraph::UseStorage() {
+  tiles_.assign(storage_.tiles);
+  node_edges_.assign(storage_.node_edges);
+  node_lls_.assign(storage_.node_lls);
+  nodes_.assign(storage_.nodes);
+  node_ids_.assign(storage_.node_ids);
+  edges_.assign(storage_.edges);
+  directededges_.assign(storage_.directededges);
+  edge_ids_.assign(storage_.edge_ids);
+  node_rank_.assign(storage_.node_rank);
+  edge_rank_.assign(storage_.edge_rank);
+}
+
+// Build the graph from the tiles intersecting a region
+bool RoutingGraph::Build(GraphReader& reader, const AABB2<PointLL>& region) {
+  storage_ = Storage();
+  storage_.node_edges.push_back(0);
+  UseStorage();
+
+  // Copy the nodes and edges of each tile (in tile order). Edges of a node
+  // are contiguous in the tile, so node edge offsets are the tile's edge
+  // offset plus the node's edge index.
+  auto& node_edges = storage_.node_edges;
+  auto tile_hierarchy = reader.GetTileHierarchy();
+  for (const auto& level : tile_hierarchy.levels()) {
+    std::vector<int32_t> tileids = level.second.tiles.TileList(region);
+    std::sort(tileids.begin(), tileids.end());
+    for (auto tileid : tileids) {
+      GraphId base(tileid, level.second.level, 0);
+      if (!GraphReader::DoesTileExist(tile_hierarchy, base)) {
+        continue;
+      }
+      if (reader.OverCommitted()) {
+        reader.Clear();
+      }
+      const GraphTile* tile = reader.GetGraphTile(base);
+      if (tile == nullptr) {
+        continue;
+      }
+
+      TileRange range;
+      range.tileid = base.value;
+      range.first_node = storage_.nodes.size();
+      range.node_count = tile->header()->nodecount();
+      range.first_edge = storage_.edges.size();
+      range.edge_count = tile->header()->directededgecount();
+      GraphId nodeid = base;
+      for (uint32_t i = 0; i < range.node_count; i++, nodeid++) {
+        const NodeInfo* nodeinfo = tile->node(i);
+        if (range.first_edge + nodeinfo->edge_index() != node_edges.back()) {
+          LOG_ERROR("Edges of tile " + std::to_string(tileid) + " level " +
+                    std::to_string(level.second.level) + " are not in node order");
+          return false;
+        }
+        node_edges.push_back(node_edges.back() + nodeinfo->edge_count());
+        storage_.node_lls.push_back(nodeinfo->latlng());
+        storage_.nodes.push_back(*nodeinfo);
+        storage_.node_ids.push_back(nodeid);
+      }
+      if (node_edges.back() != range.first_edge + range.edge_count) {
+        LOG_ERROR("Edges of tile " + std::to_string(tileid) + " level " +
+                  std::to_string(level.second.level) + " are not all used by nodes");
+        return false;
+      }
+      GraphId edgeid = base;
+      for (uint32_t i = 0; i < range.edge_count; i++, edgeid++) {
+        const DirectedEdge* directededge = tile->directededge(i);
+        RoutingEdge edge;
+        edge.endnode = kInvalidNode;
+        edge.shortcut = directededge->shortcut();
+        edge.superseded = directededge->superseded();
+        edge.trans_up = directededge->trans_up();
+        edge.trans_down = directededge->trans_down();
+        edge.is_shortcut = directededge->is_shortcut();
+        edge.spare = 0;
+        edge.spare2 = 0;
+        storage_.edges.push_back(edge);
+        storage_.directededges.push_back(*directededge);
+        storage_.edge_ids.push_back(edgeid);
+      }
+      storage_.tiles.push_back(range);
+    }
+  }
+
+  // Resolve end nodes now that all tiles are known
+  std::sort(storage_.tiles.begin(), storage_.tiles.end(),
+            [](const TileRange& a, const TileRange& b) {
+              return a.tileid < b.tileid;
+            });
+  UseStorage();
+  for (uint32_t i = 0; i < storage_.edges.size(); i++) {
+    storage_.edges[i].endnode = NodeIndex(storage_.directededges[i].endnode());
+  }
+  LOG_INFO("Routing graph: " + std::to_string(tiles_.size) + " tiles, " +
+           std::to_string(nodecount()) + " nodes, " +
+           std::to_string(edgecount()) + " edges");
+  return true;
+}
+
+// Renumber the nodes and their edges
+void RoutingGraph::Reorder(const NodeOrder order) {
+  // Sort the nodes by their curve key (ties keep their current order).
+  // Tile order is the order the nodes were built in.
+  uint32_t n = nodecount();
+  std::vector<uint32_t> nodes(n);
+  std::iota(nodes.begin(), nodes.end(), 0);
+  if (order == NodeOrder::kTile) {
+    if (!node_rank_.empty()) {
+      nodes.assign(node_rank_.data, node_rank_.data + n);
+    }
+  } else {
+    std::vector<uint32_t> keys(n);
+    for (uint32_t i = 0; i < n; i++) {
+      keys[i] = (order == NodeOrder::kHilbert) ?
+                  HilbertKey(node_lls_[i]) : MortonKey(node_lls_[i]);
+    }
+    std::stable_sort(nodes.begin(), nodes.end(),
+                     [&keys](const uint32_t a, const uint32_t b) {
+                       return keys[a] < keys[b];
+                     });
+  }
+
+  // Copy the nodes and their edges in the new order
+  std::vector<uint32_t> node_rank(n), edge_rank(edgecount());
+  std::vector<uint32_t> node_edges(1, 0);
+  std::vector<PointLL> node_lls;
+  std::vector<NodeInfo> node_infos;
+  std::vector<GraphId> node_ids;
+  std::vector<RoutingEdge> edges;
+  std::vector<DirectedEdge> directededges;
+  std::vector<GraphId> edge_ids;
+  node_edges.reserve(n + 1);
+  node_lls.reserve(n);
+  node_infos.reserve(n);
+  node_ids.reserve(n);
+  edges.reserve(edgecount());
+  directededges.reserve(edgecount());
+  edge_ids.reserve(edgecount());
+  for (uint32_t i = 0; i < n; i++) {
+    uint32_t node = nodes[i];
+    node_rank[node] = i;
+    for (uint32_t e = node_edges_[node]; e < node_edges_[node + 1]; e++) {
+      edge_rank[e] = edges.size();
+      edges.push_back(edges_[e]);
+      directededges.push_back(directededges_[e]);
+      edge_ids.push_back(edge_ids_[e]);
+    }
+    node_edges.push_back(edges.size());
+    node_lls.push_back(node_lls_[node]);
+    node_infos.push_back(nodes_[node]);
+    node_ids.push_back(node_ids_[node]);
+  }
+  for (auto& edge : edges) {
+    if (edge.endnode != kInvalidNode) {
+      edge.endnode = node_rank[edge.endnode];
+    }
+  }
+
+  // Map tile order indexes to the new order
+  std::vector<uint32_t> node_ranks, edge_ranks;
+  if (order != NodeOrder::kTile) {
+    if (node_rank_.empty()) {
+      node_ranks.swap(node_rank);
+      edge_ranks.swap(edge_rank);
+    } else {
+      node_ranks.resize(n);
+      edge_ranks.resize(edgecount());
+      for (uint32_t i = 0; i < n; i++) {
+        node_ranks[i] = node_rank[node_rank_[i]];
+      }
+      for (uint32_t i = 0; i < edgecount(); i++) {
+        edge_ranks[i] = edge_rank[edge_rank_[i]];
+      }
+    }
+  }
+
+  // The reordered graph uses its own storage (the tile ranges are copied
+  // if the graph was loaded from a snapshot)
+  std::vector<TileRange> tiles(tiles_.data, tiles_.data + tiles_.size);
+  storage_.tiles.swap(tiles);
+  storage_.node_edges.swap(node_edges);
+  storage_.node_lls.swap(node_lls);
+  storage_.nodes.swap(node_infos);
+  storage_.node_ids.swap(node_ids);
+  storage_.edges.swap(edges);
+  storage_.directededges.swap(directededges);
+  storage_.edge_ids.swap(edge_ids);
+  storage_.node_rank.swap(node_ranks);
+  storage_.edge_rank.swap(edge_ranks);
+  UseStorage();
+}
+
+// Get the Morton curve key of a lat,lng
+uint32_t RoutingGraph::MortonKey(const PointLL& ll) {
+  uint32_t x, y;
+  Quantize(ll, x, y);
+  return SpreadBits(x) | (SpreadBits(y) << 1);
+}
+
+// Get the Hilbert curve key of a lat,lng
+uint32_t RoutingGraph::HilbertKey(const PointLL& ll) {
+  uint32_t x, y;
+  Quantize(ll, x, y);
+  uint32_t d = 0;
+  for (uint32_t s = 1 << 15; s > 0; s >>= 1) {
+    uint32_t rx = (x & s) ? 1 : 0;
+    uint32_t ry = (y & s) ? 1 : 0;
+    d += s * s * ((3 * rx) ^ ry);
+
+    // Rotate the quadrant
+    if (ry == 0) {
+      if (rx == 1) {
+        x = 65535 - x;
+        y = 65535 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+
+// Find the range of a tile
+const RoutingGraph::TileRange* RoutingGraph::FindTile(const GraphId& id) const {
+  uint64_t key = id.Tile_Base().value;
+  const TileRange* end = tiles_.data + tiles_.size;
+  const TileRange* tile = std::lower_bound(tiles_.data, end, key,
+      [](const TileRange& t, const uint64_t k) { return t.tileid < k; });
+  return (tile == end || tile->tileid != key) ? nullptr : tile;
+}
+
+// Get the index of a node
+uint32_t RoutingGraph::NodeIndex(const GraphId& nodeid) const {
+  const TileRange* tile = FindTile(nodeid);
+  if (tile == nullptr || nodeid.id() >= tile->node_count) {
+    return kInvalidNode;
+  }
+  uint32_t index = tile->first_node + nodeid.id();
+  return node_rank_.empty() ? index : node_rank_[index];
+}
+
+// Get the index of a directed edge
+uint32_t RoutingGraph::EdgeIndex(const GraphId& edgeid) const {
+  const TileRange* tile = FindTile(edgeid);
+  if (tile == nullptr || edgeid.id() >= tile->edge_count) {
+    return kInvalidNode;
+  }
+  uint32_t index = tile->first_edge + edgeid.id();
+  return edge_rank_.empty() ? index : edge_rank_[index];
+}
+
+// Add the arrays of the graph to a snapshot
+void RoutingGraph::Write(SnapshotWriter& writer) const {
+  graph_header_.version = kGraphVersion;
+  graph_header_.nodeinfo_size = sizeof(NodeInfo);
+  graph_header_.directededge_size = sizeof(DirectedEdge);
+  graph_header_.spare = 0;
+  writer.Add(kGraphHeaderTag, &graph_header_, sizeof(graph_header_));
+  writer.Add(kTilesTag, tiles_.data, tiles_.size * sizeof(TileRange));
+  writer.Add(kNodeEdgesTag, node_edges_.data, node_edges_.size * sizeof(uint32_t));
+  writer.Add(kNodeLLsTag, node_lls_.data, node_lls_.size * sizeof(PointLL));
+  writer.Add(kNodesTag, nodes_.data, nodes_.size * sizeof(NodeInfo));
+  writer.Add(kNodeIdsTag, node_ids_.data, node_ids_.size * sizeof(GraphId));
+  writer.Add(kEdgesTag, edges_.data, edges_.size * sizeof(RoutingEdge));
+  writer.Add(kDirectedEdgesTag, directededges_.data,
+             directededges_.size * sizeof(DirectedEdge));
+  writer.Add(kEdgeIdsTag, edge_ids_.data, edge_ids_.size * sizeof(GraphId));
+  writer.Add(kNodeRankTag, node_rank_.data, node_rank_.size * sizeof(uint32_t));
+  writer.Add(kEdgeRankTag, edge_rank_.data, edge_rank_.size * sizeof(uint32_t));
+}
+
+// Load the graph from a snapshot
+bool RoutingGraph::Load(const Snapshot& snapshot, const bool verify) {
+  size_t size = 0;
+  const char* data = snapshot.Section(kGraphHeaderTag, size);
+  if (data == nullptr || size != sizeof(GraphHeader)) {
+    LOG_ERROR("Snapshot has no routing graph");
+    return false;
+  }
+  const GraphHeader* header = reinterpret_cast<const GraphHeader*>(data);
+  if (header->version != kGraphVersion ||
+      header->nodeinfo_size != sizeof(NodeInfo) ||
+      header->directededge_size != sizeof(DirectedEdge)) {
+    LOG_ERROR("Snapshot routing graph has a different version or layout");
+    return false;
+  }
+
+  // Point the arrays at the sections, checking their sizes
+  bool valid = LoadArray(snapshot, kTilesTag, tiles_) &&
+               LoadArray(snapshot, kNodeEdgesTag, node_edges_) &&
+               LoadArray(snapshot, kNodeLLsTag, node_lls_) &&
+               LoadArray(snapshot, kNodesTag, nodes_) &&
+               LoadArray(snapshot, kNodeIdsTag, node_ids_) &&
+               LoadArray(snapshot, kEdgesTag, edges_) &&
+               LoadArray(snapshot, kDirectedEdgesTag, directededges_) &&
+               LoadArray(snapshot, kEdgeIdsTag, edge_ids_) &&
+               LoadArray(snapshot, kNodeRankTag, node_rank_) &&
+               LoadArray(snapshot, kEdgeRankTag, edge_rank_);
+  valid = valid && node_edges_.size == node_lls_.size + 1 &&
+          nodes_.size == node_lls_.size && node_ids_.size == node_lls_.size &&
+          directededges_.size == edges_.size && edge_ids_.size == edges_.size &&
+          node_edges_[node_lls_.size] == edges_.size &&
+          (node_rank_.empty() || node_rank_.size == node_lls_.size) &&
+          (edge_rank_.empty() || edge_rank_.size == edges_.size);
+  for (uint32_t i = 0; valid && verify && i < edges_.size; i++) {
+    valid = edges_[i].endnode < node_lls_.size ||
+            edges_[i].endnode == kInvalidNode;
+  }
+  storage_ = Storage();
+  if (!valid) {
+    LOG_ERROR("Snapshot routing graph is invalid");
+    storage_.node_edges.push_back(0);
+    UseStorage();
+    return false;
+  }
+  LOG_INFO("Routing graph: " + std::to_string(tiles_.size) + " tiles, " +
+           std::to_string(nodecount()) + " nodes, " +
+           std::to_string(edgecount()) + " edges");
+  return true;
+}
+
+}
+}
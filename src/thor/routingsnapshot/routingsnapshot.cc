@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/optional.hpp>
+
+#include "config.h"
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/midgard/logging.h>
+#include <valhalla/midgard/util.h>
+#include "thor/partition.h"
+#include "thor/routinggraph.h"
+#include "thor/snapshot.h"
+
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace bpo = boost::program_options;
+
+// Main method for building and verifying routing snapshots
+int main(int argc, char *argv[]) {
+  bpo::options_description options("routingsnapshot " VERSION "\n"
+  "\n"
+  " Usage: routingsnapshot [options] <config>\n"
+  "\n"
+  "routingsnapshot builds a routing graph from the tile hierarchy and writes "
+  "it to a snapshot file that thor memory maps at startup (see "
+  "thor.routing_graph.snapshot), or verifies the checksums of a snapshot "
+  "(and that it was written from the configured tiles if a config is given). "
+  "The graph can be partitioned into cells for the partition overlay (see "
+  "thor.routing_graph.overlay)."
+  "\n"
+  "\n");
+
+  std::string config, output, verify, bbox, order, cells;
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "output,o", boost::program_options::value<std::string>(&output),
+      "Output snapshot file.")(
+      "bbox,b", boost::program_options::value<std::string>(&bbox),
+      "Region to include: minlng,minlat,maxlng,maxlat (default is the world).")(
+      "order", boost::program_options::value<std::string>(&order)->default_value("hilbert"),
+      "Node order: tile|morton|hilbert.")(
+      "partition", boost::program_options::value<std::string>(&cells),
+      "Partition the graph for the overlay: maximum nodes per cell of each "
+      "level, lowest level first (e.g. 256,4096,65536).")(
+      "verify", boost::program_options::value<std::string>(&verify),
+      "Verify a snapshot file instead of building one.")
+  // positional arguments
+  ("config", bpo::value<std::string>(&config), "Valhalla configuration file");
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("config", 1);
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(
+        bpo::command_line_parser(argc, argv).options(options).positional(
+            pos_options).run(),
+        vm);
+    bpo::notify(vm);
+  } catch (std::exception &e) {
+    std::cerr << "Unable to parse command line options because: " << e.what()
+              << "\n" << "This is a bug, please report it at " PACKAGE_BUGREPORT
+              << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "routingsnapshot " << VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  // Verify the checksums and the routing graph of a snapshot, and that it
+  // was written from the configured tiles
+  if (vm.count("verify")) {
+    uint64_t tileset = 0;
+    if (vm.count("config")) {
+      boost::property_tree::ptree pt;
+      boost::property_tree::read_json(config.c_str(), pt);
+      tileset = Snapshot::TileSetId(pt.get<std::string>("mjolnir.hierarchy.tile_dir"));
+    }
+    Snapshot snapshot;
+    RoutingGraph graph;
+    if (!snapshot.Load(verify, tileset) || !snapshot.Verify() ||
+        !graph.Load(snapshot, true)) {
+      std::cerr << verify << " is not a valid snapshot\n";
+      return EXIT_FAILURE;
+    }
+    Partition partition;
+    std::cout << verify << " is valid: " << snapshot.size() << " sections, "
+              << graph.nodecount() << " nodes, " << graph.edgecount()
+              << " edges";
+    if (partition.Load(snapshot, graph.nodecount())) {
+      std::cout << ", " << partition.levels() << " partition levels";
+    }
+    std::cout << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  for (auto arg : std::vector<std::string> { "output", "config" }) {
+    if (vm.count(arg) == 0) {
+      std::cerr << "The <" << arg << "> argument was not provided, but is mandatory\n\n";
+      std::cerr << options << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  NodeOrder node_order;
+  if (order == "tile") {
+    node_order = NodeOrder::kTile;
+  } else if (order == "morton") {
+    node_order = NodeOrder::kMorton;
+  } else if (order == "hilbert") {
+    node_order = NodeOrder::kHilbert;
+  } else {
+    std::cerr << "Unknown node order " << order << "\n";
+    return EXIT_FAILURE;
+  }
+
+  AABB2<PointLL> region(-180.0f, -90.0f, 180.0f, 90.0f);
+  if (!bbox.empty()) {
+    std::vector<float> bounds;
+    std::stringstream stream(bbox);
+    std::string bound;
+    while (std::getline(stream, bound, ',')) {
+      bounds.push_back(std::stof(bound));
+    }
+    if (bounds.size() != 4) {
+      std::cerr << "Invalid bounding box " << bbox << "\n";
+      return EXIT_FAILURE;
+    }
+    region = AABB2<PointLL>(bounds[0], bounds[1], bounds[2], bounds[3]);
+  }
+
+  std::vector<uint32_t> cell_sizes;
+  if (!cells.empty()) {
+    std::stringstream stream(cells);
+    std::string size;
+    while (std::getline(stream, size, ',')) {
+      cell_sizes.push_back(std::stoul(size));
+    }
+    if (!std::is_sorted(cell_sizes.begin(), cell_sizes.end()) ||
+        cell_sizes.front() == 0) {
+      std::cerr << "Invalid cell sizes " << cells << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  //parse the config
+  boost::property_tree::ptree pt;
+  boost::property_tree::read_json(config.c_str(), pt);
+
+  //configure logging
+  boost::optional<boost::property_tree::ptree&> logging_subtree = pt
+      .get_child_optional("thor.logging");
+  if (logging_subtree) {
+    auto logging_config = valhalla::midgard::ToMap<
+        const boost::property_tree::ptree&,
+        std::unordered_map<std::string, std::string> >(logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // Build the graph, reorder it, partition it (in its final order) and
+  // write the snapshot. Identify the tiles before reading them so a tile
+  // set changed during the build does not match.
+  GraphReader reader(pt.get_child("mjolnir.hierarchy"));
+  uint64_t tileset = Snapshot::TileSetId(reader.GetTileHierarchy().tile_dir());
+  RoutingGraph graph;
+  if (!graph.Build(reader, region)) {
+    return EXIT_FAILURE;
+  }
+  graph.Reorder(node_order);
+  Partition partition;
+  SnapshotWriter writer;
+  writer.SetTileSet(tileset);
+  graph.Write(writer);
+  if (!cell_sizes.empty()) {
+    partition.Build(graph, cell_sizes);
+    partition.Write(writer);
+  }
+  if (!writer.Write(output)) {
+    LOG_ERROR("Could not write " + output);
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Wrote routing graph snapshot " + output);
+  return EXIT_SUCCESS;
+}
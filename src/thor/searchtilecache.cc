@@ -0,0 +1,52 @@
+#include "thor/searchtilecache.h"
+
+using namespace valhalla::baldr;
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+SearchTileCache::SearchTileCache()
+    : graphreader_(nullptr),
+      shared_(nullptr),
+      manifest_(nullptr) {
+  Clear();
+}
+
+// Set the graph reader (and shared cache) and clear the cache
+void SearchTileCache::Init(GraphReader& graphreader, TileCache* shared) {
+  graphreader_ = &graphreader;
+  shared_ = shared;
+  Clear();
+}
+
+// Set a manifest to record tile use in
+void SearchTileCache::SetManifest(TileManifest* manifest) {
+  Flush();
+  manifest_ = manifest;
+}
+
+// Add the tile use counted since the last flush to the manifest
+void SearchTileCache::Flush() {
+  if (manifest_ != nullptr) {
+    for (const auto& use : uses_) {
+      manifest_->Record(use.second.tileid, use.second.size, use.second.count);
+    }
+  }
+  uses_.clear();
+}
+
+// Clear the cached tiles and the lookup counts
+void SearchTileCache::Clear() {
+  Flush();
+  for (uint32_t i = 0; i < kCacheSize; i++) {
+    tileids_[i] = GraphId().value;
+    tiles_[i] = nullptr;
+  }
+  next_ = 0;
+  lookups_ = 0;
+  reads_ = 0;
+}
+
+}
+}
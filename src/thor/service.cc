@@ -1,12 +1,18 @@
+#include <algorithm>
+#include <chrono>
 #include <functional>
+#include <limits>
 #include <string>
 #include <stdexcept>
 #include <vector>
 #include <unordered_map>
 #include <cstdint>
 #include <sstream>
+#include <memory>
+#include <thread>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/info_parser.hpp>
+#include <boost/property_tree/json_parser.hpp>
 
 #include <prime_server/prime_server.hpp>
 #include <prime_server/http_protocol.hpp>
@@ -25,6 +31,22 @@ using namespace prime_server;
 #include "thor/service.h"
 #include "thor/trippathbuilder.h"
 #include "thor/pathalgorithm.h"
+#include "thor/pathcost.h"
+#include "thor/routecache.h"
+#include "thor/routinggraph.h"
+#include "thor/asynctileloader.h"
+#include "thor/concurrenttilecache.h"
+#include "thor/edgecosttable.h"
+#include "thor/overlaygraph.h"
+#include "thor/overlaymetric.h"
+#include "thor/partition.h"
+#include "thor/shortcuttable.h"
+#include "thor/snapshot.h"
+#include "thor/synchronizedtilecache.h"
+#include "thor/tilearchive.h"
+#include "thor/tilemanifest.h"
+#include "thor/tileprefetcher.h"
+#include "thor/transitioncosttable.h"
 
 using namespace valhalla;
 using namespace valhalla::midgard;
@@ -33,23 +55,107 @@ using namespace valhalla::sif;
 
 
 namespace {
+  // Log route cache statistics after this many lookups
+  constexpr uint64_t kRouteCacheLogInterval = 1000;
+
+  // Log shared tile cache statistics after this many requests (per worker)
+  constexpr uint64_t kTileCacheLogInterval = 1000;
+
+  // Configuration of the per worker graph reader. With a shared tile cache
+  // searches and trip path building read their tiles from the shared cache,
+  // so the reader only keeps tiles read by other code paths (multimodal
+  // searches) and its cache is capped (thor.tile_cache.reader_max_bytes).
+  boost::property_tree::ptree reader_config(const boost::property_tree::ptree& config,
+                                            const bool shared_tilecache) {
+    boost::property_tree::ptree hierarchy = config.get_child("mjolnir.hierarchy");
+    if (shared_tilecache) {
+      size_t max_bytes = config.get<size_t>("thor.tile_cache.reader_max_bytes", 16777216);
+      hierarchy.put("max_cache_size", std::min(max_bytes,
+          hierarchy.get<size_t>("max_cache_size", max_bytes)));
+    }
+    return hierarchy;
+  }
+
+  // Register the edge/node costing methods
+  void register_costings(sif::CostFactory<sif::DynamicCost>& factory) {
+    factory.Register("auto", sif::CreateAutoCost);
+    factory.Register("auto_shorter", sif::CreateAutoShorterCost);
+    factory.Register("bicycle", sif::CreateBicycleCost);
+    factory.Register("pedestrian", sif::CreatePedestrianCost);
+    factory.Register("transit", sif::CreateTransitCost);
+  }
+
+  // Fingerprint of a costing method and its merged options so routes and
+  // customized costs can be kept per distinct costing
+  uint64_t costing_fingerprint(const std::string& costing,
+                               const boost::property_tree::ptree& options) {
+    std::stringstream json;
+    boost::property_tree::write_json(json, options, false);
+    return std::hash<std::string>()(costing + json.str());
+  }
+
+  // Routing graph costs of the default costing with the config's options,
+  // customized eagerly at startup. Searches only read them so all workers
+  // share them. Requests with other costings or options use the lazily
+  // customized tables of their worker.
+  struct default_costs_t {
+    uint64_t fingerprint;
+    thor::EdgeCostTable edgecosts;
+    thor::TransitionCostTable transitioncosts;
+  };
+
   //TODO: throw this in the header to make it testable?
   class thor_worker_t {
    public:
-    thor_worker_t(const boost::property_tree::ptree& config): config(config),
-    origin(PointLL()), destination(PointLL()), reader(config.get_child("mjolnir.hierarchy")) {
+    thor_worker_t(const boost::property_tree::ptree& config,
+                  thor::TileCache* tilecache, thor::TilePrefetcher* prefetcher,
+                  thor::TileManifest* manifest, const thor::RoutingGraph* graph,
+                  default_costs_t* default_costs,
+                  const thor::OverlayGraph* overlay, thor::RouteCache* route_cache): config(config),
+    origin(PointLL()), destination(PointLL()), reader(reader_config(config, tilecache != nullptr)),
+    route_cache(route_cache),
+    costing_fingerprint(0), search_key(0),
+    max_epsilon(config.get<float>("thor.max_epsilon", 1.0f)),
+    deadline(0), anytime_epsilon(config.get<float>("thor.anytime_epsilon", 1.0f)),
+    corridor_radius(config.get<float>("thor.corridor_radius", 0.0f)),
+    cost_bound(config.get<bool>("thor.cost_bound", false)),
+    tilecache(tilecache), manifest(manifest),
+    manifest_file(config.get<std::string>("thor.warmup.manifest", "")),
+    manifest_interval(std::max(config.get<uint64_t>("thor.warmup.write_interval", 10000), uint64_t(1))),
+    graph(graph), default_costs(default_costs),
+    use_edge_costs(config.get<bool>("thor.routing_graph.edge_costs", true)),
+    use_transition_costs(config.get<bool>("thor.routing_graph.transition_costs", true)),
+    overlay(overlay),
+    overlay_threads(std::max(config.get<uint32_t>("thor.routing_graph.overlay_threads", 4), 1u)),
+    requests(0) {
       // Register edge/node costing methods
-      factory.Register("auto", sif::CreateAutoCost);
-      factory.Register("auto_shorter", sif::CreateAutoShorterCost);
-      factory.Register("bicycle", sif::CreateBicycleCost);
-      factory.Register("pedestrian", sif::CreatePedestrianCost);
-      factory.Register("transit", sif::CreateTransitCost);
+      register_costings(factory);
+
+      // Optionally use a tile cache shared with other worker threads and
+      // load tiles ahead of the search frontier in the background
+      path_algorithm.SetTileCache(tilecache);
+      path_algorithm.SetPrefetcher(prefetcher);
+
+      // Optionally record the tiles searches use for warm-up on restart
+      path_algorithm.SetTileManifest(manifest);
+
+      // Optionally unpack shortcuts using a precomputed shortcut table
+      auto shortcut_table = config.get_optional<std::string>("thor.shortcut_table");
+      if (shortcut_table && shortcuts.Load(*shortcut_table)) {
+        path_algorithm.SetShortcutTable(&shortcuts);
+      }
+
+      // Optionally keep the search tree between routes from the same origin
+      uint32_t max_labels = config.get<uint32_t>("thor.warm_start.max_labels", 0);
+      path_algorithm.SetWarmStart(max_labels);
+      warm_start = max_labels > 0;
     }
     worker_t::result_t work(const std::list<zmq::message_t>& job, void* request_info) {
       auto& info = *static_cast<http_request_t::info_t*>(request_info);
       LOG_INFO("Got Thor Request " + std::to_string(info.id));
       try{
         //get some info about what we need to do
+        auto start = std::chrono::steady_clock::now();
         std::string request_str(static_cast<const char*>(job.front().data()), job.front().size());
         std::stringstream stream(request_str);
         boost::property_tree::ptree request;
@@ -58,6 +164,15 @@ namespace {
         // Initialize request - check if multimodal
         bool multimodal = init_request(request);
 
+        // Time and distance only requests are answered here: no path is
+        // formed and odin is skipped
+        if (request.get<bool>("cost_only", false)) {
+          if (multimodal) {
+            throw std::runtime_error("cost_only is not supported for multimodal routes");
+          }
+          return cost_only(info);
+        }
+
         // Find the path. Multimodal is a separate case.
         std::vector<thor::PathInfo> path_edges;
         if (multimodal) {
@@ -66,8 +181,87 @@ namespace {
             throw std::runtime_error("No path could be found for input");
           }
         } else {
+          // Use a cached route for the same edges and costing if we have one
+          std::string cache_key;
+          bool cached = false;
+          if (route_cache->enabled()) {
+            cache_key = thor::RouteCache::Key(origin, destination, search_key);
+            if (!cache_key.empty()) {
+              cached = route_cache->Get(cache_key, path_edges);
+              uint64_t hits = route_cache->hits(), misses = route_cache->misses();
+              if ((hits + misses) % kRouteCacheLogInterval == 0) {
+                LOG_INFO("Route cache: hits = " + std::to_string(hits) +
+                         " misses = " + std::to_string(misses) +
+                         " routes = " + std::to_string(route_cache->size()) +
+                         " bytes = " + std::to_string(route_cache->bytes()));
+              }
+            }
+          }
+
           //find a path
-          path_edges = path_algorithm.GetBestPath(origin, destination, reader, cost);
+          float bound = 0.0f;
+          if (path_edges.size() == 0) {
+            if (deadline > 0) {
+              // Anytime search: the best route found by the deadline,
+              // possibly suboptimal
+              path_edges = path_algorithm.GetBestPathAnytime(origin, destination,
+                  reader, cost, start + std::chrono::milliseconds(deadline),
+                  anytime_epsilon, bound);
+              if (path_edges.size() == 0) {
+                throw std::runtime_error("No path could be found before the deadline");
+              }
+              if (bound > 0.0f) {
+                request.put("suboptimal", true);
+                if (bound < std::numeric_limits<float>::max()) {
+                  request.put("suboptimality_bound", bound);
+                }
+                std::stringstream tagged;
+                boost::property_tree::write_info(tagged, request);
+                request_str = tagged.str();
+              }
+            } else if (overlay != nullptr) {
+              // Customize the overlay for the costing options (once per
+              // set of options) and search it
+              metric.Customize(*overlay, cost, costing_fingerprint, overlay_threads);
+              path_edges = path_algorithm.GetBestPath(origin, destination,
+                  *overlay, metric, reader, cost);
+            } else if (graph != nullptr) {
+              // The default costing uses the costs shared by all workers.
+              // Other costings customize this worker's tables (recomputed
+              // as the searches reach edges and nodes when the costing
+              // options change).
+              thor::EdgeCostTable* edges = nullptr;
+              thor::TransitionCostTable* transitions = nullptr;
+              if (default_costs != nullptr &&
+                  default_costs->fingerprint == costing_fingerprint) {
+                edges = &default_costs->edgecosts;
+                transitions = &default_costs->transitioncosts;
+              } else {
+                edges = &edgecosts;
+                transitions = &transitioncosts;
+                if (use_edge_costs) {
+                  edgecosts.Customize(*graph, cost, costing_fingerprint, false);
+                }
+                if (use_transition_costs) {
+                  transitioncosts.Customize(*graph, cost, costing_fingerprint, false);
+                }
+              }
+              path_edges = path_algorithm.GetBestPath(origin, destination, *graph,
+                  reader, cost, use_edge_costs ? edges : nullptr,
+                  use_transition_costs ? transitions : nullptr);
+            } else if (corridor_radius > 0.0f) {
+              // Search a corridor around a coarse highway route
+              path_edges = path_algorithm.GetBestPathCorridor(origin, destination,
+                  reader, cost, corridor_radius);
+            } else if (cost_bound) {
+              // Prune the search with the cost of a coarse highway route
+              path_edges = path_algorithm.GetBestPathBounded(origin, destination,
+                  reader, cost);
+            } else {
+              path_edges = path_algorithm.GetBestPath(origin, destination, reader,
+                                                      cost, search_key);
+            }
+          }
           if (path_edges.size() == 0) {
             if (cost->AllowMultiPass()) {
               LOG_INFO("Try again with relaxed hierarchy limits");
@@ -84,10 +278,15 @@ namespace {
               throw std::runtime_error("No path could be found for input");
             }
           }
+          if (!cached && bound == 0.0f) {
+            route_cache->Put(cache_key, path_edges);
+          }
         }
 
         // Form output information based on path edges
-        auto trip_path = thor::TripPathBuilder::Build(reader, path_edges, origin, destination);
+        auto trip_path = thor::TripPathBuilder::Build(reader, path_edges,
+            origin, destination, path_algorithm.tile_cache(),
+            path_algorithm.tile_cache_reader());
 
         //pass it on
         worker_t::result_t result{true};
@@ -104,6 +303,41 @@ namespace {
       }
     }
 
+    // Find the time, distance and cost of the best path with one search
+    worker_t::result_t cost_only(http_request_t::info_t& info) {
+      thor::PathCost pathcost;
+      bool found = path_algorithm.GetBestCost(origin, destination, reader,
+                                              cost, pathcost, search_key);
+      if (!found && cost->AllowMultiPass()) {
+        LOG_INFO("Try again with relaxed hierarchy limits");
+        path_algorithm.Clear();
+        cost->RelaxHierarchyLimits(16.0f);
+        found = path_algorithm.GetBestCost(origin, destination, reader, cost, pathcost);
+      }
+      if (!found) {
+        path_algorithm.Clear();
+        cost->DisableHighwayTransitions();
+        found = path_algorithm.GetBestCost(origin, destination, reader, cost, pathcost);
+        if (!found) {
+          throw std::runtime_error("No path could be found for input");
+        }
+      }
+
+      // Time in seconds and distance in meters
+      auto json = json::map({
+        {"time", static_cast<uint64_t>(pathcost.cost.secs + 0.5f)},
+        {"distance", static_cast<uint64_t>(pathcost.length + 0.5f)},
+        {"cost", static_cast<uint64_t>(pathcost.cost.cost + 0.5f)}
+      });
+      std::stringstream stream;
+      stream << *json;
+      worker_t::result_t result{false};
+      http_response_t response(200, "OK", stream.str());
+      response.from_info(info);
+      result.messages.emplace_back(response.to_string());
+      return result;
+    }
+
     // Get the costing options. Get the base options from the config and the
     // options for the specified costing method. Merge in any request costing
     // options.
@@ -120,6 +354,10 @@ namespace {
           config_costing.put_child(r.first, r.second);
         }
       }
+
+      // Fingerprint the costing method and its merged options so routes can
+      // be cached per distinct costing
+      costing_fingerprint = ::costing_fingerprint(costing, config_costing);
       return factory.Create(costing, config_costing);
     }
 
@@ -156,6 +394,19 @@ namespace {
         throw std::runtime_error("No edge/node costing provided");
       }
 
+      // Optionally trade optimality for speed: the route costs at most
+      // (1 + epsilon) times the regular route
+      float epsilon = request.get<float>("epsilon", 0.0f);
+      if (!(epsilon >= 0.0f && epsilon <= max_epsilon)) {
+        throw std::runtime_error("epsilon must be between 0 and " +
+                                 std::to_string(max_epsilon));
+      }
+      path_algorithm.SetEpsilon(epsilon);
+
+      // Optionally return the best route found by a deadline (milliseconds
+      // from receiving the request) rather than the optimal route
+      deadline = request.get<uint32_t>("deadline", 0);
+
       // Construct costing. For multi-modal we construct costing for all modes
       if (costing == "multimodal") {
         mode_costing[0] = get_costing(request, "auto");
@@ -165,12 +416,44 @@ namespace {
         return true;
       } else {
         cost = get_costing(request, costing);
+
+        // Routes and search trees of weighted searches are kept apart from
+        // those of the regular search
+        search_key = costing_fingerprint;
+        if (epsilon > 0.0f) {
+          search_key = std::hash<std::string>()(std::to_string(costing_fingerprint) +
+                                                "/" + std::to_string(epsilon));
+        }
         return false;
       }
     }
     void cleanup() {
-      path_algorithm.Clear();
+      // The search tree is kept for the next request when warm starting
+      if (!warm_start) {
+        path_algorithm.Clear();
+      }
       locations.clear();
+
+      // Release the tiles of the graph reader once over its cache size
+      if (reader.OverCommitted()) {
+        reader.Clear();
+      }
+
+      // Log shared tile cache statistics
+      requests++;
+      if (tilecache != nullptr && requests % kTileCacheLogInterval == 0) {
+        auto stats = tilecache->stats();
+        LOG_INFO("Tile cache: hits = " + std::to_string(stats.hits) +
+                 " misses = " + std::to_string(stats.misses) +
+                 " evictions = " + std::to_string(stats.evictions) +
+                 " bytes = " + std::to_string(stats.bytes));
+      }
+
+      // Write the tile manifest
+      if (manifest != nullptr && requests % manifest_interval == 0 &&
+          !manifest->Write(manifest_file)) {
+        LOG_ERROR("Could not write tile manifest " + manifest_file);
+      }
     }
    protected:
     boost::property_tree::ptree config;
@@ -181,6 +464,30 @@ namespace {
     valhalla::sif::cost_ptr_t mode_costing[4];    // TODO - max # of modes?
     valhalla::baldr::GraphReader reader;
     valhalla::thor::PathAlgorithm path_algorithm;
+    valhalla::thor::ShortcutTable shortcuts;
+    valhalla::thor::RouteCache* route_cache;
+    uint64_t costing_fingerprint;
+    uint64_t search_key;
+    float max_epsilon;
+    uint32_t deadline;
+    float anytime_epsilon;
+    float corridor_radius;
+    bool cost_bound;
+    bool warm_start;
+    valhalla::thor::TileCache* tilecache;
+    valhalla::thor::TileManifest* manifest;
+    std::string manifest_file;
+    uint64_t manifest_interval;
+    const valhalla::thor::RoutingGraph* graph;
+    default_costs_t* default_costs;
+    valhalla::thor::EdgeCostTable edgecosts;
+    bool use_edge_costs;
+    valhalla::thor::TransitionCostTable transitioncosts;
+    bool use_transition_costs;
+    const valhalla::thor::OverlayGraph* overlay;
+    valhalla::thor::OverlayMetric metric;
+    uint32_t overlay_threads;
+    uint64_t requests;
   };
 }
 
@@ -194,13 +501,141 @@ namespace valhalla {
       //or returns just location information back to the server
       auto loopback_endpoint = config.get<std::string>("httpd.service.loopback");
 
+      //number of worker threads. each has its own search context and with
+      //more than one they share a tile cache (lock-free lookups unless the
+      //mutex guarded cache is configured). the concurrent cache is limited
+      //in size and evicts tiles (except highway tiles) beyond the limit
+      uint32_t threads = std::max(config.get<uint32_t>("thor.service.threads", 1), 1u);
+      baldr::TileHierarchy hierarchy = GraphReader(config.get_child("mjolnir.hierarchy")).GetTileHierarchy();
+
+      //optionally read tiles from a memory mapped tile archive (see
+      //tilearchiver) or read batches of tile files concurrently instead of
+      //one file at a time. tiles are only read through the shared cache so
+      //one is used even with a single thread. searches and trip path
+      //building read every tile through that cache, so with an archive the
+      //tile_dir is not read and need not exist
+      TileArchive archive;
+      std::unique_ptr<TileLoader> loader;
+      auto archive_file = config.get<std::string>("thor.tile_archive", "");
+      if (!archive_file.empty()) {
+        if (!archive.Load(archive_file))
+          throw std::runtime_error("Could not load tile archive " + archive_file);
+        loader.reset(new ArchiveTileLoader(archive));
+      } else if (config.get<std::string>("thor.tile_loader.type", "file") == "async") {
+        loader.reset(new AsyncTileLoader(hierarchy,
+            config.get<uint32_t>("thor.tile_loader.threads", 8),
+            config.get<uint32_t>("thor.tile_loader.queue_depth", 64)));
+      }
+
+      //optionally record the tiles used into a manifest and, on startup,
+      //preload the most used tiles of the previous run into the shared cache
+      //before taking requests (within a memory budget)
+      std::unique_ptr<TileManifest> manifest;
+      auto manifest_file = config.get<std::string>("thor.warmup.manifest", "");
+      if (!manifest_file.empty()) {
+        manifest.reset(new TileManifest);
+        if (!manifest->Load(manifest_file))
+          LOG_INFO("No tile manifest " + manifest_file + " - skipping warm-up");
+      }
+
+      std::unique_ptr<TileCache> tilecache;
+      if (threads > 1 || loader || manifest) {
+        if (config.get<std::string>("thor.tile_cache.type", "concurrent") == "synchronized") {
+          tilecache.reset(new SynchronizedTileCache(hierarchy, loader.get()));
+        } else {
+          // One reader per worker thread (each worker's search registers one)
+          tilecache.reset(new ConcurrentTileCache(hierarchy,
+              config.get<size_t>("thor.tile_cache.max_bytes", 0), loader.get(),
+              threads));
+        }
+      }
+
+      //optionally load tiles ahead of the search frontiers in the background
+      std::unique_ptr<TilePrefetcher> prefetcher;
+      if (config.get<bool>("thor.tile_prefetch", false)) {
+        prefetcher.reset(new TilePrefetcher(hierarchy, tilecache.get()));
+      }
+
+      if (manifest && manifest->size() > 0) {
+        auto tiles = manifest->Top(config.get<uint32_t>("thor.warmup.max_tiles", 100000),
+                                   config.get<size_t>("thor.warmup.max_bytes", 268435456));
+        LOG_INFO("Warming up " + std::to_string(tiles.size()) + " tiles");
+        TileManifest::Warmup(*tilecache, tiles, config.get<uint32_t>("thor.warmup.threads", 8));
+        auto stats = tilecache->stats();
+        LOG_INFO("Warm-up done: " + std::to_string(stats.bytes) + " bytes cached");
+      }
+
+      //optionally route on a routing graph memory mapped from a snapshot
+      //(see routingsnapshot) rather than on the tiles. the snapshot is
+      //shared between processes through the page cache and must have been
+      //written from the tiles in use
+      Snapshot snapshot;
+      std::unique_ptr<RoutingGraph> graph;
+      auto snapshot_file = config.get<std::string>("thor.routing_graph.snapshot", "");
+      if (!snapshot_file.empty()) {
+        graph.reset(new RoutingGraph);
+        bool verify = config.get<bool>("thor.routing_graph.verify", false);
+        if (!snapshot.Load(snapshot_file, Snapshot::TileSetId(hierarchy.tile_dir())) ||
+            (verify && !snapshot.Verify()) || !graph->Load(snapshot, verify))
+          throw std::runtime_error("Could not load routing graph snapshot " + snapshot_file);
+      }
+
+      //optionally search a partition overlay of the routing graph (the
+      //snapshot must have a partition, see routingsnapshot --partition).
+      //each worker customizes the overlay for the costing options it sees
+      Partition partition;
+      std::unique_ptr<OverlayGraph> overlay;
+      if (graph && config.get<bool>("thor.routing_graph.overlay", false)) {
+        if (!partition.Load(snapshot, graph->nodecount()))
+          throw std::runtime_error("Routing graph snapshot has no partition " + snapshot_file);
+        overlay.reset(new OverlayGraph);
+        overlay->Build(*graph, partition);
+      }
+
+      //customize the routing graph costs of the default costing with the
+      //config's options once, shared by all workers (12 bytes per edge
+      //rather than per edge per worker). the overlay has its own metric
+      std::unique_ptr<default_costs_t> default_costs;
+      auto default_costing = config.get<std::string>("thor.routing_graph.default_costing", "auto");
+      auto default_options = config.get_child_optional("costing_options." + default_costing);
+      if (graph && !overlay && default_options) {
+        sif::CostFactory<sif::DynamicCost> factory;
+        register_costings(factory);
+        auto costing = factory.Create(default_costing, *default_options);
+        default_costs.reset(new default_costs_t);
+        default_costs->fingerprint = costing_fingerprint(default_costing, *default_options);
+        if (config.get<bool>("thor.routing_graph.edge_costs", true)) {
+          default_costs->edgecosts.Customize(*graph, costing, default_costs->fingerprint, true);
+        }
+        if (config.get<bool>("thor.routing_graph.transition_costs", true)) {
+          default_costs->transitioncosts.Customize(*graph, costing, default_costs->fingerprint, true);
+        }
+      }
+
+      //cache of recent routes shared by the workers (the limits are for the
+      //whole process)
+      RouteCache route_cache(config.get<size_t>("thor.route_cache.max_entries", 0),
+                             config.get<size_t>("thor.route_cache.max_bytes", 67108864),
+                             config.get<uint32_t>("thor.route_cache.ttl", 300));
+
       //listen for requests
       zmq::context_t context;
-      thor_worker_t thor_worker(config);
-      prime_server::worker_t worker(context, upstream_endpoint, downstream_endpoint, loopback_endpoint,
-        std::bind(&thor_worker_t::work, std::ref(thor_worker), std::placeholders::_1, std::placeholders::_2),
-        std::bind(&thor_worker_t::cleanup, std::ref(thor_worker)));
-      worker.work();
+      auto work = [&]() {
+        thor_worker_t thor_worker(config, tilecache.get(), prefetcher.get(), manifest.get(), graph.get(),
+                                  default_costs.get(), overlay.get(), &route_cache);
+        prime_server::worker_t worker(context, upstream_endpoint, downstream_endpoint, loopback_endpoint,
+          std::bind(&thor_worker_t::work, std::ref(thor_worker), std::placeholders::_1, std::placeholders::_2),
+          std::bind(&thor_worker_t::cleanup, std::ref(thor_worker)));
+        worker.work();
+      };
+      std::vector<std::thread> workers;
+      for (uint32_t i = 1; i < threads; i++) {
+        workers.emplace_back(work);
+      }
+      work();
+      for (auto& worker : workers) {
+        worker.join();
+      }
 
       //TODO: should we listen for SIGINT and terminate gracefully/exit(0)?
     }
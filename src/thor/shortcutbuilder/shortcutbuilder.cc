@@ -0,0 +1,198 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/optional.hpp>
+
+#include "config.h"
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/midgard/logging.h>
+#include "thor/pathalgorithm.h"
+#include "thor/shortcuttable.h"
+
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace bpo = boost::program_options;
+
+/**
+ * Recovers the local level edges that make up shortcut edges using the
+ * same method as path formation (PathAlgorithm::RecoverShortcut).
+ */
+class ShortcutRecovery : public PathAlgorithm {
+ public:
+  /**
+   * Recover the edges that make up a shortcut.
+   * @param  reader      Graph reader.
+   * @param  shortcutid  GraphId of the shortcut edge.
+   * @param  shortcut    Shortcut directed edge.
+   * @param  edges       Returns the edges (in path order) along with the
+   *                     fraction of the shortcut length at the end of each.
+   * @return  Returns true if the shortcut was recovered.
+   */
+  bool Recover(GraphReader& reader, const GraphId& shortcutid,
+               const DirectedEdge* shortcut,
+               std::vector<std::pair<GraphId, float>>& edges) {
+    // Start and end nodes of the shortcut on the local level. The end node
+    // is the start node of the opposing edge.
+    GraphId startnode = GetStartNode(reader, shortcut);
+    GraphId oppedgeid = reader.GetOpposingEdgeId(shortcutid);
+    const GraphTile* tile = reader.GetGraphTile(oppedgeid);
+    if (tile == nullptr) {
+      return false;
+    }
+    GraphId endnode = GetStartNode(reader, tile->directededge(oppedgeid));
+
+    // Recover the edges (they are returned in reverse order)
+    std::vector<GraphId> edgeids;
+    if (!RecoverShortcut(reader, startnode, endnode, shortcut,
+                         edgeids).Is_Valid()) {
+      return false;
+    }
+
+    // Add edges in path order with the fraction of the total length
+    std::vector<uint32_t> lengths;
+    float total = 0.0f;
+    for (auto it = edgeids.rbegin(); it != edgeids.rend(); it++) {
+      const GraphTile* t = reader.GetGraphTile(*it);
+      lengths.push_back(t->directededge(*it)->length());
+      total += lengths.back();
+    }
+    float length = 0.0f;
+    uint32_t i = 0;
+    for (auto it = edgeids.rbegin(); it != edgeids.rend(); it++, i++) {
+      length += lengths[i];
+      edges.emplace_back(*it, (total > 0.0f) ? length / total : 1.0f);
+    }
+    return true;
+  }
+};
+
+// Main method for building the shortcut table
+int main(int argc, char *argv[]) {
+  bpo::options_description options("shortcutbuilder " VERSION "\n"
+  "\n"
+  " Usage: shortcutbuilder [options] <config>\n"
+  "\n"
+  "shortcutbuilder recovers the local edges that make up every shortcut "
+  "edge in the tile hierarchy and writes them to a shortcut table that "
+  "thor uses to unpack shortcuts when forming paths."
+  "\n"
+  "\n");
+
+  std::string config, output;
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "output,o", boost::program_options::value<std::string>(&output),
+      "Output shortcut table file.")
+  // positional arguments
+  ("config", bpo::value<std::string>(&config), "Valhalla configuration file");
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("config", 1);
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(
+        bpo::command_line_parser(argc, argv).options(options).positional(
+            pos_options).run(),
+        vm);
+    bpo::notify(vm);
+  } catch (std::exception &e) {
+    std::cerr << "Unable to parse command line options because: " << e.what()
+              << "\n" << "This is a bug, please report it at " PACKAGE_BUGREPORT
+              << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "shortcutbuilder " << VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  for (auto arg : std::vector<std::string> { "output", "config" }) {
+    if (vm.count(arg) == 0) {
+      std::cerr << "The <" << arg << "> argument was not provided, but is mandatory\n\n";
+      std::cerr << options << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  //parse the config
+  boost::property_tree::ptree pt;
+  boost::property_tree::read_json(config.c_str(), pt);
+
+  //configure logging
+  boost::optional<boost::property_tree::ptree&> logging_subtree = pt
+      .get_child_optional("thor.logging");
+  if (logging_subtree) {
+    auto logging_config = valhalla::midgard::ToMap<
+        const boost::property_tree::ptree&,
+        std::unordered_map<std::string, std::string> >(logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // Iterate through all tiles above the local level and recover each
+  // shortcut edge
+  GraphReader reader(pt.get_child("mjolnir.hierarchy"));
+  auto tile_hierarchy = reader.GetTileHierarchy();
+  auto local_level = tile_hierarchy.levels().rbegin()->second.level;
+  ShortcutRecovery recovery;
+  ShortcutTable::shortcut_map_t shortcuts;
+  uint32_t failed = 0;
+  for (const auto& level : tile_hierarchy.levels()) {
+    if (level.second.level == local_level) {
+      continue;
+    }
+    uint32_t ntiles = level.second.tiles.TileCount();
+    for (uint32_t tileid = 0; tileid < ntiles; tileid++) {
+      GraphId tile_id(tileid, level.second.level, 0);
+      if (!GraphReader::DoesTileExist(tile_hierarchy, tile_id)) {
+        continue;
+      }
+
+      // Release tiles between tiles if the cache is getting large
+      if (reader.OverCommitted()) {
+        reader.Clear();
+      }
+      const GraphTile* tile = reader.GetGraphTile(tile_id);
+      if (tile == nullptr) {
+        continue;
+      }
+      GraphId edgeid = tile_id;
+      for (uint32_t i = 0; i < tile->header()->directededgecount();
+           i++, edgeid++) {
+        const DirectedEdge* directededge = tile->directededge(i);
+        if (!directededge->is_shortcut()) {
+          continue;
+        }
+        std::vector<std::pair<GraphId, float>> edges;
+        if (recovery.Recover(reader, edgeid, directededge, edges)) {
+          shortcuts.emplace(edgeid, std::move(edges));
+        } else {
+          failed++;
+        }
+      }
+    }
+    LOG_INFO("Level " + std::to_string(level.second.level) + ": " +
+             std::to_string(shortcuts.size()) + " shortcuts recovered so far");
+  }
+  LOG_INFO("Recovered " + std::to_string(shortcuts.size()) + " shortcuts, " +
+           std::to_string(failed) + " could not be recovered");
+
+  if (!ShortcutTable::Write(output, shortcuts)) {
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Wrote shortcut table " + output);
+  return EXIT_SUCCESS;
+}
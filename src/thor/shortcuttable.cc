@@ -0,0 +1,191 @@
+#include "thor/shortcuttable.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <valhalla/midgard/logging.h>
+
+using namespace valhalla::baldr;
+
+namespace {
+
+constexpr char kShortcutTableMagic[8] = { 'T', 'H', 'O', 'R', 'S', 'C', 'U', 'T' };
+constexpr uint32_t kShortcutTableVersion = 1;
+
+// Bits of a packed edge used for the GraphId (the rest is the fraction)
+constexpr uint64_t kIdMask = (1ull << 48) - 1;
+constexpr float kFractionScale = 65535.0f;
+
+// Pack a GraphId into 48 bits
+uint64_t pack(const GraphId& id) {
+  return static_cast<uint64_t>(id.tileid()) |
+         (static_cast<uint64_t>(id.level()) << 24) |
+         (static_cast<uint64_t>(id.id()) << 27);
+}
+
+// Unpack a GraphId from the low 48 bits
+GraphId unpack(const uint64_t v) {
+  return GraphId(v & 0xffffff, (v >> 24) & 0x7, (v >> 27) & 0x1fffff);
+}
+
+}
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+ShortcutTable::ShortcutTable()
+    : data_(nullptr),
+      size_(0),
+      header_(nullptr),
+      index_(nullptr),
+      edges_(nullptr) {
+}
+
+// Destructor
+ShortcutTable::~ShortcutTable() {
+  Unload();
+}
+
+// Unmap the file
+void ShortcutTable::Unload() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  header_ = nullptr;
+  index_ = nullptr;
+  edges_ = nullptr;
+}
+
+// Memory map a shortcut table file
+bool ShortcutTable::Load(const std::string& filename) {
+  Unload();
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    LOG_ERROR("Could not open shortcut table " + filename);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    LOG_ERROR("Invalid shortcut table " + filename);
+    close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG_ERROR("Could not map shortcut table " + filename);
+    return false;
+  }
+  data_ = data;
+  size_ = st.st_size;
+
+  // Validate the header and the sizes
+  header_ = static_cast<const Header*>(data_);
+  bool valid = header_->edge_count <= size_ / sizeof(uint64_t) &&
+               size_ == sizeof(Header) +
+                        header_->shortcut_count * sizeof(IndexEntry) +
+                        header_->edge_count * sizeof(uint64_t);
+  if (memcmp(header_->magic, kShortcutTableMagic, sizeof(header_->magic)) ||
+      header_->version != kShortcutTableVersion || !valid) {
+    LOG_ERROR("Invalid shortcut table " + filename);
+    Unload();
+    return false;
+  }
+  index_ = reinterpret_cast<const IndexEntry*>(
+              static_cast<const char*>(data_) + sizeof(Header));
+  edges_ = reinterpret_cast<const uint64_t*>(index_ + header_->shortcut_count);
+
+  // Expand reads the edges of an entry without checks, so every entry must
+  // be within the edge list (and the index sorted for the lookup)
+  for (uint32_t i = 0; i < header_->shortcut_count; i++) {
+    const IndexEntry& entry = index_[i];
+    if (static_cast<uint64_t>(entry.offset) + entry.count > header_->edge_count ||
+        (i > 0 && entry.shortcutid <= index_[i - 1].shortcutid)) {
+      LOG_ERROR("Invalid shortcut table index " + filename);
+      Unload();
+      return false;
+    }
+  }
+  LOG_INFO("Loaded " + std::to_string(header_->shortcut_count) +
+           " shortcuts from " + filename);
+  return true;
+}
+
+// Get the edges that make up a shortcut edge.
+uint32_t ShortcutTable::Expand(const GraphId& shortcutid,
+               std::vector<std::pair<GraphId, float>>& edges) const {
+  if (header_ == nullptr) {
+    return 0;
+  }
+  uint64_t key = pack(shortcutid);
+  const IndexEntry* end = index_ + header_->shortcut_count;
+  const IndexEntry* entry = std::lower_bound(index_, end, key,
+      [](const IndexEntry& e, const uint64_t k) { return e.shortcutid < k; });
+  if (entry == end || entry->shortcutid != key) {
+    return 0;
+  }
+  for (uint32_t i = 0; i < entry->count; i++) {
+    uint64_t v = edges_[entry->offset + i];
+    edges.emplace_back(unpack(v & kIdMask), (v >> 48) / kFractionScale);
+  }
+  return entry->count;
+}
+
+// Get the number of shortcuts in the table
+uint32_t ShortcutTable::size() const {
+  return (header_ == nullptr) ? 0 : header_->shortcut_count;
+}
+
+// Write a shortcut table file
+bool ShortcutTable::Write(const std::string& filename,
+                          const shortcut_map_t& shortcuts) {
+  // Form the index (sorted by packed shortcut Id) and the edge list
+  std::vector<IndexEntry> index;
+  std::vector<uint64_t> edges;
+  for (const auto& shortcut : shortcuts) {
+    IndexEntry entry;
+    entry.shortcutid = pack(shortcut.first);
+    entry.offset = edges.size();
+    entry.count = shortcut.second.size();
+    index.push_back(entry);
+    for (const auto& edge : shortcut.second) {
+      float f = std::min(std::max(edge.second, 0.0f), 1.0f);
+      uint64_t fraction = static_cast<uint64_t>(f * kFractionScale + 0.5f);
+      edges.push_back(pack(edge.first) | (fraction << 48));
+    }
+  }
+  std::sort(index.begin(), index.end(),
+      [](const IndexEntry& a, const IndexEntry& b) {
+        return a.shortcutid < b.shortcutid; });
+
+  Header header;
+  memcpy(header.magic, kShortcutTableMagic, sizeof(header.magic));
+  header.version = kShortcutTableVersion;
+  header.shortcut_count = index.size();
+  header.edge_count = edges.size();
+
+  std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    LOG_ERROR("Could not open " + filename + " for writing");
+    return false;
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+  file.write(reinterpret_cast<const char*>(index.data()),
+             index.size() * sizeof(IndexEntry));
+  file.write(reinterpret_cast<const char*>(edges.data()),
+             edges.size() * sizeof(uint64_t));
+  file.close();
+  return !file.fail();
+}
+
+}
+}
@@ -0,0 +1,281 @@
+#include "thor/snapshot.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <boost/filesystem.hpp>
+
+#include <valhalla/midgard/logging.h>
+
+namespace {
+
+constexpr char kSnapshotMagic[8] = { 'T', 'H', 'O', 'R', 'S', 'N', 'A', 'P' };
+constexpr uint32_t kSnapshotVersion = 2;
+
+// Sections start at offsets that are a multiple of this (a cache line)
+constexpr uint64_t kSectionAlignment = 64;
+
+uint64_t align(const uint64_t offset) {
+  return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+}
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+Snapshot::Snapshot()
+    : data_(nullptr),
+      size_(0),
+      header_(nullptr),
+      sections_(nullptr) {
+}
+
+// Destructor
+Snapshot::~Snapshot() {
+  Unload();
+}
+
+// Unmap the file
+void Snapshot::Unload() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  header_ = nullptr;
+  sections_ = nullptr;
+}
+
+// Memory map a snapshot file
+bool Snapshot::Load(const std::string& filename, const uint64_t tileset) {
+  Unload();
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    LOG_ERROR("Could not open snapshot " + filename);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    LOG_ERROR("Invalid snapshot " + filename);
+    close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG_ERROR("Could not map snapshot " + filename);
+    return false;
+  }
+  data_ = data;
+  size_ = st.st_size;
+
+  // Validate the header, the section table checksum and that the sections
+  // are within the file
+  header_ = static_cast<const Header*>(data_);
+  if (memcmp(header_->magic, kSnapshotMagic, sizeof(header_->magic))) {
+    LOG_ERROR("Invalid snapshot " + filename);
+    Unload();
+    return false;
+  }
+  if (header_->version != kSnapshotVersion) {
+    LOG_ERROR("Snapshot " + filename + " has version " +
+              std::to_string(header_->version) + " (expected " +
+              std::to_string(kSnapshotVersion) + ")");
+    Unload();
+    return false;
+  }
+  size_t table_end = sizeof(Header) +
+                     header_->section_count * sizeof(SectionEntry);
+  bool valid = header_->file_size == size_ && table_end <= size_;
+  if (valid) {
+    sections_ = reinterpret_cast<const SectionEntry*>(
+                  static_cast<const char*>(data_) + sizeof(Header));
+    valid = Checksum(reinterpret_cast<const char*>(sections_),
+                     table_end - sizeof(Header)) == header_->table_checksum;
+    for (uint32_t i = 0; valid && i < header_->section_count; i++) {
+      valid = sections_[i].offset >= table_end &&
+              sections_[i].offset % kSectionAlignment == 0 &&
+              sections_[i].offset + sections_[i].size <= size_;
+    }
+  }
+  if (!valid) {
+    LOG_ERROR("Invalid snapshot " + filename);
+    Unload();
+    return false;
+  }
+  if (tileset != 0 && header_->tileset != tileset) {
+    LOG_ERROR("Snapshot " + filename + " was not written from the tiles in use");
+    Unload();
+    return false;
+  }
+  LOG_INFO("Loaded snapshot " + filename + " with " +
+           std::to_string(header_->section_count) + " sections");
+  return true;
+}
+
+// Check the checksums of all sections
+bool Snapshot::Verify() const {
+  if (header_ == nullptr) {
+    return false;
+  }
+  for (uint32_t i = 0; i < header_->section_count; i++) {
+    const char* data = static_cast<const char*>(data_) + sections_[i].offset;
+    if (Checksum(data, sections_[i].size) != sections_[i].checksum) {
+      LOG_ERROR("Snapshot section " + std::to_string(i) + " is corrupt");
+      return false;
+    }
+  }
+  return true;
+}
+
+// Find the data of a section
+const char* Snapshot::Section(const uint32_t tag, size_t& size) const {
+  if (header_ == nullptr) {
+    return nullptr;
+  }
+  for (uint32_t i = 0; i < header_->section_count; i++) {
+    if (sections_[i].tag == tag) {
+      size = sections_[i].size;
+      return static_cast<const char*>(data_) + sections_[i].offset;
+    }
+  }
+  return nullptr;
+}
+
+// Get the number of sections
+uint32_t Snapshot::size() const {
+  return (header_ == nullptr) ? 0 : header_->section_count;
+}
+
+// Get the Id of the tile set the snapshot was written from
+uint64_t Snapshot::tileset() const {
+  return (header_ == nullptr) ? 0 : header_->tileset;
+}
+
+// Compute the 64 bit FNV-1a hash of the data
+uint64_t Snapshot::Checksum(const char* data, const size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<uint8_t>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Compute the Id of a tile set from the tile directory and the path, size
+// and modification time of each tile file
+uint64_t Snapshot::TileSetId(const std::string& tile_dir) {
+  boost::system::error_code ec;
+  boost::filesystem::path dir = boost::filesystem::canonical(tile_dir, ec);
+  if (ec) {
+    return 0;
+  }
+
+  // Sort the tile files so the Id does not depend on the directory order
+  std::vector<std::string> files;
+  boost::filesystem::recursive_directory_iterator i(dir, ec), end;
+  for (; !ec && i != end; i.increment(ec)) {
+    if (boost::filesystem::is_regular_file(i->status()) &&
+        i->path().extension() == ".gph") {
+      files.push_back(i->path().string());
+    }
+  }
+  if (files.empty()) {
+    return 0;
+  }
+  std::sort(files.begin(), files.end());
+  std::string id;
+  for (const auto& file : files) {
+    struct stat st;
+    if (stat(file.c_str(), &st) == 0) {
+      id += file + ' ' + std::to_string(st.st_size) + ' ' +
+            std::to_string(st.st_mtime) + '\n';
+    }
+  }
+  return Checksum(id.data(), id.size());
+}
+
+// Constructor
+SnapshotWriter::SnapshotWriter()
+    : tileset_(0) {
+}
+
+// Set the Id of the tile set the snapshot is written from
+void SnapshotWriter::SetTileSet(const uint64_t tileset) {
+  tileset_ = tileset;
+}
+
+// Add a section
+void SnapshotWriter::Add(const uint32_t tag, const void* data,
+                         const size_t size) {
+  sections_.push_back({ tag, static_cast<const char*>(data), size });
+}
+
+// Write the snapshot file. Write to a temporary file and rename it so a
+// partly written snapshot is never loaded.
+bool SnapshotWriter::Write(const std::string& filename) const {
+  // Form the section table
+  std::vector<Snapshot::SectionEntry> table;
+  uint64_t offset = align(sizeof(Snapshot::Header) +
+                          sections_.size() * sizeof(Snapshot::SectionEntry));
+  for (const auto& section : sections_) {
+    Snapshot::SectionEntry entry;
+    entry.tag = section.tag;
+    entry.spare = 0;
+    entry.offset = offset;
+    entry.size = section.size;
+    entry.checksum = Snapshot::Checksum(section.data, section.size);
+    table.push_back(entry);
+    offset = align(offset + section.size);
+  }
+
+  Snapshot::Header header;
+  memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+  header.version = kSnapshotVersion;
+  header.section_count = table.size();
+  header.file_size = sections_.empty() ?
+      sizeof(Snapshot::Header) : table.back().offset + table.back().size;
+  header.table_checksum = Snapshot::Checksum(
+      reinterpret_cast<const char*>(table.data()),
+      table.size() * sizeof(Snapshot::SectionEntry));
+  header.tileset = tileset_;
+
+  std::string tmp = filename + ".tmp";
+  {
+    std::ofstream file(tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR("Could not open " + tmp + " for writing");
+      return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()),
+               table.size() * sizeof(Snapshot::SectionEntry));
+
+    // Write each section (padded to the section alignment)
+    const char padding[kSectionAlignment] = { 0 };
+    uint64_t position = sizeof(header) +
+                        table.size() * sizeof(Snapshot::SectionEntry);
+    for (uint32_t i = 0; i < table.size(); i++) {
+      file.write(padding, table[i].offset - position);
+      file.write(sections_[i].data, sections_[i].size);
+      position = table[i].offset + table[i].size;
+    }
+    file.close();
+    if (file.fail()) {
+      LOG_ERROR("Could not write " + tmp);
+      return false;
+    }
+  }
+  return std::rename(tmp.c_str(), filename.c_str()) == 0;
+}
+
+}
+}
@@ -0,0 +1,91 @@
+#include "thor/synchronizedtilecache.h"
+
+using namespace valhalla::baldr;
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+SynchronizedTileCache::SynchronizedTileCache(const TileHierarchy& hierarchy,
+                                             TileLoader* loader)
+    : hierarchy_(hierarchy),
+      loader_(loader),
+      size_(0),
+      hits_(0),
+      misses_(0) {
+  if (loader_ == nullptr) {
+    file_loader_.reset(new FileTileLoader(hierarchy_));
+    loader_ = file_loader_.get();
+  }
+}
+
+// Get the graph tile containing the given GraphId
+const GraphTile* SynchronizedTileCache::Get(const GraphId& id) {
+  GraphId base = id.Tile_Base();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto cached = tiles_.find(base.value);
+    if (cached != tiles_.end()) {
+      hits_++;
+      return cached->second.get();
+    }
+    misses_++;
+  }
+
+  // Load the tile without holding the lock. Tiles that do not exist are
+  // cached as nullptr.
+  std::unique_ptr<const GraphTile> tile(loader_->Load(base));
+
+  // Another thread may have loaded the tile in the meantime - keep the
+  // first one (it may already be in use)
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto inserted = tiles_.emplace(base.value, std::move(tile));
+  if (inserted.second && inserted.first->second) {
+    size_ += inserted.first->second->size();
+  }
+  return inserted.first->second.get();
+}
+
+// Load tiles into the cache ahead of use
+void SynchronizedTileCache::Preload(const std::vector<GraphId>& tileids) {
+  std::vector<GraphId> load;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& id : tileids) {
+      if (tiles_.find(id.Tile_Base().value) == tiles_.end()) {
+        load.push_back(id.Tile_Base());
+      }
+    }
+  }
+  if (load.empty()) {
+    return;
+  }
+
+  // Read the batch without holding the lock
+  std::vector<GraphTile*> tiles;
+  loader_->LoadBatch(load, tiles);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (uint32_t i = 0; i < load.size(); i++) {
+    std::unique_ptr<const GraphTile> tile(tiles[i]);
+    auto inserted = tiles_.emplace(load[i].value, std::move(tile));
+    if (inserted.second) {
+      misses_++;
+      if (inserted.first->second) {
+        size_ += inserted.first->second->size();
+      }
+    }
+  }
+}
+
+// Get statistics about the cache
+TileCacheStats SynchronizedTileCache::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  TileCacheStats stats;
+  stats.hits   = hits_;
+  stats.misses = misses_;
+  stats.bytes  = size_;
+  return stats;
+}
+
+}
+}
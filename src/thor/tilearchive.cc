@@ -0,0 +1,210 @@
+#include "thor/tilearchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <valhalla/midgard/logging.h>
+#include "thor/memorytile.h"
+
+using namespace valhalla::baldr;
+
+namespace {
+
+constexpr char kTileArchiveMagic[8] = { 'T', 'H', 'O', 'R', 'T', 'I', 'L', 'E' };
+constexpr uint32_t kTileArchiveVersion = 1;
+
+// Tiles start at offsets that are a multiple of this
+constexpr uint64_t kTileAlignment = 8;
+
+uint64_t align(const uint64_t offset) {
+  return (offset + kTileAlignment - 1) & ~(kTileAlignment - 1);
+}
+
+}
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+TileArchive::TileArchive()
+    : data_(nullptr),
+      size_(0),
+      header_(nullptr),
+      index_(nullptr) {
+}
+
+// Destructor
+TileArchive::~TileArchive() {
+  Unload();
+}
+
+// Unmap the file
+void TileArchive::Unload() {
+  if (data_ != nullptr) {
+    munmap(data_, size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  header_ = nullptr;
+  index_ = nullptr;
+}
+
+// Memory map a tile archive file
+bool TileArchive::Load(const std::string& filename) {
+  Unload();
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1) {
+    LOG_ERROR("Could not open tile archive " + filename);
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(Header)) {
+    LOG_ERROR("Invalid tile archive " + filename);
+    close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG_ERROR("Could not map tile archive " + filename);
+    return false;
+  }
+  data_ = data;
+  size_ = st.st_size;
+
+  // Validate the header and that the index and tiles are within the file
+  header_ = static_cast<const Header*>(data_);
+  size_t index_end = sizeof(Header) + header_->tile_count * sizeof(IndexEntry);
+  bool valid = !memcmp(header_->magic, kTileArchiveMagic, sizeof(header_->magic)) &&
+               header_->version == kTileArchiveVersion && index_end <= size_;
+  if (valid) {
+    index_ = reinterpret_cast<const IndexEntry*>(
+                static_cast<const char*>(data_) + sizeof(Header));
+    for (uint32_t i = 0; valid && i < header_->tile_count; i++) {
+      valid = index_[i].offset >= index_end &&
+              index_[i].offset % kTileAlignment == 0 &&
+              index_[i].offset + index_[i].size <= size_;
+    }
+  }
+  if (!valid) {
+    LOG_ERROR("Invalid tile archive " + filename);
+    Unload();
+    return false;
+  }
+  LOG_INFO("Loaded " + std::to_string(header_->tile_count) +
+           " tiles from " + filename);
+  return true;
+}
+
+// Find the data of a tile
+const char* TileArchive::Find(const GraphId& tileid, size_t& size) const {
+  if (header_ == nullptr) {
+    return nullptr;
+  }
+  uint64_t key = tileid.Tile_Base().value;
+  const IndexEntry* end = index_ + header_->tile_count;
+  const IndexEntry* entry = std::lower_bound(index_, end, key,
+      [](const IndexEntry& e, const uint64_t k) { return e.tileid < k; });
+  if (entry == end || entry->tileid != key) {
+    return nullptr;
+  }
+  size = entry->size;
+  return static_cast<const char*>(data_) + entry->offset;
+}
+
+// Get the number of tiles in the archive
+uint32_t TileArchive::size() const {
+  return (header_ == nullptr) ? 0 : header_->tile_count;
+}
+
+// Write a tile archive file
+bool TileArchive::Write(const std::string& filename,
+                const std::vector<std::pair<GraphId, std::string>>& tiles) {
+  // Form the index from the file sizes (sorted by tile Id)
+  std::vector<std::pair<IndexEntry, std::string>> entries;
+  for (const auto& tile : tiles) {
+    std::ifstream file(tile.second, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+      LOG_ERROR("Could not open tile " + tile.second);
+      return false;
+    }
+    IndexEntry entry;
+    entry.tileid = tile.first.Tile_Base().value;
+    entry.offset = 0;
+    entry.size = file.tellg();
+    entries.emplace_back(entry, tile.second);
+  }
+  std::sort(entries.begin(), entries.end(),
+      [](const std::pair<IndexEntry, std::string>& a,
+         const std::pair<IndexEntry, std::string>& b) {
+        return a.first.tileid < b.first.tileid; });
+  uint64_t offset = align(sizeof(Header) + entries.size() * sizeof(IndexEntry));
+  std::vector<IndexEntry> index;
+  for (auto& entry : entries) {
+    entry.first.offset = offset;
+    offset = align(offset + entry.first.size);
+    index.push_back(entry.first);
+  }
+
+  Header header;
+  memcpy(header.magic, kTileArchiveMagic, sizeof(header.magic));
+  header.version = kTileArchiveVersion;
+  header.tile_count = index.size();
+
+  std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    LOG_ERROR("Could not open " + filename + " for writing");
+    return false;
+  }
+  file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+  file.write(reinterpret_cast<const char*>(index.data()),
+             index.size() * sizeof(IndexEntry));
+
+  // Copy each tile (padded to the tile alignment)
+  std::vector<char> buffer;
+  const char padding[kTileAlignment] = { 0 };
+  uint64_t position = sizeof(Header) + index.size() * sizeof(IndexEntry);
+  for (const auto& entry : entries) {
+    file.write(padding, entry.first.offset - position);
+    std::ifstream tile(entry.second, std::ios::in | std::ios::binary);
+    buffer.resize(entry.first.size);
+    tile.read(buffer.data(), buffer.size());
+    if (tile.gcount() != static_cast<std::streamsize>(buffer.size())) {
+      LOG_ERROR("Could not read tile " + entry.second);
+      return false;
+    }
+    file.write(buffer.data(), buffer.size());
+    position = entry.first.offset + entry.first.size;
+  }
+  file.close();
+  return !file.fail();
+}
+
+// Constructor
+ArchiveTileLoader::ArchiveTileLoader(const TileArchive& archive)
+    : archive_(archive) {
+}
+
+// Load a tile from the archive
+GraphTile* ArchiveTileLoader::Load(const GraphId& tileid) {
+  size_t size = 0;
+  const char* data = archive_.Find(tileid, size);
+  if (data == nullptr) {
+    return nullptr;
+  }
+  GraphTile* tile = new MemoryTile(data, size);
+  if (tile->size() == 0) {
+    delete tile;
+    return nullptr;
+  }
+  return tile;
+}
+
+}
+}
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/optional.hpp>
+
+#include "config.h"
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/midgard/logging.h>
+#include <valhalla/midgard/util.h>
+#include "thor/tilearchive.h"
+
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace bpo = boost::program_options;
+
+// Main method for building the tile archive
+int main(int argc, char *argv[]) {
+  bpo::options_description options("tilearchiver " VERSION "\n"
+  "\n"
+  " Usage: tilearchiver [options] <config>\n"
+  "\n"
+  "tilearchiver packs every tile in the tile hierarchy into a single tile "
+  "archive file that thor can memory map instead of reading the tile "
+  "files (see thor.tile_archive)."
+  "\n"
+  "\n");
+
+  std::string config, output;
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "output,o", boost::program_options::value<std::string>(&output),
+      "Output tile archive file.")
+  // positional arguments
+  ("config", bpo::value<std::string>(&config), "Valhalla configuration file");
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("config", 1);
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(
+        bpo::command_line_parser(argc, argv).options(options).positional(
+            pos_options).run(),
+        vm);
+    bpo::notify(vm);
+  } catch (std::exception &e) {
+    std::cerr << "Unable to parse command line options because: " << e.what()
+              << "\n" << "This is a bug, please report it at " PACKAGE_BUGREPORT
+              << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "tilearchiver " << VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  for (auto arg : std::vector<std::string> { "output", "config" }) {
+    if (vm.count(arg) == 0) {
+      std::cerr << "The <" << arg << "> argument was not provided, but is mandatory\n\n";
+      std::cerr << options << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  //parse the config
+  boost::property_tree::ptree pt;
+  boost::property_tree::read_json(config.c_str(), pt);
+
+  //configure logging
+  boost::optional<boost::property_tree::ptree&> logging_subtree = pt
+      .get_child_optional("thor.logging");
+  if (logging_subtree) {
+    auto logging_config = valhalla::midgard::ToMap<
+        const boost::property_tree::ptree&,
+        std::unordered_map<std::string, std::string> >(logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // Gather the tile files of all levels
+  GraphReader reader(pt.get_child("mjolnir.hierarchy"));
+  auto tile_hierarchy = reader.GetTileHierarchy();
+  std::vector<std::pair<GraphId, std::string>> tiles;
+  for (const auto& level : tile_hierarchy.levels()) {
+    uint32_t ntiles = level.second.tiles.TileCount();
+    uint32_t count = 0;
+    for (uint32_t tileid = 0; tileid < ntiles; tileid++) {
+      GraphId tile_id(tileid, level.second.level, 0);
+      if (!GraphReader::DoesTileExist(tile_hierarchy, tile_id)) {
+        continue;
+      }
+      tiles.emplace_back(tile_id, tile_hierarchy.tile_dir() + "/" +
+                         GraphTile::FileSuffix(tile_id, tile_hierarchy));
+      count++;
+    }
+    LOG_INFO("Level " + std::to_string(level.second.level) + ": " +
+             std::to_string(count) + " tiles");
+  }
+
+  if (!TileArchive::Write(output, tiles)) {
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Wrote " + std::to_string(tiles.size()) + " tiles to " + output);
+  return EXIT_SUCCESS;
+}
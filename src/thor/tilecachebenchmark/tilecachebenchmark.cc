@@ -0,0 +1,225 @@
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <boost/program_options.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/optional.hpp>
+
+#include "config.h"
+
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/midgard/logging.h>
+#include <valhalla/midgard/util.h>
+#include "thor/concurrenttilecache.h"
+#include "thor/synchronizedtilecache.h"
+
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace bpo = boost::program_options;
+
+namespace {
+
+/**
+ * Record the tile lookups of a search-like expansion: a breadth first
+ * traversal of the graph from the first node of a tile. As in a search, the
+ * tile of each expanded node and the tile of the end node of each of its
+ * edges is looked up.
+ * @param  reader  Graph reader.
+ * @param  start   Tile to start in.
+ * @param  count   Number of lookups to record.
+ * @return  Returns the GraphIds looked up.
+ */
+std::vector<GraphId> RecordTrace(GraphReader& reader, const GraphId& start,
+                                 const uint32_t count) {
+  std::vector<GraphId> trace;
+  std::deque<GraphId> queue = { start };
+  std::unordered_set<GraphId> visited = { start };
+  while (!queue.empty() && trace.size() < count) {
+    GraphId node = queue.front();
+    queue.pop_front();
+    const GraphTile* tile = reader.GetGraphTile(node);
+    trace.push_back(node);
+    if (tile == nullptr) {
+      continue;
+    }
+    const NodeInfo* nodeinfo = tile->node(node);
+    const DirectedEdge* directededge = tile->directededge(nodeinfo->edge_index());
+    for (uint32_t i = 0; i < nodeinfo->edge_count(); i++, directededge++) {
+      GraphId endnode = directededge->endnode();
+      trace.push_back(endnode);
+      if (visited.insert(endnode).second) {
+        queue.push_back(endnode);
+      }
+    }
+  }
+  return trace;
+}
+
+/**
+ * Replay traces against a tile cache, one thread per trace.
+ * @param  cache   Tile cache.
+ * @param  traces  Lookups for each thread.
+ * @param  passes  Number of times each thread replays its trace.
+ * @return  Returns the lookup rate (lookups per second, all threads).
+ */
+double Replay(TileCache& cache, const std::vector<std::vector<GraphId>>& traces,
+              const uint32_t passes) {
+  std::vector<uint32_t> readers;
+  for (size_t i = 0; i < traces.size(); i++) {
+    readers.push_back(cache.RegisterReader());
+  }
+  std::vector<uint64_t> checksums(traces.size(), 0);
+  auto replay = [&](const size_t t) {
+    TileCacheReadGuard guard(&cache, readers[t]);
+    uint64_t checksum = 0;
+    for (uint32_t pass = 0; pass < passes; pass++) {
+      for (const auto& id : traces[t]) {
+        const GraphTile* tile = cache.Get(id);
+        if (tile != nullptr) {
+          checksum += tile->header()->nodecount();
+        }
+      }
+    }
+    checksums[t] = checksum;
+  };
+
+  // Load the tiles first so the timed passes measure lookups
+  for (size_t t = 0; t < traces.size(); t++) {
+    for (const auto& id : traces[t]) {
+      cache.Get(id);
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < traces.size(); t++) {
+    threads.emplace_back(replay, t);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  uint64_t lookups = 0;
+  for (const auto& trace : traces) {
+    lookups += trace.size() * passes;
+  }
+  return lookups / elapsed.count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+  bpo::options_description options("tilecachebenchmark " VERSION "\n"
+  "\n"
+  " Usage: tilecachebenchmark [options] <config>\n"
+  "\n"
+  "tilecachebenchmark records the tile lookups of search-like expansions "
+  "and replays them on several threads against the mutex guarded and the "
+  "concurrent (lock-free lookup) tile caches."
+  "\n"
+  "\n");
+
+  std::string config;
+  uint32_t threads = 4, lookups = 1000000, passes = 10;
+
+  options.add_options()("help,h", "Print this help message.")(
+      "version,v", "Print the version of this software.")(
+      "threads,t", boost::program_options::value<uint32_t>(&threads),
+      "Number of threads (default 4).")(
+      "lookups,l", boost::program_options::value<uint32_t>(&lookups),
+      "Number of tile lookups recorded per thread (default 1000000).")(
+      "passes,p", boost::program_options::value<uint32_t>(&passes),
+      "Number of times each thread replays its lookups (default 10).")
+  // positional arguments
+  ("config", bpo::value<std::string>(&config), "Valhalla configuration file");
+
+  bpo::positional_options_description pos_options;
+  pos_options.add("config", 1);
+
+  bpo::variables_map vm;
+  try {
+    bpo::store(
+        bpo::command_line_parser(argc, argv).options(options).positional(
+            pos_options).run(),
+        vm);
+    bpo::notify(vm);
+  } catch (std::exception &e) {
+    std::cerr << "Unable to parse command line options because: " << e.what()
+              << "\n" << "This is a bug, please report it at " PACKAGE_BUGREPORT
+              << "\n";
+    return EXIT_FAILURE;
+  }
+
+  if (vm.count("help")) {
+    std::cout << options << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("version")) {
+    std::cout << "tilecachebenchmark " << VERSION << "\n";
+    return EXIT_SUCCESS;
+  }
+
+  if (vm.count("config") == 0 || threads == 0) {
+    std::cerr << "The <config> argument was not provided, but is mandatory\n\n";
+    std::cerr << options << "\n";
+    return EXIT_FAILURE;
+  }
+
+  //parse the config
+  boost::property_tree::ptree pt;
+  boost::property_tree::read_json(config.c_str(), pt);
+
+  //configure logging
+  boost::optional<boost::property_tree::ptree&> logging_subtree = pt
+      .get_child_optional("thor.logging");
+  if (logging_subtree) {
+    auto logging_config = valhalla::midgard::ToMap<
+        const boost::property_tree::ptree&,
+        std::unordered_map<std::string, std::string> >(logging_subtree.get());
+    valhalla::midgard::logging::Configure(logging_config);
+  }
+
+  // Start each thread's expansion in a different tile of the local level
+  GraphReader reader(pt.get_child("mjolnir.hierarchy"));
+  auto tile_hierarchy = reader.GetTileHierarchy();
+  const auto& local_level = tile_hierarchy.levels().rbegin()->second;
+  std::vector<GraphId> tiles;
+  for (uint32_t tileid = 0; tileid < local_level.tiles.TileCount(); tileid++) {
+    GraphId tile_id(tileid, local_level.level, 0);
+    if (GraphReader::DoesTileExist(tile_hierarchy, tile_id)) {
+      tiles.push_back(tile_id);
+    }
+  }
+  if (tiles.empty()) {
+    LOG_ERROR("No tiles found");
+    return EXIT_FAILURE;
+  }
+  std::vector<std::vector<GraphId>> traces;
+  for (uint32_t t = 0; t < threads; t++) {
+    traces.emplace_back(RecordTrace(reader, tiles[(t * tiles.size()) / threads],
+                                    lookups));
+    LOG_INFO("Thread " + std::to_string(t) + ": " +
+             std::to_string(traces.back().size()) + " lookups");
+  }
+  reader.Clear();
+
+  SynchronizedTileCache synchronized(tile_hierarchy);
+  double rate = Replay(synchronized, traces, passes);
+  LOG_INFO("Mutex guarded cache: " + std::to_string(rate / 1000000.0) +
+           " million lookups/sec");
+
+  ConcurrentTileCache concurrent(tile_hierarchy);
+  rate = Replay(concurrent, traces, passes);
+  LOG_INFO("Concurrent cache: " + std::to_string(rate / 1000000.0) +
+           " million lookups/sec");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,38 @@
+#include "thor/tileloader.h"
+
+#include <valhalla/baldr/graphreader.h>
+
+using namespace valhalla::baldr;
+
+namespace valhalla {
+namespace thor {
+
+// Load a batch of tiles one at a time
+void TileLoader::LoadBatch(const std::vector<GraphId>& tileids,
+                           std::vector<GraphTile*>& tiles) {
+  tiles.clear();
+  for (const auto& tileid : tileids) {
+    tiles.push_back(Load(tileid));
+  }
+}
+
+// Constructor
+FileTileLoader::FileTileLoader(const TileHierarchy& hierarchy)
+    : hierarchy_(hierarchy) {
+}
+
+// Load a tile from its file
+GraphTile* FileTileLoader::Load(const GraphId& tileid) {
+  if (!GraphReader::DoesTileExist(hierarchy_, tileid)) {
+    return nullptr;
+  }
+  GraphTile* tile = new GraphTile(hierarchy_, tileid);
+  if (tile->size() == 0) {
+    delete tile;
+    return nullptr;
+  }
+  return tile;
+}
+
+}
+}
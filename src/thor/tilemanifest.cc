@@ -0,0 +1,151 @@
+#include "thor/tilemanifest.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include <valhalla/midgard/logging.h>
+
+using namespace valhalla::baldr;
+
+namespace valhalla {
+namespace thor {
+
+// Constructor
+TileManifest::TileManifest() {
+}
+
+// Record uses of a tile
+void TileManifest::Record(const GraphId& tileid, const size_t size,
+                          const uint64_t count) {
+  GraphId base = tileid.Tile_Base();
+  uint32_t stripe = base.value % kStripes;
+  std::lock_guard<std::mutex> lock(mutexes_[stripe]);
+  Usage& usage = usage_[stripe][base.value];
+  usage.tileid = base;
+  usage.count += count;
+  usage.size = size;
+}
+
+// Load a manifest file, adding its counts to the recorded counts. Loaded
+// counts are halved so tiles that are no longer used age out.
+bool TileManifest::Load(const std::string& filename) {
+  std::ifstream file(filename);
+  if (!file.is_open()) {
+    return false;
+  }
+  uint32_t level, tileid, size;
+  uint64_t count;
+  while (file >> level >> tileid >> count >> size) {
+    GraphId base(tileid, level, 0);
+    uint32_t stripe = base.value % kStripes;
+    std::lock_guard<std::mutex> lock(mutexes_[stripe]);
+    Usage& usage = usage_[stripe][base.value];
+    usage.tileid = base;
+    usage.count += (count + 1) / 2;
+    usage.size = size;
+  }
+  return true;
+}
+
+// Write the manifest to a file. Write to a temporary file and rename it so
+// a partly written manifest is never loaded.
+bool TileManifest::Write(const std::string& filename) const {
+  std::vector<Entry> entries = Sorted();
+  std::lock_guard<std::mutex> lock(write_mutex_);
+  std::string tmp = filename + ".tmp";
+  {
+    std::ofstream file(tmp, std::ios::out | std::ios::trunc);
+    if (!file.is_open()) {
+      LOG_ERROR("Could not open " + tmp + " for writing");
+      return false;
+    }
+    for (const auto& entry : entries) {
+      file << entry.tileid.level() << " " << entry.tileid.tileid() << " "
+           << entry.count << " " << entry.size << "\n";
+    }
+    file.close();
+    if (file.fail()) {
+      return false;
+    }
+  }
+  return std::rename(tmp.c_str(), filename.c_str()) == 0;
+}
+
+// Get the most used tiles within a tile count and size budget. Tiles that
+// do not fit the remaining budget are skipped so smaller tiles can fill it.
+std::vector<TileManifest::Entry> TileManifest::Top(const uint32_t max_tiles,
+                                                   const size_t max_bytes) const {
+  std::vector<Entry> top;
+  size_t bytes = 0;
+  for (const auto& entry : Sorted()) {
+    if (top.size() >= max_tiles) {
+      break;
+    }
+    if (bytes + entry.size <= max_bytes) {
+      bytes += entry.size;
+      top.push_back(entry);
+    }
+  }
+  return top;
+}
+
+// Get the number of tiles recorded
+size_t TileManifest::size() const {
+  size_t n = 0;
+  for (uint32_t i = 0; i < kStripes; i++) {
+    std::lock_guard<std::mutex> lock(mutexes_[i]);
+    n += usage_[i].size();
+  }
+  return n;
+}
+
+// Get all recorded tiles sorted by count (ties by tile Id so the order is
+// stable)
+std::vector<TileManifest::Entry> TileManifest::Sorted() const {
+  std::vector<Entry> entries;
+  for (uint32_t i = 0; i < kStripes; i++) {
+    std::lock_guard<std::mutex> lock(mutexes_[i]);
+    for (const auto& usage : usage_[i]) {
+      entries.emplace_back(usage.second.tileid, usage.second.count,
+                           usage.second.size);
+    }
+  }
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) {
+              return (a.count == b.count) ?
+                  a.tileid.value < b.tileid.value : a.count > b.count; });
+  return entries;
+}
+
+// Preload tiles into a tile cache. Threads take batches of tiles in order
+// so the most used tiles are loaded first.
+void TileManifest::Warmup(TileCache& tilecache, const std::vector<Entry>& tiles,
+                          const uint32_t threads) {
+  std::atomic<size_t> next(0);
+  auto warm = [&tilecache, &tiles, &next]() {
+    std::vector<GraphId> batch;
+    size_t start;
+    while ((start = next.fetch_add(kWarmupBatchSize)) < tiles.size()) {
+      batch.clear();
+      size_t end = std::min(start + kWarmupBatchSize, tiles.size());
+      for (size_t i = start; i < end; i++) {
+        batch.push_back(tiles[i].tileid);
+      }
+      tilecache.Preload(batch);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (uint32_t i = 1; i < threads; i++) {
+    workers.emplace_back(warm);
+  }
+  warm();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+}
+}
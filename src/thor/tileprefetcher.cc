@@ -0,0 +1,168 @@
+#include "thor/tileprefetcher.h"
+
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/midgard/logging.h>
+
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+
+namespace {
+
+// Size of the buffer used to read tile files
+constexpr size_t kReadBufferSize = 1024 * 1024;
+
+}
+
+namespace valhalla {
+namespace thor {
+
+// Constructor - start the background thread
+TilePrefetcher::TilePrefetcher(const TileHierarchy& hierarchy,
+                               TileCache* tilecache)
+    : hierarchy_(hierarchy),
+      tilecache_(tilecache),
+      done_(false),
+      prefetched_(0) {
+  thread_ = std::thread(&TilePrefetcher::Run, this);
+}
+
+// Destructor - stop the background thread
+TilePrefetcher::~TilePrefetcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+    pending_.clear();
+  }
+  condition_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+// Request tiles around and ahead of the search frontier.
+void TilePrefetcher::Prefetch(const PointLL& frontier, const PointLL& dest) {
+  // Direction towards the destination (degrees, longitude scaled so the
+  // direction is roughly correct away from the equator)
+  float coslat = cosf(frontier.lat() * 0.017453292f);
+  float dx = (dest.lng() - frontier.lng()) * coslat;
+  float dy = dest.lat() - frontier.lat();
+  float len = sqrtf(dx * dx + dy * dy);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (const auto& level : hierarchy_.levels()) {
+    const auto& tiles = level.second.tiles;
+    float tilesize = tiles.TileSize();
+
+    // Tile at the frontier, then tiles 1 and 2 tile sizes ahead of it and
+    // to either side of the direction of travel. Stop short of the
+    // destination.
+    std::vector<PointLL> points = { frontier };
+    if (len > 0.0f) {
+      float ux = dx / len;
+      float uy = dy / len;
+      for (float d = tilesize; d <= 2.0f * tilesize && d < len + tilesize;
+           d += tilesize) {
+        PointLL ahead(frontier.lng() + (ux * d) / coslat,
+                      frontier.lat() + uy * d);
+        points.push_back(ahead);
+        points.emplace_back(ahead.lng() - (uy * tilesize) / coslat,
+                            ahead.lat() + ux * tilesize);
+        points.emplace_back(ahead.lng() + (uy * tilesize) / coslat,
+                            ahead.lat() - ux * tilesize);
+      }
+    }
+    for (const auto& ll : points) {
+      int32_t tileid = tiles.TileId(ll);
+      if (tileid >= 0) {
+        Queue(GraphId(tileid, level.second.level, 0));
+      }
+    }
+  }
+  lock.unlock();
+  condition_.notify_one();
+}
+
+// Get the number of tiles that have been read by the prefetcher.
+uint32_t TilePrefetcher::prefetched() const {
+  return prefetched_.load();
+}
+
+// Queue a tile unless it is pending or was recently read.
+void TilePrefetcher::Queue(const GraphId& tileid) {
+  if (!requested_.insert(tileid.value).second) {
+    return;
+  }
+  pending_.push_back(tileid);
+  if (pending_.size() > kMaxPending) {
+    requested_.erase(pending_.front().value);
+    pending_.pop_front();
+  }
+}
+
+// Read the tile file so that it is in the page cache when the GraphReader
+// loads it.
+void TilePrefetcher::Load(const GraphId& tileid) {
+  std::string file_location = hierarchy_.tile_dir() + "/" +
+                              GraphTile::FileSuffix(tileid, hierarchy_);
+  int fd = open(file_location.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return;    // Tile does not exist (regional data sets)
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+  buffer_.resize(kReadBufferSize);
+  while (read(fd, buffer_.data(), buffer_.size()) > 0) {
+  }
+  close(fd);
+  prefetched_++;
+}
+
+// Background thread - read tiles from the queue until stopped. With a
+// shared tile cache all pending tiles are loaded as one batch.
+void TilePrefetcher::Run() {
+  while (true) {
+    std::vector<GraphId> batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return done_ || !pending_.empty(); });
+      if (done_) {
+        return;
+      }
+      if (tilecache_ != nullptr) {
+        batch.assign(pending_.begin(), pending_.end());
+        pending_.clear();
+      } else {
+        batch.push_back(pending_.front());
+        pending_.pop_front();
+      }
+    }
+    if (tilecache_ != nullptr) {
+      tilecache_->Preload(batch);
+      prefetched_ += batch.size();
+    } else {
+      Load(batch.front());
+    }
+
+    // Tiles can be requested again once read. The shared cache skips tiles
+    // that are still resident, so only tiles read into the page cache are
+    // remembered (a limited number, the oldest are forgotten first).
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& tileid : batch) {
+      if (tilecache_ != nullptr) {
+        requested_.erase(tileid.value);
+      } else {
+        recent_.push_back(tileid.value);
+      }
+    }
+    while (recent_.size() > kMaxRecent) {
+      requested_.erase(recent_.front());
+      recent_.pop_front();
+    }
+  }
+}
+
+}
+}
@@ -0,0 +1,149 @@
+#include "thor/transitioncosttable.h"
+
+#include <valhalla/midgard/logging.h>
+#include <valhalla/sif/edgelabel.h>
+
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+
+namespace valhalla {
+namespace thor {
+
+constexpr uint64_t TransitionCostTable::kUnallocated;
+
+// Constructor
+TransitionCostTable::TransitionCostTable()
+    : fingerprint_(0),
+      generation_(0),
+      computed_(0) {
+}
+
+// Customize the table for a costing
+void TransitionCostTable::Customize(const RoutingGraph& graph,
+                              const std::shared_ptr<DynamicCost>& costing,
+                              const uint64_t fingerprint, const bool eager) {
+  bool layout = first_row_.size() != graph.nodecount() + 1 ||
+                incoming_.size() != first_row_.back();
+  if (!layout && generation_ != 0 && fingerprint == fingerprint_) {
+    return;
+  }
+
+  // Make all matrices stale. Matrices start at generation 0 so they are
+  // reset when the generation wraps.
+  if (layout) {
+    Layout(graph);
+  }
+  if (layout || ++generation_ == 0) {
+    generations_.assign(graph.nodecount(), 0);
+    generation_ = 1;
+  }
+  fingerprint_ = fingerprint;
+  computed_ = 0;
+
+  // Compute the matrices of all nodes (allocated at once)
+  if (eager) {
+    uint64_t count = costs_.size();
+    for (uint32_t node = 0; node < graph.nodecount(); node++) {
+      if (offsets_[node] == kUnallocated) {
+        count += static_cast<uint64_t>(first_row_[node + 1] - first_row_[node]) *
+                 (graph.edge_index(node + 1) - graph.edge_index(node));
+      }
+    }
+    costs_.reserve(count);
+    for (uint32_t node = 0; node < graph.nodecount(); node++) {
+      Compute(node, graph, *costing);
+    }
+    LOG_INFO("Computed " + std::to_string(computed_) + " transition matrices");
+  }
+}
+
+// Get the fingerprint the table is customized for
+uint64_t TransitionCostTable::fingerprint() const {
+  return fingerprint_;
+}
+
+// Get the number of transition costs in the table
+uint64_t TransitionCostTable::size() const {
+  return costs_.size();
+}
+
+// Get the number of node matrices computed since the last customization
+uint64_t TransitionCostTable::computed() const {
+  return computed_;
+}
+
+// Set up the rows of all nodes and release the matrices
+void TransitionCostTable::Layout(const RoutingGraph& graph) {
+  first_row_.resize(graph.nodecount() + 1);
+  offsets_.assign(graph.nodecount(), kUnallocated);
+  incoming_.clear();
+  for (uint32_t node = 0; node < graph.nodecount(); node++) {
+    first_row_[node] = incoming_.size();
+
+    // A row per local edge index. The incoming edge of a row is the
+    // opposing edge of the first regular edge with that local index.
+    uint32_t begin = graph.edge_index(node);
+    uint32_t end = graph.edge_index(node + 1);
+    for (uint32_t e = begin; e < end; e++) {
+      const RoutingEdge& edge = graph.edge(e);
+      if (edge.trans_up || edge.trans_down || edge.is_shortcut) {
+        continue;
+      }
+      const DirectedEdge* directededge = graph.directededge(e);
+      uint32_t row = first_row_[node] + directededge->localedgeidx();
+      if (row >= incoming_.size()) {
+        incoming_.resize(row + 1, RoutingGraph::kInvalidNode);
+      }
+      if (incoming_[row] != RoutingGraph::kInvalidNode ||
+          edge.endnode == RoutingGraph::kInvalidNode) {
+        continue;
+      }
+      uint32_t opposing = graph.edge_index(edge.endnode) + directededge->opp_index();
+      if (opposing < graph.edge_index(edge.endnode + 1) &&
+          graph.edge(opposing).endnode == node) {
+        incoming_[row] = opposing;
+      }
+    }
+  }
+  first_row_[graph.nodecount()] = incoming_.size();
+  std::vector<Cost>().swap(costs_);
+}
+
+// Compute the matrix of a node. The matrix is appended to the allocated
+// matrices when first computed and recomputed in place after that.
+void TransitionCostTable::Compute(const uint32_t node,
+                                  const RoutingGraph& graph,
+                                  const DynamicCost& costing) {
+  const NodeInfo* nodeinfo = graph.nodeinfo(node);
+  uint32_t begin = graph.edge_index(node);
+  uint32_t end = graph.edge_index(node + 1);
+  if (offsets_[node] == kUnallocated) {
+    offsets_[node] = costs_.size();
+    costs_.resize(costs_.size() + static_cast<uint64_t>(
+        first_row_[node + 1] - first_row_[node]) * (end - begin));
+  }
+  Cost* costs = costs_.data() + offsets_[node];
+  for (uint32_t row = first_row_[node]; row < first_row_[node + 1];
+              row++, costs += end - begin) {
+    uint32_t in = incoming_[row];
+    if (in == RoutingGraph::kInvalidNode) {
+      continue;
+    }
+
+    // Label of the incoming edge as the search creates it
+    const DirectedEdge* indirectededge = graph.directededge(in);
+    EdgeLabel pred(kInvalidLabel, graph.edgeid(in), indirectededge,
+                   Cost(0.0f, 0.0f), 0.0f, 0.0f,
+                   indirectededge->restrictions(),
+                   indirectededge->opp_local_idx(), costing.travelmode(), 0);
+    for (uint32_t e = begin; e < end; e++) {
+      costs[e - begin] = costing.TransitionCost(graph.directededge(e),
+                                                nodeinfo, pred);
+    }
+  }
+  generations_[node] = generation_;
+  computed_++;
+}
+
+}
+}
@@ -144,7 +144,11 @@ TripPathBuilder::~TripPathBuilder() {
 TripPath TripPathBuilder::Build(GraphReader& graphreader,
                                 const std::vector<PathInfo>& path,
                                 const PathLocation& origin,
-                                const PathLocation& dest) {
+                                const PathLocation& dest,
+                                TileCache* tilecache, const uint32_t reader) {
+  // Tiles from the tile cache must remain valid while building the path
+  TileCacheReadGuard guard(tilecache, reader);
+
   // TripPath is a protocol buffer that contains information about the trip
   TripPath trip_path;
 
@@ -206,9 +210,9 @@ TripPath TripPathBuilder::Build(GraphReader& graphreader,
   // Get the first nodes graph id by using the end node of the first edge to get the tile with the opposing edge
   // then use the opposing index to get the opposing edge, and its end node is the begin node of the original edge
   auto* first_edge =
-      graphreader.GetGraphTile(path.front().edgeid)->directededge(
+      GetGraphTile(graphreader, tilecache, path.front().edgeid)->directededge(
           path.front().edgeid);
-  auto* first_tile = graphreader.GetGraphTile(first_edge->endnode());
+  auto* first_tile = GetGraphTile(graphreader, tilecache, first_edge->endnode());
   auto* first_node = first_tile->node(first_edge->endnode());
   GraphId startnode = first_tile->directededge(
       first_node->edge_index() + first_edge->opp_index())->endnode();
@@ -242,7 +246,7 @@ TripPath TripPathBuilder::Build(GraphReader& graphreader,
     if (end_pct < start_pct)
       throw std::runtime_error(
           "Generated reverse trivial path, report this bug!");
-    const auto tile = graphreader.GetGraphTile(path.front().edgeid);
+    const auto tile = GetGraphTile(graphreader, tilecache, path.front().edgeid);
     const auto edge = tile->directededge(path.front().edgeid);
 
     // Sort out the shape
@@ -276,7 +280,7 @@ TripPath TripPathBuilder::Build(GraphReader& graphreader,
   for (auto edge_itr = path.begin(); edge_itr != path.end(); ++edge_itr) {
     const GraphId& edge = edge_itr->edgeid;
     const uint32_t trip_id = edge_itr->trip_id;
-    const GraphTile* graphtile = graphreader.GetGraphTile(edge);
+    const GraphTile* graphtile = GetGraphTile(graphreader, tilecache, edge);
     const DirectedEdge* directededge = graphtile->directededge(edge);
 
     // Skip transition edges
@@ -413,7 +417,7 @@ TripPath TripPathBuilder::Build(GraphReader& graphreader,
     //            (1)  (X)
     if (startnode.Is_Valid()) {
       // Get the graph tile and the first edge from the node
-      const GraphTile* tile = graphreader.GetGraphTile(startnode);
+      const GraphTile* tile = GetGraphTile(graphreader, tilecache, startnode);
       const NodeInfo* nodeinfo = tile->node(startnode);
       uint32_t edgeid = nodeinfo->edge_index();
 
@@ -443,7 +447,7 @@ TripPath TripPathBuilder::Build(GraphReader& graphreader,
 
   // Add the last node
   auto* node = trip_path.add_node();
-  auto* last_tile = graphreader.GetGraphTile(startnode);
+  auto* last_tile = GetGraphTile(graphreader, tilecache, startnode);
   node->set_admin_index(
       GetAdminIndex(
           last_tile->admininfo(last_tile->node(startnode)->admin_index()),
@@ -0,0 +1,60 @@
+#include "test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "thor/astarheuristic.h"
+
+using namespace std;
+using namespace valhalla::midgard;
+using namespace valhalla::thor;
+
+namespace {
+
+// Check that two values match up to float rounding (the compiler may
+// contract the scalar and batch arithmetic differently)
+void CheckClose(const float batch, const float scalar, const std::string& what) {
+  if (std::abs(batch - scalar) > 1e-6f * std::max(std::abs(scalar), 1.0f))
+    throw runtime_error("Batch " + what + " " + std::to_string(batch) +
+                        " does not match " + std::to_string(scalar));
+}
+
+void TestBatch() {
+  AStarHeuristic heuristic;
+  heuristic.Init(PointLL(-76.5f, 40.0f), 0.75f);
+
+  // Batches of every size up to 2 SSE groups plus a remainder, around and
+  // at the destination
+  for (uint32_t n = 1; n <= 9; n++) {
+    std::vector<PointLL> lls;
+    for (uint32_t i = 0; i < n; i++) {
+      lls.emplace_back(-76.5f + (i % 3) * 0.013f - 0.01f,
+                       40.0f + (i / 3) * 0.021f - 0.02f * (n % 2));
+    }
+    lls.back() = PointLL(-76.5f, 40.0f);
+    std::vector<float> distances(n), heuristics(n);
+    heuristic.Get(lls.data(), n, distances.data(), heuristics.data());
+    for (uint32_t i = 0; i < n; i++) {
+      float distance = heuristic.GetDistance(lls[i]);
+      CheckClose(distances[i], distance, "distance");
+      CheckClose(heuristics[i], heuristic.Get(distance), "heuristic");
+      CheckClose(heuristics[i], heuristic.Get(lls[i]), "heuristic");
+    }
+    if (distances.back() != 0.0f || heuristics.back() != 0.0f)
+      throw runtime_error("Batch heuristic at the destination is not 0");
+  }
+}
+
+}
+
+int main() {
+  test::suite suite("astarheuristic");
+
+  // Batch distances and heuristics match the scalar methods
+  suite.test(TEST_CASE(TestBatch));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,238 @@
+#include "test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "config.h"
+#include "thor/asynctileloader.h"
+
+using namespace std;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace {
+
+// Longest a simulated read waits for the other reads of its batch
+constexpr uint32_t kMaxHoldMs = 2000;
+
+// Directory for the tile files written by the tests (removed after each test)
+const std::string kTestDir = "test/asynctileloader_files";
+
+TileHierarchy make_hierarchy(const std::string& tile_dir = "test/tiles") {
+  std::stringstream json;
+  json << "{\"tile_dir\": \"" << tile_dir << "\", \"levels\": ["
+          "{\"name\": \"local\", \"level\": 2, \"size\": 0.25}]}";
+  boost::property_tree::ptree pt;
+  boost::property_tree::read_json(json, pt);
+  return TileHierarchy(pt);
+}
+
+// Loader reading from simulated slow storage: tile files are held in
+// memory and every read blocks until the expected number of reads are in
+// flight (or a timeout), so the peak number of reads in flight shows how
+// many reads the loader overlaps without depending on timing
+class SlowStorageLoader : public AsyncTileLoader {
+ public:
+  SlowStorageLoader(const TileHierarchy& hierarchy, const uint32_t threads,
+                    const uint32_t expected_inflight)
+      : AsyncTileLoader(hierarchy, threads, 64, false),
+        expected_inflight_(expected_inflight),
+        inflight_(0),
+        peak_inflight_(0) {
+  }
+
+  // Add an empty tile with some padding so tiles have different sizes
+  size_t AddTile(const GraphId& tileid, const uint32_t padding) {
+    std::string file = hierarchy_.tile_dir() + "/" +
+                       GraphTile::FileSuffix(tileid, hierarchy_);
+    files_[file].assign(sizeof(GraphTileHeader) + padding, 0);
+    return files_[file].size();
+  }
+
+  // Most reads that were in flight at once
+  uint32_t peak_inflight() {
+    std::lock_guard<std::mutex> lock(inflight_mutex_);
+    return peak_inflight_;
+  }
+
+ protected:
+  virtual bool ReadFile(const std::string& file, std::shared_ptr<char>& data,
+                        size_t& size) {
+    {
+      std::unique_lock<std::mutex> lock(inflight_mutex_);
+      inflight_++;
+      peak_inflight_ = std::max(peak_inflight_, inflight_);
+      inflight_changed_.notify_all();
+      inflight_changed_.wait_for(lock, std::chrono::milliseconds(kMaxHoldMs),
+          [this]() { return peak_inflight_ >= expected_inflight_; });
+    }
+    bool found = Find(file, data, size);
+    std::lock_guard<std::mutex> lock(inflight_mutex_);
+    inflight_--;
+    return found;
+  }
+
+  bool Find(const std::string& file, std::shared_ptr<char>& data,
+            size_t& size) const {
+    auto found = files_.find(file);
+    if (found == files_.end()) {
+      return false;
+    }
+    size = found->second.size();
+    data.reset(new char[size], std::default_delete<char[]>());
+    memcpy(data.get(), found->second.data(), size);
+    return true;
+  }
+
+  std::unordered_map<std::string, std::string> files_;
+  uint32_t expected_inflight_;
+  std::mutex inflight_mutex_;
+  std::condition_variable inflight_changed_;
+  uint32_t inflight_;
+  uint32_t peak_inflight_;
+};
+
+void LoadBatch(const uint32_t threads, const uint32_t expected_inflight) {
+  SlowStorageLoader loader(make_hierarchy(), threads, expected_inflight);
+  std::vector<GraphId> tileids;
+  std::vector<size_t> sizes;
+  for (uint32_t i = 0; i < 16; i++) {
+    tileids.emplace_back(1000 + i, 2, 0);
+    sizes.push_back((i % 4 == 3) ? 0 : loader.AddTile(tileids.back(), i * 8));
+  }
+
+  std::vector<GraphTile*> tiles;
+  loader.LoadBatch(tileids, tiles);
+
+  if (tiles.size() != tileids.size())
+    throw runtime_error("Wrong number of tiles loaded");
+  for (uint32_t i = 0; i < tiles.size(); i++) {
+    if (sizes[i] == 0 && tiles[i] != nullptr)
+      throw runtime_error("Loaded a tile that does not exist");
+    if (sizes[i] > 0 && (tiles[i] == nullptr || tiles[i]->size() != sizes[i]))
+      throw runtime_error("Tile was not loaded or is the wrong tile");
+    delete tiles[i];
+  }
+  if (loader.peak_inflight() != expected_inflight)
+    throw runtime_error("Peak reads in flight was " +
+                        std::to_string(loader.peak_inflight()) + " not " +
+                        std::to_string(expected_inflight));
+}
+
+void TestConcurrentReads() {
+  // 16 reads on 8 threads keep 8 reads in flight
+  LoadBatch(8, 8);
+}
+
+void TestSerialReads() {
+  // Without reader threads tiles are read one at a time on the calling
+  // thread
+  LoadBatch(0, 1);
+}
+
+void TestLoadOne() {
+  SlowStorageLoader loader(make_hierarchy(), 2, 1);
+  size_t size = loader.AddTile(GraphId(5, 2, 0), 16);
+  std::unique_ptr<GraphTile> tile(loader.Load(GraphId(5, 2, 0)));
+  if (!tile || tile->size() != size)
+    throw runtime_error("Tile was not loaded");
+  if (loader.Load(GraphId(6, 2, 0)) != nullptr)
+    throw runtime_error("Loaded a tile that does not exist");
+}
+
+#ifdef HAVE_LIBURING
+
+// Loader counting the reads that fall back to the reader threads
+class CountingLoader : public AsyncTileLoader {
+ public:
+  CountingLoader(const TileHierarchy& hierarchy, const uint32_t queue_depth)
+      : AsyncTileLoader(hierarchy, 0, queue_depth, true),
+        thread_reads_(0) {
+  }
+
+  uint32_t thread_reads() const {
+    return thread_reads_;
+  }
+
+ protected:
+  virtual bool ReadFile(const std::string& file, std::shared_ptr<char>& data,
+                        size_t& size) {
+    thread_reads_++;
+    return AsyncTileLoader::ReadFile(file, data, size);
+  }
+
+  uint32_t thread_reads_;
+};
+
+void TestIoUringReads() {
+  // More reads than the queue depth so reads are refilled as they complete
+  TileHierarchy hierarchy = make_hierarchy(kTestDir);
+  CountingLoader loader(hierarchy, 4);
+  if (!loader.uses_io_uring()) {
+    // The kernel does not allow io_uring (e.g. in containers)
+    return;
+  }
+
+  std::vector<GraphId> tileids;
+  std::vector<size_t> sizes;
+  for (uint32_t i = 0; i < 16; i++) {
+    tileids.emplace_back(2000 + i, 2, 0);
+    sizes.push_back(0);
+    if (i % 4 == 3) {
+      continue;
+    }
+    std::string file = kTestDir + "/" + GraphTile::FileSuffix(tileids.back(), hierarchy);
+    boost::filesystem::create_directories(boost::filesystem::path(file).parent_path());
+    std::ofstream out(file, std::ios::out | std::ios::binary | std::ios::trunc);
+    std::string data(sizeof(GraphTileHeader) + 4096 * i, 0);
+    out.write(data.data(), data.size());
+    sizes.back() = data.size();
+  }
+
+  std::vector<GraphTile*> tiles;
+  loader.LoadBatch(tileids, tiles);
+  boost::filesystem::remove_all(kTestDir);
+
+  for (uint32_t i = 0; i < tiles.size(); i++) {
+    if (sizes[i] == 0 && tiles[i] != nullptr)
+      throw runtime_error("Loaded a tile that does not exist");
+    if (sizes[i] > 0 && (tiles[i] == nullptr || tiles[i]->size() != sizes[i]))
+      throw runtime_error("Tile was not loaded or is the wrong tile");
+    delete tiles[i];
+  }
+  if (loader.thread_reads() != 0)
+    throw runtime_error("Reads fell back to the reader threads");
+}
+
+#endif
+
+}
+
+int main() {
+  test::suite suite("asynctileloader");
+
+  // Batches of tiles are read concurrently from slow storage
+  suite.test(TEST_CASE(TestConcurrentReads));
+
+  // Batches are read without reader threads
+  suite.test(TEST_CASE(TestSerialReads));
+
+  // Single tiles
+  suite.test(TEST_CASE(TestLoadOne));
+
+#ifdef HAVE_LIBURING
+  // Batches are read through io_uring from tile files
+  suite.test(TEST_CASE(TestIoUringReads));
+#endif
+
+  return suite.tear_down();
+}
@@ -0,0 +1,347 @@
+#include "test.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "thor/concurrenttilecache.h"
+#include "thor/memorytile.h"
+
+using namespace std;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace {
+
+TileHierarchy make_hierarchy() {
+  std::stringstream json;
+  json << "{\"tile_dir\": \"test/tiles\", \"levels\": ["
+          "{\"name\": \"highway\", \"level\": 0, \"size\": 4},"
+          "{\"name\": \"local\", \"level\": 2, \"size\": 0.25}]}";
+  boost::property_tree::ptree pt;
+  boost::property_tree::read_json(json, pt);
+  return TileHierarchy(pt);
+}
+
+// Loader of empty in memory tiles. Counts the loads of each tile and the
+// tiles that have not been freed.
+class MemoryLoader : public TileLoader {
+ public:
+  MemoryLoader()
+      : live(0) {
+  }
+
+  // Add a tile of the given size (at least the size of a tile header)
+  void AddTile(const GraphId& tileid, const size_t size) {
+    sizes_[tileid.value] = size;
+  }
+
+  virtual GraphTile* Load(const GraphId& tileid) {
+    size_t size;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      loads[tileid.value]++;
+      auto found = sizes_.find(tileid.value);
+      if (found == sizes_.end()) {
+        return nullptr;
+      }
+      size = found->second;
+    }
+    live++;
+    std::atomic<uint32_t>* counter = &live;
+    std::shared_ptr<char> data(new char[size](), [counter](char* p) {
+      delete [] p;
+      (*counter)--;
+    });
+    return new MemoryTile(data, size);
+  }
+
+  uint32_t Loads(const GraphId& tileid) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return loads[tileid.value];
+  }
+
+  std::unordered_map<uint64_t, uint32_t> loads;
+  std::atomic<uint32_t> live;
+
+ protected:
+  std::mutex mutex_;
+  std::unordered_map<uint64_t, size_t> sizes_;
+};
+
+// Size of local tile i (tiles have different sizes so a wrong or freed tile
+// is likely to be noticed)
+size_t tile_size(const uint32_t i) {
+  return sizeof(GraphTileHeader) + 64 * (i % 8 + 1);
+}
+
+// Get tiles from several threads, each in a read section. With a size limit
+// tiles are evicted while other threads are using them.
+void GetConcurrently(const size_t max_bytes) {
+  constexpr uint32_t kTiles = 200;
+  constexpr uint32_t kThreads = 8;
+  MemoryLoader loader;
+  for (uint32_t i = 0; i < kTiles; i++) {
+    // Every 10th tile does not exist
+    if (i % 10 != 9) {
+      loader.AddTile(GraphId(1000 + i, 2, 0), tile_size(i));
+    }
+  }
+
+  {
+    ConcurrentTileCache cache(make_hierarchy(), max_bytes, &loader);
+    std::vector<std::thread> threads;
+    std::atomic<uint32_t> errors(0);
+    for (uint32_t t = 0; t < kThreads; t++) {
+      threads.emplace_back([&cache, &errors, t]() {
+        uint32_t reader = cache.RegisterReader();
+        for (uint32_t n = 0; n < 20; n++) {
+          for (uint32_t i = 0; i < kTiles; i++) {
+            // Each thread visits the tiles in a different order
+            uint32_t tileid = (i * 7 + t * 13) % kTiles;
+            cache.BeginRead(reader);
+            const GraphTile* tile = cache.Get(GraphId(1000 + tileid, 2, 5));
+            if (tileid % 10 == 9) {
+              if (tile != nullptr)
+                errors++;
+            } else if (tile == nullptr || tile->size() != tile_size(tileid)) {
+              errors++;
+            }
+            cache.EndRead(reader);
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    if (errors > 0)
+      throw runtime_error("Got a missing or wrong tile");
+
+    // Without a limit each tile is loaded once and stays cached
+    if (max_bytes == 0) {
+      for (uint32_t i = 0; i < kTiles; i++) {
+        if (loader.Loads(GraphId(1000 + i, 2, 0)) != 1)
+          throw runtime_error("Tile was not loaded exactly once");
+      }
+      if (cache.stats().misses != kTiles)
+        throw runtime_error("Wrong number of misses");
+    } else {
+      if (cache.stats().evictions == 0)
+        throw runtime_error("No tiles were evicted");
+      if (cache.size() > max_bytes)
+        throw runtime_error("Cache is over its size limit");
+    }
+    cache.Reclaim();
+  }
+  if (loader.live != 0)
+    throw runtime_error("Tiles were not freed");
+}
+
+void TestConcurrentGet() {
+  GetConcurrently(0);
+}
+
+void TestConcurrentGetEvict() {
+  // Room for about a quarter of the tiles
+  GetConcurrently(50 * tile_size(3));
+}
+
+void TestRetiredTile() {
+  MemoryLoader loader;
+  GraphId id(100, 2, 0);
+  loader.AddTile(id, tile_size(1));
+  ConcurrentTileCache cache(make_hierarchy(), 0, &loader);
+  uint32_t early = cache.RegisterReader();
+  uint32_t late = cache.RegisterReader();
+
+  // A reader gets the tile and it is evicted while the reader is using it
+  cache.BeginRead(early);
+  const GraphTile* tile = cache.Get(id);
+  if (tile == nullptr || loader.live != 1)
+    throw runtime_error("Tile was not loaded");
+  if (!cache.Evict(id) || cache.size() != 0)
+    throw runtime_error("Tile was not evicted");
+
+  // A reader that begins after the eviction does not hold the tile
+  cache.BeginRead(late);
+  cache.Reclaim();
+  if (loader.live != 1 || tile->size() != tile_size(1))
+    throw runtime_error("Tile was freed while a reader could be using it");
+
+  // Read sections nest, so ending an inner section keeps the tile
+  cache.BeginRead(early);
+  cache.EndRead(early);
+  cache.Reclaim();
+  if (loader.live != 1)
+    throw runtime_error("Tile was freed when an inner read section ended");
+
+  // Once the earlier reader is done the tile is freed
+  cache.EndRead(early);
+  cache.Reclaim();
+  if (loader.live != 0)
+    throw runtime_error("Tile was not freed");
+  cache.EndRead(late);
+
+  // The evicted tile is loaded again on the next lookup
+  if (cache.Get(id) == nullptr || loader.Loads(id) != 2)
+    throw runtime_error("Evicted tile was not reloaded");
+}
+
+void TestMissingTiles() {
+  MemoryLoader loader;
+  loader.AddTile(GraphId(100, 2, 0), tile_size(1));
+  ConcurrentTileCache cache(make_hierarchy(), 0, &loader);
+
+  // A missing tile is looked up once
+  GraphId missing(101, 2, 0);
+  if (cache.Get(missing) != nullptr || cache.Get(GraphId(101, 2, 7)) != nullptr)
+    throw runtime_error("Got a tile that does not exist");
+  if (loader.Loads(missing) != 1)
+    throw runtime_error("Missing tile was looked up again");
+  TileCacheStats stats = cache.stats();
+  if (stats.misses != 1 || stats.hits != 1 || stats.bytes != 0)
+    throw runtime_error("Wrong stats for a missing tile");
+
+  // Missing tiles are not evicted and not loaded by a preload
+  if (cache.Evict(missing))
+    throw runtime_error("Evicted a missing tile");
+  cache.Preload({ missing, GraphId(102, 2, 0) });
+  if (loader.Loads(missing) != 1 || loader.Loads(GraphId(102, 2, 0)) != 1 ||
+      cache.Get(GraphId(102, 2, 0)) != nullptr)
+    throw runtime_error("Preload of missing tiles");
+
+  // Tile Ids outside the level
+  if (cache.Get(GraphId(2000000, 2, 0)) != nullptr ||
+      cache.Get(GraphId(5000, 0, 0)) != nullptr)
+    throw runtime_error("Got a tile outside the tile hierarchy");
+
+  // Existing tiles are unaffected
+  if (cache.Get(GraphId(100, 2, 0)) == nullptr)
+    throw runtime_error("Tile was not loaded");
+}
+
+void TestClockEviction() {
+  // Room for 10 tiles. Eviction goes down to 90% of the limit.
+  const size_t size = tile_size(7);
+  const size_t max_bytes = 10 * size;
+  MemoryLoader loader;
+  GraphId pinned(10, 0, 0);
+  loader.AddTile(pinned, size);
+  for (uint32_t i = 0; i < 40; i++) {
+    loader.AddTile(GraphId(1000 + i, 2, 0), size);
+  }
+  ConcurrentTileCache cache(make_hierarchy(), max_bytes, &loader);
+
+  // Load a highway tile then local tiles. Once one local tile (hot) is
+  // cached it is used before each load so it is referenced whenever the
+  // clock hand passes it.
+  GraphId hot(1005, 2, 0);
+  cache.Get(pinned);
+  uint64_t evictions = 0;
+  for (uint32_t i = 0; i < 40; i++) {
+    if (i > hot.tileid() - 1000) {
+      cache.Get(hot);
+    }
+    cache.Get(GraphId(1000 + i, 2, 0));
+    if (cache.size() > max_bytes)
+      throw runtime_error("Cache is over its size limit");
+    if (cache.stats().evictions > evictions) {
+      evictions = cache.stats().evictions;
+      if (cache.size() > max_bytes * 9 / 10)
+        throw runtime_error("Cache was not evicted below its low water mark");
+    }
+  }
+  if (evictions == 0)
+    throw runtime_error("No tiles were evicted");
+
+  // Evicted tiles are freed (there are no readers)
+  if (loader.live != cache.size() / size)
+    throw runtime_error("Evicted tiles were not freed");
+
+  // The highway tile is pinned and the hot tile was given second chances
+  if (cache.Get(pinned) == nullptr || loader.Loads(pinned) != 1)
+    throw runtime_error("Highway tile was evicted");
+  if (cache.Get(hot) == nullptr || loader.Loads(hot) != 1)
+    throw runtime_error("Recently used tile was evicted");
+
+  // Tiles that were not used again were evicted
+  if (cache.Get(GraphId(1002, 2, 0)) == nullptr ||
+      loader.Loads(GraphId(1002, 2, 0)) != 2)
+    throw runtime_error("Unused tile was not evicted");
+}
+
+void TestReaderTable() {
+  MemoryLoader loader;
+  loader.AddTile(GraphId(100, 2, 0), tile_size(1));
+
+  // The reader table is sized by the constructor (more readers than the
+  // default of 64)
+  constexpr uint32_t kReaders = 100;
+  ConcurrentTileCache cache(make_hierarchy(), 0, &loader, kReaders);
+  std::vector<uint32_t> readers;
+  for (uint32_t i = 0; i < kReaders; i++) {
+    readers.push_back(cache.RegisterReader());
+  }
+  std::sort(readers.begin(), readers.end());
+  if (std::unique(readers.begin(), readers.end()) != readers.end() ||
+      readers.back() != kReaders - 1)
+    throw runtime_error("Reader Ids are not distinct");
+  bool threw = false;
+  try {
+    cache.RegisterReader();
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  if (!threw)
+    throw runtime_error("Registered more readers than the reader table holds");
+
+  // Released reader Ids are reused
+  cache.ReleaseReader(readers[kReaders / 2]);
+  if (cache.RegisterReader() != readers[kReaders / 2])
+    throw runtime_error("Released reader Id was not reused");
+
+  // The last reader protects tiles it is using
+  uint32_t last = readers.back();
+  cache.BeginRead(last);
+  cache.Get(GraphId(100, 2, 0));
+  cache.Evict(GraphId(100, 2, 0));
+  cache.Reclaim();
+  if (loader.live != 1)
+    throw runtime_error("Tile was freed while the last reader could be using it");
+  cache.EndRead(last);
+  cache.Reclaim();
+  if (loader.live != 0)
+    throw runtime_error("Tile was not freed");
+}
+
+}
+
+int main() {
+  test::suite suite("concurrenttilecache");
+
+  // Lookups from several threads load each tile once
+  suite.test(TEST_CASE(TestConcurrentGet));
+
+  // Lookups from several threads while tiles are evicted
+  suite.test(TEST_CASE(TestConcurrentGetEvict));
+
+  // Evicted tiles are freed only after earlier readers are done
+  suite.test(TEST_CASE(TestRetiredTile));
+
+  // Tiles that do not exist
+  suite.test(TEST_CASE(TestMissingTiles));
+
+  // Size limited cache evicts with the CLOCK algorithm
+  suite.test(TEST_CASE(TestClockEviction));
+
+  // Reader table sized by the constructor with reuse of released readers
+  suite.test(TEST_CASE(TestReaderTable));
+
+  return suite.tear_down();
+}
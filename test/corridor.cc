@@ -0,0 +1,75 @@
+#include "test.h"
+
+#include <sstream>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "thor/corridor.h"
+
+using namespace std;
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace {
+
+TileHierarchy make_hierarchy() {
+  std::stringstream json;
+  json << "{\"tile_dir\": \"test/tiles\", \"levels\": ["
+          "{\"name\": \"highway\", \"level\": 0, \"size\": 4},"
+          "{\"name\": \"local\", \"level\": 2, \"size\": 0.25}]}";
+  boost::property_tree::ptree pt;
+  boost::property_tree::read_json(json, pt);
+  return TileHierarchy(pt);
+}
+
+// Node Id in the tile of a lat,lng at a level
+GraphId node_at(const TileHierarchy& hierarchy, const uint8_t level,
+                const PointLL& ll) {
+  return GraphId(hierarchy.levels().find(level)->second.tiles.TileId(ll),
+                 level, 5);
+}
+
+void TestRoute() {
+  // Route along a parallel with shape points only at its ends
+  TileHierarchy hierarchy = make_hierarchy();
+  Corridor corridor;
+  corridor.Build(hierarchy, { PointLL(-76.1f, 40.02f), PointLL(-73.9f, 40.02f) },
+                 5000.0f);
+
+  // Tiles along the whole route are in the corridor at each level
+  for (float lng = -76.1f; lng <= -73.9f; lng += 0.05f) {
+    if (!corridor.Contains(node_at(hierarchy, 2, PointLL(lng, 40.02f))) ||
+        !corridor.Contains(node_at(hierarchy, 0, PointLL(lng, 40.02f))))
+      throw runtime_error("Tile on the route is not in the corridor");
+  }
+
+  // Tiles within the radius are in, tiles further away are not
+  if (!corridor.Contains(node_at(hierarchy, 2, PointLL(-75.0f, 39.99f))))
+    throw runtime_error("Tile within the radius is not in the corridor");
+  if (corridor.Contains(node_at(hierarchy, 2, PointLL(-75.0f, 40.6f))) ||
+      corridor.Contains(node_at(hierarchy, 2, PointLL(-72.0f, 40.02f))))
+    throw runtime_error("Tile away from the route is in the corridor");
+}
+
+void TestEmpty() {
+  TileHierarchy hierarchy = make_hierarchy();
+  Corridor corridor;
+  corridor.Build(hierarchy, { }, 5000.0f);
+  if (corridor.size() != 0 ||
+      corridor.Contains(node_at(hierarchy, 2, PointLL(-75.0f, 40.02f))))
+    throw runtime_error("Empty route has a corridor");
+}
+
+}
+
+int main() {
+  test::suite suite("corridor");
+
+  // Tiles within the radius of a route
+  suite.test(TEST_CASE(TestRoute));
+
+  // No route, no tiles
+  suite.test(TEST_CASE(TestEmpty));
+
+  return suite.tear_down();
+}
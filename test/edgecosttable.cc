@@ -0,0 +1,127 @@
+#include "test.h"
+
+#include <atomic>
+#include <thread>
+
+#include "thor/edgecosttable.h"
+#include "testgraph.h"
+
+using namespace std;
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+using namespace valhalla::thor;
+using test::CountingCost;
+using test::TestGraph;
+
+namespace {
+
+// Routing graph of one tile with the given number of edges per node
+void MakeGraph(TestGraph& graph, const std::vector<uint32_t>& edge_counts) {
+  graph.AddTile(10);
+  for (auto count : edge_counts) {
+    for (uint32_t j = 0; j < count; j++) {
+      graph.AddEdge(RoutingGraph::kInvalidNode);
+    }
+    graph.AddNode(PointLL(-76.0f, 40.0f));
+  }
+}
+
+void TestEager() {
+  TestGraph graph;
+  MakeGraph(graph, { 2, 0, 3 });
+  std::shared_ptr<CountingCost> cost(new CountingCost(5.0f));
+  std::shared_ptr<DynamicCost> costing(cost);
+  EdgeCostTable table;
+  table.Customize(graph, costing, 1, true);
+  if (table.size() != 5 || table.fingerprint() != 1 || cost->edge_calls != 5 ||
+      table.computed() != 5)
+    throw runtime_error("Eager customization did not compute all edges");
+
+  // Reads and customizing for the same fingerprint do not call the costing
+  for (uint32_t e = 0; e < 5; e++) {
+    if (table.Get(e, graph.directededge(e), 0, *cost).cost != 5.0f ||
+        table.Get(e, graph.directededge(e), 0, *cost).secs != 10.0f)
+      throw runtime_error("Wrong edge cost");
+  }
+  table.Customize(graph, costing, 1, true);
+  if (cost->edge_calls != 5)
+    throw runtime_error("Edge costs were recomputed for the same fingerprint");
+}
+
+void TestIncremental() {
+  TestGraph graph;
+  MakeGraph(graph, { 2, 0, 3 });
+  std::shared_ptr<CountingCost> cost1(new CountingCost(5.0f));
+  std::shared_ptr<CountingCost> cost2(new CountingCost(7.0f));
+  std::shared_ptr<DynamicCost> costing1(cost1), costing2(cost2);
+  EdgeCostTable table;
+  table.Customize(graph, costing1, 1, false);
+  if (cost1->edge_calls != 0)
+    throw runtime_error("Lazy customization computed edge costs");
+  table.Get(0, graph.directededge(0), 0, *cost1);
+  table.Get(1, graph.directededge(1), 0, *cost1);
+  table.Get(0, graph.directededge(0), 0, *cost1);
+  if (cost1->edge_calls != 2 || table.computed() != 2)
+    throw runtime_error("Edge costs were not computed once when read");
+
+  // New costing options: only the edges read are recomputed
+  table.Customize(graph, costing2, 2, false);
+  if (table.Get(1, graph.directededge(1), 0, *cost2).cost != 7.0f ||
+      table.Get(4, graph.directededge(4), 0, *cost2).cost != 7.0f ||
+      cost2->edge_calls != 2 || table.computed() != 2)
+    throw runtime_error("Edge costs were not recomputed for new options");
+
+  // Back to the first options: entries computed for the second are stale
+  table.Customize(graph, costing1, 1, false);
+  if (table.Get(1, graph.directededge(1), 0, *cost1).cost != 5.0f)
+    throw runtime_error("Stale edge cost was read");
+}
+
+void TestShared() {
+  TestGraph graph;
+  MakeGraph(graph, { 2, 0, 3 });
+  std::shared_ptr<CountingCost> cost(new CountingCost(5.0f));
+  std::shared_ptr<DynamicCost> costing(cost);
+  EdgeCostTable table;
+  table.Customize(graph, costing, 1, true);
+
+  // Searches on several threads read an eagerly customized table without
+  // computing (writing) entries
+  std::atomic<uint32_t> errors(0);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < 4; t++) {
+    threads.emplace_back([&]() {
+      for (uint32_t n = 0; n < 1000; n++) {
+        for (uint32_t e = 0; e < 5; e++) {
+          if (table.Get(e, graph.directededge(e), 0, *cost).cost != 5.0f)
+            errors++;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (errors > 0)
+    throw runtime_error("Wrong edge cost");
+  if (cost->edge_calls != 5 || table.computed() != 5)
+    throw runtime_error("Edge costs were computed by a shared table");
+}
+
+}
+
+int main() {
+  test::suite suite("edgecosttable");
+
+  // Compute all edge costs
+  suite.test(TEST_CASE(TestEager));
+
+  // Recompute edge costs when read after the options change
+  suite.test(TEST_CASE(TestIncremental));
+
+  // Eagerly customized table read by several threads
+  suite.test(TEST_CASE(TestShared));
+
+  return suite.tear_down();
+}
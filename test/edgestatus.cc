@@ -54,6 +54,30 @@ void TestStatus() {
   TryGet(edgestatus, GraphId(555, 3, 1), kUnreached);
 }
 
+void TestDenseStatus() {
+  DenseEdgeStatus edgestatus;
+  edgestatus.Init(1000);
+  edgestatus.Set(0, kPermanent, 1);
+  edgestatus.Set(500, kTemporary, 2);
+  edgestatus.Set(999, kPermanent, 3);
+  if (edgestatus.Get(0).status.set != kPermanent ||
+      edgestatus.Get(500).status.set != kTemporary ||
+      edgestatus.Get(500).status.index != 2 ||
+      edgestatus.Get(999).status.index != 3 ||
+      edgestatus.Get(1).status.set != kUnreached)
+    throw runtime_error("DenseEdgeStatus get test failed");
+
+  // A new search sees all edges as unreached
+  edgestatus.Init(1000);
+  if (edgestatus.Get(0).status.set != kUnreached ||
+      edgestatus.Get(500).status.set != kUnreached ||
+      edgestatus.Get(999).status.set != kUnreached)
+    throw runtime_error("DenseEdgeStatus init test failed");
+  edgestatus.Set(500, kPermanent, 4);
+  if (edgestatus.Get(500).status.set != kPermanent)
+    throw runtime_error("DenseEdgeStatus set after init test failed");
+}
+
 }
 
 int main() {
@@ -62,5 +86,8 @@ int main() {
   // Test setting status, getting status, and clearing
   suite.test(TEST_CASE(TestStatus));
 
+  // Test the array based status for densely numbered edges
+  suite.test(TEST_CASE(TestDenseStatus));
+
   return suite.tear_down();
 }
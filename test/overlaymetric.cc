@@ -0,0 +1,182 @@
+#include "test.h"
+
+#include <queue>
+#include <valhalla/sif/edgelabel.h>
+
+#include "thor/overlaymetric.h"
+#include "testgraph.h"
+
+using namespace std;
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+using namespace valhalla::thor;
+using test::CountingCost;
+using test::TestGraph;
+
+namespace {
+
+constexpr uint32_t kGridSize = 8;
+
+// Routing graph of one tile: a grid of nodes with edges both ways between
+// neighbors
+void MakeGrid(TestGraph& graph) {
+  uint32_t n = kGridSize;
+  graph.AddTile(10);
+  for (uint32_t i = 0; i < n * n; i++) {
+    uint32_t x = i % n, y = i / n;
+    if (x > 0) graph.AddEdge(i - 1);
+    if (x + 1 < n) graph.AddEdge(i + 1);
+    if (y > 0) graph.AddEdge(i - n);
+    if (y + 1 < n) graph.AddEdge(i + n);
+    graph.AddNode(PointLL(x * 0.01f, y * 0.01f));
+  }
+}
+
+// Number of edges on the shortest path from a node to another within a
+// cell (breadth first search)
+float CellDistance(const TestGraph& graph, const Partition& partition,
+                   const uint32_t level, const uint32_t from,
+                   const uint32_t to) {
+  uint32_t cell = partition.cell(level, from);
+  std::vector<uint32_t> dist(graph.nodecount(), 0xffffffff);
+  std::queue<uint32_t> queue;
+  dist[from] = 0;
+  queue.push(from);
+  while (!queue.empty()) {
+    uint32_t node = queue.front();
+    queue.pop();
+    for (uint32_t e = graph.edge_index(node); e < graph.edge_index(node + 1); e++) {
+      uint32_t end = graph.edge(e).endnode;
+      if (partition.cell(level, end) == cell && dist[end] == 0xffffffff) {
+        dist[end] = dist[node] + 1;
+        queue.push(end);
+      }
+    }
+  }
+  return (dist[to] == 0xffffffff) ? OverlayMetric::kUnreachable : dist[to];
+}
+
+void TestOverlay() {
+  TestGraph graph;
+  MakeGrid(graph);
+  Partition partition;
+  partition.Build(graph, { 4, 16 });
+  OverlayGraph overlay;
+  overlay.Build(graph, partition);
+
+  // Every edge between cells is an entry of one cell and an exit of another
+  for (uint32_t level = 0; level < 2; level++) {
+    uint32_t entries = 0, exits = 0;
+    for (uint32_t cell = 0; cell < partition.cellcount(level); cell++) {
+      for (uint32_t i = 0; i < overlay.entry_count(level, cell); i++) {
+        uint32_t e = overlay.entries(level, cell)[i];
+        if (partition.cell(level, graph.edge(e).endnode) != cell ||
+            partition.cell(level, graph.startnode(e)) == cell ||
+            overlay.entry_index(level, e) != i)
+          throw runtime_error("Wrong cell entry");
+        entries++;
+      }
+      for (uint32_t i = 0; i < overlay.exit_count(level, cell); i++) {
+        uint32_t e = overlay.exits(level, cell)[i];
+        if (partition.cell(level, graph.startnode(e)) != cell ||
+            partition.cell(level, graph.edge(e).endnode) == cell ||
+            overlay.exit_index(level, e) != i)
+          throw runtime_error("Wrong cell exit");
+        exits++;
+      }
+    }
+    uint32_t cut = 0;
+    for (uint32_t e = 0; e < graph.edgecount(); e++) {
+      cut += partition.cell(level, graph.startnode(e)) !=
+             partition.cell(level, graph.edge(e).endnode);
+    }
+    if (entries != cut || exits != cut)
+      throw runtime_error("Wrong number of boundary edges");
+  }
+}
+
+void TestCliques() {
+  TestGraph graph;
+  MakeGrid(graph);
+  Partition partition;
+  partition.Build(graph, { 4, 16 });
+  OverlayGraph overlay;
+  overlay.Build(graph, partition);
+  // Every edge costs 1 and turns are free (the edges have no local indexes)
+  std::shared_ptr<DynamicCost> costing(new CountingCost(1.0f));
+  OverlayMetric metric;
+  metric.Customize(overlay, costing, 1, 2);
+  if (metric.fingerprint() != 1)
+    throw runtime_error("Wrong fingerprint");
+
+  // Clique costs are the shortest paths within the cell plus the exit
+  for (uint32_t level = 0; level < 2; level++) {
+    for (uint32_t cell = 0; cell < partition.cellcount(level); cell++) {
+      for (uint32_t i = 0; i < overlay.entry_count(level, cell); i++) {
+        uint32_t entry = overlay.entries(level, cell)[i];
+        const Cost* row = metric.Row(overlay, level, entry);
+        for (uint32_t j = 0; j < overlay.exit_count(level, cell); j++) {
+          uint32_t exit = overlay.exits(level, cell)[j];
+          float expected = CellDistance(graph, partition, level,
+                              graph.edge(entry).endnode, graph.startnode(exit)) + 1.0f;
+          if (row[j].cost != expected || row[j].secs != 2.0f * expected)
+            throw runtime_error("Wrong clique cost at level " + std::to_string(level));
+        }
+      }
+    }
+  }
+}
+
+void TestUnpack() {
+  TestGraph graph;
+  MakeGrid(graph);
+  Partition partition;
+  partition.Build(graph, { 4, 16 });
+  OverlayGraph overlay;
+  overlay.Build(graph, partition);
+  // Every edge costs 1 and turns are free (the edges have no local indexes)
+  std::shared_ptr<DynamicCost> costing(new CountingCost(1.0f));
+  OverlayMetric metric;
+  metric.Customize(overlay, costing, 1, 1);
+
+  // Unpacked level 1 arcs are connected paths inside the cell with the
+  // clique cost
+  std::vector<std::pair<uint32_t, Cost>> edges;
+  for (uint32_t cell = 0; cell < partition.cellcount(1); cell++) {
+    for (uint32_t i = 0; i < overlay.entry_count(1, cell); i++) {
+      uint32_t entry = overlay.entries(1, cell)[i];
+      const Cost* row = metric.Row(overlay, 1, entry);
+      for (uint32_t j = 0; j < overlay.exit_count(1, cell); j++) {
+        uint32_t exit = overlay.exits(1, cell)[j];
+        if (!metric.Unpack(overlay, *costing, 1, entry, exit, edges) ||
+            edges.empty() || edges.back().first != exit ||
+            edges.back().second.cost != row[j].cost)
+          throw runtime_error("Wrong unpacked clique arc");
+        uint32_t node = graph.edge(entry).endnode;
+        for (const auto& edge : edges) {
+          if (graph.startnode(edge.first) != node)
+            throw runtime_error("Unpacked edges are not connected");
+          node = graph.edge(edge.first).endnode;
+        }
+      }
+    }
+  }
+}
+
+}
+
+int main() {
+  test::suite suite("overlaymetric");
+
+  // Cell entries and exits of the overlay
+  suite.test(TEST_CASE(TestOverlay));
+
+  // Customized clique costs
+  suite.test(TEST_CASE(TestCliques));
+
+  // Unpack clique arcs into graph edges
+  suite.test(TEST_CASE(TestUnpack));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,132 @@
+#include "test.h"
+
+#include <cstdio>
+
+#include "thor/partition.h"
+#include "testgraph.h"
+
+using namespace std;
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+using test::TestGraph;
+
+namespace {
+
+const std::string kSnapshotFile = "test/partition.snapshot";
+
+// Routing graph of one tile: a grid of nodes with edges to their right and
+// upper neighbors. With copies, each node has a copy at the same location
+// (as on another hierarchy level) connected by transition edges.
+void MakeGrid(TestGraph& graph, const uint32_t n, const bool copies) {
+  uint32_t count = copies ? 2 * n * n : n * n;
+  graph.AddTile(10);
+  for (uint32_t i = 0; i < count; i++) {
+    uint32_t x = (i % (n * n)) % n, y = (i % (n * n)) / n;
+    if (i < n * n) {
+      if (x + 1 < n) graph.AddEdge(i + 1);
+      if (y + 1 < n) graph.AddEdge(i + n);
+    }
+    if (copies) graph.AddEdge((i + n * n) % count, DirectedEdge(), true);
+    graph.AddNode(PointLL(x * 0.01f, y * 0.01f));
+  }
+}
+
+void TestCells() {
+  TestGraph graph;
+  MakeGrid(graph, 16, false);
+  Partition partition;
+  partition.Build(graph, { 8, 64 });
+  if (partition.levels() != 2 || partition.cellcount(0) != 32 ||
+      partition.cellcount(1) != 4)
+    throw runtime_error("Wrong number of cells");
+
+  // Cells are within their size and nested
+  std::vector<uint32_t> sizes0(partition.cellcount(0)), sizes1(partition.cellcount(1));
+  std::vector<uint32_t> parents(partition.cellcount(0), 0xffffffff);
+  for (uint32_t node = 0; node < graph.nodecount(); node++) {
+    uint32_t cell0 = partition.cell(0, node), cell1 = partition.cell(1, node);
+    sizes0[cell0]++;
+    sizes1[cell1]++;
+    if (parents[cell0] != 0xffffffff && parents[cell0] != cell1)
+      throw runtime_error("Cells are not nested");
+    parents[cell0] = cell1;
+  }
+  for (auto size : sizes0) {
+    if (size == 0 || size > 8)
+      throw runtime_error("Wrong level 0 cell size");
+  }
+  for (auto size : sizes1) {
+    if (size == 0 || size > 64)
+      throw runtime_error("Wrong level 1 cell size");
+  }
+
+  // Cells are compact: neighbors of a level 0 cell's nodes are close
+  for (uint32_t node = 0; node < graph.nodecount(); node++) {
+    for (uint32_t other = 0; other < graph.nodecount(); other++) {
+      if (partition.cell(0, node) == partition.cell(0, other) &&
+          graph.latlng(node).Distance(graph.latlng(other)) > 5000.0f)
+        throw runtime_error("Level 0 cell is not compact");
+    }
+  }
+}
+
+void TestTransitions() {
+  // Copies of a location are in the same cells
+  TestGraph graph;
+  MakeGrid(graph, 8, true);
+  Partition partition;
+  partition.Build(graph, { 4, 16 });
+  for (uint32_t node = 0; node < 64; node++) {
+    if (partition.cell(0, node) != partition.cell(0, node + 64) ||
+        partition.cell(1, node) != partition.cell(1, node + 64))
+      throw runtime_error("Node copies are in different cells");
+  }
+  if (partition.cellcount(0) != 16)
+    throw runtime_error("Copies were counted in the cell sizes");
+}
+
+void TestSnapshot() {
+  TestGraph graph;
+  MakeGrid(graph, 8, false);
+  Partition partition;
+  partition.Build(graph, { 4, 16 });
+  SnapshotWriter writer;
+  partition.Write(writer);
+  if (!writer.Write(kSnapshotFile))
+    throw runtime_error("Could not write the snapshot");
+
+  Snapshot snapshot;
+  Partition loaded;
+  if (!snapshot.Load(kSnapshotFile) || !loaded.Load(snapshot, graph.nodecount()))
+    throw runtime_error("Could not load the partition");
+  if (loaded.levels() != 2 || loaded.cellcount(0) != partition.cellcount(0))
+    throw runtime_error("Loaded partition has the wrong levels");
+  for (uint32_t node = 0; node < graph.nodecount(); node++) {
+    if (loaded.cell(0, node) != partition.cell(0, node) ||
+        loaded.cell(1, node) != partition.cell(1, node))
+      throw runtime_error("Loaded partition has the wrong cells");
+  }
+
+  // A partition of another graph is not loaded
+  if (loaded.Load(snapshot, graph.nodecount() + 1))
+    throw runtime_error("Loaded a partition of another graph");
+  std::remove(kSnapshotFile.c_str());
+}
+
+}
+
+int main() {
+  test::suite suite("partition");
+
+  // Nested cells within their sizes
+  suite.test(TEST_CASE(TestCells));
+
+  // Nodes connected by transition edges share cells
+  suite.test(TEST_CASE(TestTransitions));
+
+  // Write and load a partition
+  suite.test(TEST_CASE(TestSnapshot));
+
+  return suite.tear_down();
+}
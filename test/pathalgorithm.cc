@@ -0,0 +1,598 @@
+#include "test.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <boost/filesystem/operations.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/sif/edgelabel.h>
+
+#include "thor/concurrenttilecache.h"
+#include "thor/edgecosttable.h"
+#include "thor/pathalgorithm.h"
+#include "thor/pathcost.h"
+#include "thor/routinggraph.h"
+#include "thor/tilearchive.h"
+#include "thor/transitioncosttable.h"
+
+using namespace std;
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+using namespace valhalla::thor;
+
+namespace {
+
+// Grid of nodes (kGridSize by kGridSize, kGridSpacing degrees apart) with
+// edges in both directions between neighboring nodes. All of it is in one
+// local level tile.
+constexpr uint32_t kGridSize = 16;
+constexpr float kGridSpacing = 0.01f;
+const PointLL kGridOrigin(-76.49f, 40.01f);
+const std::string kTileDir = "test/pathalgorithm_tiles";
+
+boost::property_tree::ptree make_config(const std::string& tile_dir = kTileDir) {
+  std::stringstream json;
+  json << "{\"tile_dir\": \"" << tile_dir << "\", \"levels\": ["
+          "{\"name\": \"local\", \"level\": 2, \"size\": 0.25}]}";
+  boost::property_tree::ptree config;
+  boost::property_tree::read_json(json, config);
+  return config;
+}
+
+GraphId grid_tile() {
+  TileHierarchy hierarchy(make_config());
+  return GraphId(hierarchy.levels().at(2).tiles.TileId(kGridOrigin), 2, 0);
+}
+
+PointLL grid_ll(const uint32_t node) {
+  return PointLL(kGridOrigin.lng() + (node % kGridSize) * kGridSpacing,
+                 kGridOrigin.lat() + (node / kGridSize) * kGridSpacing);
+}
+
+// Neighbors of a node in the order of its edges (east, north, west, south)
+std::vector<uint32_t> neighbors(const uint32_t node) {
+  std::vector<uint32_t> nodes;
+  uint32_t x = node % kGridSize, y = node / kGridSize;
+  if (x + 1 < kGridSize) nodes.push_back(node + 1);
+  if (y + 1 < kGridSize) nodes.push_back(node + kGridSize);
+  if (x > 0) nodes.push_back(node - 1);
+  if (y > 0) nodes.push_back(node - kGridSize);
+  return nodes;
+}
+
+// Length of the edges between two nodes. Edges are longer than the
+// distance between their nodes by a varying amount so paths rarely tie.
+uint32_t edge_length(const uint32_t a, const uint32_t b) {
+  uint32_t jitter = (a * b + a + b) % 11;
+  return static_cast<uint32_t>(grid_ll(a).Distance(grid_ll(b)) *
+                               (1.0f + jitter / 20.0f));
+}
+
+// Write the tile of the grid
+void write_grid_tile() {
+  GraphId tileid = grid_tile();
+  std::vector<NodeInfo> nodes(kGridSize * kGridSize);
+  std::vector<DirectedEdge> edges;
+  for (uint32_t n = 0; n < nodes.size(); n++) {
+    nodes[n].set_latlng(grid_ll(n));
+    nodes[n].set_edge_index(edges.size());
+    std::vector<uint32_t> ends = neighbors(n);
+    nodes[n].set_edge_count(ends.size());
+    for (uint32_t i = 0; i < ends.size(); i++) {
+      std::vector<uint32_t> back = neighbors(ends[i]);
+      DirectedEdge edge;
+      edge.set_endnode(GraphId(tileid.tileid(), tileid.level(), ends[i]));
+      edge.set_length(edge_length(n, ends[i]));
+      edge.set_localedgeidx(i);
+      edge.set_opp_index(std::find(back.begin(), back.end(), n) - back.begin());
+      edges.push_back(edge);
+    }
+  }
+
+  uint32_t size = sizeof(GraphTileHeader) + nodes.size() * sizeof(NodeInfo) +
+                  edges.size() * sizeof(DirectedEdge);
+  GraphTileHeader header;
+  header.set_graphid(tileid);
+  header.set_nodecount(nodes.size());
+  header.set_directededgecount(edges.size());
+  header.set_edgeinfo_offset(size);
+  header.set_textlist_offset(size);
+
+  TileHierarchy hierarchy(make_config());
+  std::string file = kTileDir + "/" + GraphTile::FileSuffix(tileid, hierarchy);
+  boost::filesystem::create_directories(
+      boost::filesystem::path(file).parent_path());
+  std::ofstream out(file, std::ios::out | std::ios::binary | std::ios::trunc);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(nodes.data()),
+            nodes.size() * sizeof(NodeInfo));
+  out.write(reinterpret_cast<const char*>(edges.data()),
+            edges.size() * sizeof(DirectedEdge));
+}
+
+// Location at a grid node (loki gives the edges leaving the node)
+PathLocation node_location(GraphReader& reader, const uint32_t node) {
+  GraphId nodeid(grid_tile().tileid(), 2, node);
+  const NodeInfo* nodeinfo = reader.GetGraphTile(nodeid)->node(nodeid);
+  PathLocation location(Location(nodeinfo->latlng()));
+  GraphId edgeid(nodeid.tileid(), nodeid.level(), nodeinfo->edge_index());
+  for (uint32_t i = 0; i < nodeinfo->edge_count(); i++, edgeid++) {
+    location.CorrelateEdge(PathLocation::PathEdge(edgeid, 0.0f));
+  }
+  location.CorrelateVertex(nodeinfo->latlng());
+  return location;
+}
+
+// Costing where the cost of an edge is its length (at 10 meters per second)
+class LengthCost : public DynamicCost {
+ public:
+  LengthCost()
+      : DynamicCost(boost::property_tree::ptree(), TravelMode::kDrive) {
+  }
+  virtual bool Allowed(const DirectedEdge* edge, const EdgeLabel& pred) const {
+    return true;
+  }
+  virtual bool Allowed(const NodeInfo* node) const {
+    return true;
+  }
+  virtual Cost EdgeCost(const DirectedEdge* edge, const uint32_t density) const {
+    return Cost(edge->length(), edge->length() / 10.0f);
+  }
+  virtual float AStarCostFactor() const {
+    return 0.5f;
+  }
+  virtual const EdgeFilter GetFilter() const {
+    return [](const DirectedEdge* edge) { return 0.0f; };
+  }
+};
+
+// Length of a path
+uint32_t path_length(GraphReader& reader, const std::vector<PathInfo>& path) {
+  uint32_t length = 0;
+  for (const auto& info : path) {
+    length += reader.GetGraphTile(info.edgeid)->directededge(info.edgeid)->length();
+  }
+  return length;
+}
+
+void TestRerouteOnRoute() {
+  write_grid_tile();
+  GraphReader reader(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathAlgorithm pathalgorithm;
+  PathLocation dest = node_location(reader, kGridSize * kGridSize - 1);
+  std::vector<PathInfo> route = pathalgorithm.GetBestPath(
+      node_location(reader, 0), dest, reader, costing);
+  pathalgorithm.Clear();
+  if (route.size() < 4)
+    throw runtime_error("Expected a route across the grid");
+
+  // Reroute from the start node of an edge in the middle of the route.
+  // The rest of the route is still the best path so it is reused.
+  uint32_t k = route.size() / 2;
+  GraphId edgeid = route[k].edgeid;
+  GraphId opp = reader.GetOpposingEdgeId(edgeid);
+  uint32_t start = reader.GetGraphTile(opp)->directededge(opp)->endnode().id();
+  PathLocation position = node_location(reader, start);
+  std::vector<PathInfo> rerouted = pathalgorithm.GetBestPathReroute(
+      position, dest, route, reader, costing);
+  pathalgorithm.Clear();
+  if (rerouted.size() != route.size() - k)
+    throw runtime_error("Rerouting did not reuse the rest of the route");
+  for (uint32_t i = 0; i < rerouted.size(); i++) {
+    if (rerouted[i].edgeid != route[k + i].edgeid)
+      throw runtime_error("Rerouting did not reuse the rest of the route");
+  }
+
+  // Same cost as a search from the position
+  std::vector<PathInfo> fresh = pathalgorithm.GetBestPath(position, dest,
+                                                          reader, costing);
+  pathalgorithm.Clear();
+  if (path_length(reader, rerouted) != path_length(reader, fresh))
+    throw runtime_error("Rerouted path does not match a new search");
+}
+
+void TestRerouteOffRoute() {
+  write_grid_tile();
+  GraphReader reader(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathAlgorithm pathalgorithm;
+  PathLocation dest = node_location(reader, kGridSize * kGridSize - 1);
+  std::vector<PathInfo> route = pathalgorithm.GetBestPath(
+      node_location(reader, 0), dest, reader, costing);
+  pathalgorithm.Clear();
+
+  // Reroute from each node off the route. The cost is that of a search
+  // from the node.
+  std::set<uint32_t> onroute = { 0 };
+  for (const auto& info : route) {
+    onroute.insert(reader.GetGraphTile(info.edgeid)->directededge(info.edgeid)->endnode().id());
+  }
+  uint32_t tested = 0;
+  for (uint32_t n = 0; n < kGridSize * kGridSize; n++) {
+    if (onroute.count(n) > 0) {
+      continue;
+    }
+    PathLocation position = node_location(reader, n);
+    std::vector<PathInfo> rerouted = pathalgorithm.GetBestPathReroute(
+        position, dest, route, reader, costing);
+    pathalgorithm.Clear();
+    std::vector<PathInfo> fresh = pathalgorithm.GetBestPath(position, dest,
+                                                            reader, costing);
+    pathalgorithm.Clear();
+    if (rerouted.empty() ||
+        path_length(reader, rerouted) != path_length(reader, fresh))
+      throw runtime_error("Rerouted path does not match a new search from node " +
+                          std::to_string(n));
+    tested++;
+  }
+  if (tested == 0)
+    throw runtime_error("Expected nodes off the route");
+}
+
+void TestAnytimeDeadline() {
+  write_grid_tile();
+  GraphReader reader(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathAlgorithm pathalgorithm;
+  PathLocation origin = node_location(reader, 0);
+  PathLocation dest = node_location(reader, kGridSize * kGridSize - 2);
+  uint32_t optimal = path_length(reader,
+      pathalgorithm.GetBestPath(origin, dest, reader, costing));
+  pathalgorithm.Clear();
+
+  // The deadline has passed when the search first checks it, which is
+  // after the first (weighted) iteration settled a destination edge but
+  // before it ended. The path found is within its bound.
+  float bound;
+  std::vector<PathInfo> path = pathalgorithm.GetBestPathAnytime(origin, dest,
+      reader, costing, std::chrono::steady_clock::now(), 2.0f, bound);
+  pathalgorithm.Clear();
+  if (path.empty() || bound > 2.0f)
+    throw runtime_error("Expected the bound of the first iteration");
+  if (path_length(reader, path) > (1.0f + bound) * optimal)
+    throw runtime_error("Path exceeds its bound");
+
+  // Without a deadline the search ends with the optimal path
+  path = pathalgorithm.GetBestPathAnytime(origin, dest, reader, costing,
+      std::chrono::steady_clock::now() + std::chrono::hours(1), 2.0f, bound);
+  pathalgorithm.Clear();
+  if (bound != 0.0f || path_length(reader, path) != optimal)
+    throw runtime_error("Expected the optimal path");
+}
+
+void TestAnytimeBounded() {
+  write_grid_tile();
+  GraphReader reader(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathAlgorithm pathalgorithm;
+  PathLocation origin = node_location(reader, kGridSize + 1);
+  PathLocation dest = node_location(reader, kGridSize * kGridSize - 3);
+  uint32_t optimal = path_length(reader,
+      pathalgorithm.GetBestPath(origin, dest, reader, costing));
+  pathalgorithm.Clear();
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::hours(1);
+  float bound;
+  pathalgorithm.GetBestPathAnytime(origin, dest, reader, costing, deadline,
+                                   2.0f, bound);
+  SearchStats unbounded = pathalgorithm.stats();
+  pathalgorithm.Clear();
+
+  // Bounded by the optimal cost (the cost is the length) the anytime search
+  // finds the same path and prunes labels the unbounded search created
+  std::vector<PathInfo> path = pathalgorithm.GetBestPathAnytime(origin, dest,
+      reader, costing, deadline, 2.0f, bound, optimal + 1.0f);
+  SearchStats bounded = pathalgorithm.stats();
+  pathalgorithm.Clear();
+  if (bound != 0.0f || path_length(reader, path) != optimal)
+    throw runtime_error("Expected the optimal path");
+  if (bounded.pruned == 0 || bounded.labels >= unbounded.labels)
+    throw runtime_error("Anytime search did not prune with the cost bound");
+}
+
+void TestWeighted() {
+  write_grid_tile();
+  GraphReader reader(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathAlgorithm pathalgorithm;
+  PathLocation dest = node_location(reader, kGridSize * kGridSize - 2);
+
+  // The grid has one level so hierarchy limits do not prune and weighted
+  // paths cost at most (1 + epsilon) times the optimal path
+  uint32_t labels = 0, weighted_labels = 0;
+  for (uint32_t origin : { 0u, 3u, kGridSize + 5, 7 * kGridSize }) {
+    PathLocation location = node_location(reader, origin);
+    pathalgorithm.SetEpsilon(0.0f);
+    uint32_t optimal = path_length(reader,
+        pathalgorithm.GetBestPath(location, dest, reader, costing));
+    labels += pathalgorithm.stats().labels;
+    pathalgorithm.Clear();
+    for (float epsilon : { 0.25f, 1.0f, 3.0f }) {
+      pathalgorithm.SetEpsilon(epsilon);
+      std::vector<PathInfo> path = pathalgorithm.GetBestPath(location, dest,
+                                                             reader, costing);
+      if (epsilon == 3.0f) {
+        weighted_labels += pathalgorithm.stats().labels;
+      }
+      pathalgorithm.Clear();
+      if (path.empty() || path_length(reader, path) > (1.0f + epsilon) * optimal)
+        throw runtime_error("Weighted path exceeds its bound from node " +
+                            std::to_string(origin));
+    }
+  }
+  if (weighted_labels >= labels)
+    throw runtime_error("Weighted search did not expand fewer labels");
+}
+
+void TestWarmStart() {
+  write_grid_tile();
+  GraphReader reader(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathLocation origin = node_location(reader, kGridSize + 2);
+  PathAlgorithm warm;
+  warm.SetWarmStart(100000);
+
+  // Routes from one origin (without Clear between them) resume the search
+  // tree of the previous route. Each costs the same as a cold search and
+  // expands fewer labels: none for a destination the tree already settled.
+  for (uint32_t node : { 6 * kGridSize + 9, 3 * kGridSize + 4,
+                         kGridSize * kGridSize - 1, 12 * kGridSize + 1 }) {
+    PathLocation dest = node_location(reader, node);
+    std::vector<PathInfo> resumed = warm.GetBestPath(origin, dest, reader,
+                                                     costing, 1);
+    uint32_t expansions = warm.stats().expansions;
+    PathAlgorithm cold;
+    std::vector<PathInfo> path = cold.GetBestPath(origin, dest, reader, costing);
+    if (resumed.empty() || path_length(reader, resumed) != path_length(reader, path))
+      throw runtime_error("Resumed route does not match a cold search to node " +
+                          std::to_string(node));
+    if (node != 6 * kGridSize + 9 && expansions >= cold.stats().expansions)
+      throw runtime_error("Route to node " + std::to_string(node) +
+                          " did not resume the search tree");
+    if (node == 3 * kGridSize + 4 && expansions != 0)
+      throw runtime_error("Settled destination was expanded again");
+  }
+  warm.Clear();
+}
+
+void TestBounded() {
+  write_grid_tile();
+  GraphReader reader(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathAlgorithm pathalgorithm;
+
+  // The search bounded by the cost of the coarse route (on one level the
+  // optimal route) finds the same route as the unbounded search and prunes
+  // labels the unbounded search created
+  for (uint32_t origin : { 0u, kGridSize + 1, 5 * kGridSize + 11 }) {
+    PathLocation location = node_location(reader, origin);
+    PathLocation dest = node_location(reader, kGridSize * kGridSize - 3);
+    std::vector<PathInfo> path = pathalgorithm.GetBestPath(location, dest,
+                                                           reader, costing);
+    SearchStats unbounded = pathalgorithm.stats();
+    pathalgorithm.Clear();
+    std::vector<PathInfo> bounded = pathalgorithm.GetBestPathBounded(
+        location, dest, reader, costing);
+    SearchStats stats = pathalgorithm.stats();
+    pathalgorithm.Clear();
+    if (bounded.size() != path.size())
+      throw runtime_error("Bounded search found a different route from node " +
+                          std::to_string(origin));
+    for (uint32_t i = 0; i < path.size(); i++) {
+      if (bounded[i].edgeid != path[i].edgeid)
+        throw runtime_error("Bounded search found a different route from node " +
+                            std::to_string(origin));
+    }
+    if (stats.pruned == 0 || stats.labels >= unbounded.labels)
+      throw runtime_error("Bounded search did not prune from node " +
+                          std::to_string(origin));
+  }
+}
+
+void TestCostToNode() {
+  write_grid_tile();
+  GraphReader reader(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathAlgorithm pathalgorithm;
+  PathLocation origin = node_location(reader, 1);
+  PathLocation dest = node_location(reader, kGridSize * kGridSize - 2);
+  std::vector<PathInfo> path = pathalgorithm.GetBestPath(origin, dest,
+                                                         reader, costing);
+  pathalgorithm.Clear();
+
+  // The destination is at a node so the path ends at the end of the last
+  // edge: the cost and length are those of the whole path
+  PathCost pathcost;
+  if (!pathalgorithm.GetBestCost(origin, dest, reader, costing, pathcost))
+    throw runtime_error("Expected a path cost");
+  float length = path_length(reader, path);
+  if (std::abs(pathcost.length - length) > 1.0f ||
+      std::abs(pathcost.cost.cost - length) > 1.0f ||
+      std::abs(pathcost.cost.secs - length / 10.0f) > 0.1f)
+    throw runtime_error("Path cost does not match the path");
+
+  // A second search with the same algorithm gets the same cost
+  PathCost again;
+  if (!pathalgorithm.GetBestCost(origin, dest, reader, costing, again) ||
+      again.length != pathcost.length || again.cost.cost != pathcost.cost.cost)
+    throw runtime_error("Path cost changed on the second search");
+}
+
+void TestGraphCosts() {
+  write_grid_tile();
+  GraphReader reader(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathAlgorithm pathalgorithm;
+  PathLocation origin = node_location(reader, 1);
+  PathLocation dest = node_location(reader, kGridSize * kGridSize - 2);
+  std::vector<PathInfo> tilepath = pathalgorithm.GetBestPath(origin, dest,
+                                                             reader, costing);
+  pathalgorithm.Clear();
+
+  RoutingGraph graph;
+  AABB2<PointLL> region(kGridOrigin.lng() - 0.01f, kGridOrigin.lat() - 0.01f,
+                        kGridOrigin.lng() + kGridSize * kGridSpacing,
+                        kGridOrigin.lat() + kGridSize * kGridSpacing);
+  if (!graph.Build(reader, region) || graph.nodecount() != kGridSize * kGridSize)
+    throw runtime_error("Could not build the routing graph");
+  EdgeCostTable edgecosts;
+  edgecosts.Customize(graph, costing, 1, false);
+  TransitionCostTable transitioncosts;
+  transitioncosts.Customize(graph, costing, 1, false);
+
+  // Each combination of customized tables (a kernel instantiation each)
+  // finds the path of the tile search
+  std::vector<std::pair<EdgeCostTable*, TransitionCostTable*>> tables = {
+    { nullptr, nullptr }, { &edgecosts, nullptr },
+    { nullptr, &transitioncosts }, { &edgecosts, &transitioncosts } };
+  for (const auto& table : tables) {
+    std::vector<PathInfo> path = pathalgorithm.GetBestPath(origin, dest, graph,
+        reader, costing, table.first, table.second);
+    pathalgorithm.Clear();
+    if (path.size() != tilepath.size())
+      throw runtime_error("Routing graph path differs from the tile path");
+    for (uint32_t i = 0; i < path.size(); i++) {
+      if (path[i].edgeid != tilepath[i].edgeid ||
+          path[i].elapsed_time != tilepath[i].elapsed_time)
+        throw runtime_error("Routing graph path differs from the tile path");
+    }
+  }
+  if (edgecosts.computed() == 0)
+    throw runtime_error("Edge cost table was not used");
+}
+
+// Graph reader that tells how many tiles it has cached
+class CountingReader : public GraphReader {
+ public:
+  CountingReader(const boost::property_tree::ptree& config)
+      : GraphReader(config) {
+  }
+  size_t tiles() const {
+    return cache_.size();
+  }
+};
+
+void TestSharedTileCache() {
+  write_grid_tile();
+  GraphReader locations(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathLocation origin = node_location(locations, 2);
+  PathLocation dest = node_location(locations, kGridSize * kGridSize - 3);
+  PathAlgorithm pathalgorithm;
+  std::vector<PathInfo> expected = pathalgorithm.GetBestPath(origin, dest,
+                                       locations, costing);
+  pathalgorithm.Clear();
+
+  // With a shared cache the search (including the destination at a node
+  // and forming the path) reads no tiles through the graph reader. Setting
+  // the cache again keeps the search's reader (the cache has room for one).
+  CountingReader reader(make_config());
+  TileHierarchy hierarchy(make_config());
+  ConcurrentTileCache tilecache(hierarchy, 0, nullptr, 1);
+  pathalgorithm.SetTileCache(&tilecache);
+  pathalgorithm.SetTileCache(&tilecache);
+  std::vector<PathInfo> path = pathalgorithm.GetBestPath(origin, dest, reader,
+                                                         costing);
+  pathalgorithm.Clear();
+  if (path.empty() || path.size() != expected.size())
+    throw runtime_error("Path differs with a shared tile cache");
+  for (uint32_t i = 0; i < path.size(); i++) {
+    if (path[i].edgeid != expected[i].edgeid)
+      throw runtime_error("Path differs with a shared tile cache");
+  }
+  PathCost pathcost;
+  if (!pathalgorithm.GetBestCost(origin, dest, reader, costing, pathcost))
+    throw runtime_error("No cost with a shared tile cache");
+  if (reader.tiles() != 0)
+    throw runtime_error("Tiles were read through the graph reader");
+
+  // Reader Ids are released when the cache is unset or the search is
+  // destroyed, so other searches can register
+  pathalgorithm.SetTileCache(nullptr);
+  {
+    PathAlgorithm other;
+    other.SetTileCache(&tilecache);
+  }
+  PathAlgorithm other;
+  other.SetTileCache(&tilecache);
+}
+
+void TestArchiveOnly() {
+  write_grid_tile();
+  GraphReader locations(make_config());
+  std::shared_ptr<DynamicCost> costing(new LengthCost());
+  PathLocation origin = node_location(locations, kGridSize);
+  PathLocation dest = node_location(locations, kGridSize * kGridSize - 1);
+
+  // Pack the grid tile into an archive and remove the tile file
+  TileHierarchy hierarchy(make_config());
+  std::string file = kTileDir + "/" + GraphTile::FileSuffix(grid_tile(), hierarchy);
+  std::string archive_file = kTileDir + "/tiles.bin";
+  if (!TileArchive::Write(archive_file, { { grid_tile(), file } }))
+    throw runtime_error("Could not write the tile archive");
+  boost::filesystem::remove(file);
+  TileArchive archive;
+  if (!archive.Load(archive_file))
+    throw runtime_error("Could not load the tile archive");
+
+  // The graph reader's tile directory does not exist - every tile is
+  // loaded from the archive through the shared cache
+  ArchiveTileLoader loader(archive);
+  ConcurrentTileCache tilecache(hierarchy, 0, &loader);
+  CountingReader reader(make_config(kTileDir + "/missing"));
+  PathAlgorithm pathalgorithm;
+  pathalgorithm.SetTileCache(&tilecache);
+  std::vector<PathInfo> path = pathalgorithm.GetBestPath(origin, dest, reader,
+                                                         costing);
+  pathalgorithm.Clear();
+  if (path.empty())
+    throw runtime_error("No path on the archived tiles");
+  if (reader.tiles() != 0)
+    throw runtime_error("Tiles were read through the graph reader");
+  boost::filesystem::remove(archive_file);
+}
+
+}
+
+int main() {
+  test::suite suite("pathalgorithm");
+
+  // Rerouting from the previous route reuses the rest of it
+  suite.test(TEST_CASE(TestRerouteOnRoute));
+
+  // Rerouting from off the route costs the same as a new search
+  suite.test(TEST_CASE(TestRerouteOffRoute));
+
+  // Anytime search ended by the deadline during its first iteration
+  suite.test(TEST_CASE(TestAnytimeDeadline));
+
+  // Anytime search pruned by a cost bound
+  suite.test(TEST_CASE(TestAnytimeBounded));
+
+  // Weighted A* paths are within their suboptimality bound
+  suite.test(TEST_CASE(TestWeighted));
+
+  // Routes resumed from the search tree of the previous route
+  suite.test(TEST_CASE(TestWarmStart));
+
+  // Search bounded by the cost of a coarse route
+  suite.test(TEST_CASE(TestBounded));
+
+  // Cost only search to a destination at a node
+  suite.test(TEST_CASE(TestCostToNode));
+
+  // Routing graph search with and without customized cost tables
+  suite.test(TEST_CASE(TestGraphCosts));
+
+  // Searches with a shared tile cache read their tiles from it
+  suite.test(TEST_CASE(TestSharedTileCache));
+
+  // Searches on tiles from a tile archive without a tile directory
+  suite.test(TEST_CASE(TestArchiveOnly));
+
+  return suite.tear_down();
+}
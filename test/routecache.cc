@@ -0,0 +1,148 @@
+#include "test.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "thor/routecache.h"
+
+using namespace std;
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+using namespace valhalla::thor;
+
+namespace {
+
+std::vector<PathInfo> make_path(const uint32_t n) {
+  std::vector<PathInfo> path;
+  for (uint32_t i = 0; i < n; i++) {
+    path.emplace_back(TravelMode::kDrive, i * 10, GraphId(100, 2, i), 0);
+  }
+  return path;
+}
+
+void TestPutGet() {
+  RouteCache cache(10, 1024 * 1024, 300);
+  std::vector<PathInfo> path;
+  if (cache.Get("a", path) || cache.misses() != 1)
+    throw runtime_error("Found a route in an empty cache");
+
+  cache.Put("a", make_path(5));
+  if (!cache.Get("a", path) || cache.hits() != 1)
+    throw runtime_error("Cached route was not found");
+  if (path.size() != 5 || path[3].edgeid != GraphId(100, 2, 3) ||
+      path[3].elapsed_time != 30)
+    throw runtime_error("Cached route is wrong");
+
+  // Replacing a route keeps a single entry
+  cache.Put("a", make_path(2));
+  if (!cache.Get("a", path) || path.size() != 2 || cache.size() != 1)
+    throw runtime_error("Cached route was not replaced");
+
+  // Empty keys are not cached
+  cache.Put("", make_path(2));
+  if (cache.size() != 1)
+    throw runtime_error("Route with an empty key was cached");
+}
+
+void TestLRU() {
+  RouteCache cache(2, 1024 * 1024, 300);
+  std::vector<PathInfo> path;
+  cache.Put("a", make_path(1));
+  cache.Put("b", make_path(1));
+  cache.Get("a", path);
+  cache.Put("c", make_path(1));
+  if (cache.size() != 2 || cache.evictions() != 1)
+    throw runtime_error("Cache exceeded max entries");
+  if (cache.Get("b", path))
+    throw runtime_error("Least recently used route was not evicted");
+  if (!cache.Get("a", path) || !cache.Get("c", path))
+    throw runtime_error("Recently used route was evicted");
+}
+
+void TestMaxBytes() {
+  const size_t max_bytes = 4096;
+  RouteCache cache(1000, max_bytes, 300);
+  for (uint32_t i = 0; i < 100; i++) {
+    cache.Put(std::to_string(i), make_path(10));
+    if (cache.bytes() > max_bytes)
+      throw runtime_error("Cache exceeded max bytes");
+  }
+  std::vector<PathInfo> path;
+  if (cache.size() == 0 || !cache.Get("99", path))
+    throw runtime_error("Most recent route was not cached");
+
+  // A route larger than the cache is not cached
+  cache.Put("big", make_path(1000));
+  if (cache.Get("big", path))
+    throw runtime_error("Route larger than the cache was cached");
+
+  cache.Clear();
+  if (cache.size() != 0 || cache.bytes() != 0)
+    throw runtime_error("Cache was not cleared");
+}
+
+void TestTTL() {
+  RouteCache cache(10, 1024 * 1024, 0);
+  std::vector<PathInfo> path;
+  cache.Put("a", make_path(1));
+  if (cache.Get("a", path) || cache.size() != 0)
+    throw runtime_error("Expired route was returned");
+
+  // A cache with no entries is disabled
+  RouteCache disabled(0, 1024 * 1024, 300);
+  disabled.Put("a", make_path(1));
+  if (disabled.enabled() || disabled.Get("a", path))
+    throw runtime_error("Disabled cache cached a route");
+}
+
+void TestShared() {
+  // Worker threads share one cache: routes put by one thread are found by
+  // the others and the limits apply to the whole cache
+  RouteCache cache(16, 1024 * 1024, 300);
+  std::atomic<uint32_t> errors(0);
+  std::vector<std::thread> threads;
+  for (uint32_t t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, &errors, t]() {
+      std::vector<PathInfo> path;
+      for (uint32_t i = 0; i < 1000; i++) {
+        std::string key = std::to_string((i + t) % 32);
+        if (cache.Get(key, path) && path.size() != key.size())
+          errors++;
+        cache.Put(key, make_path(key.size()));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (errors > 0)
+    throw runtime_error("Wrong route from the shared cache");
+  if (cache.hits() + cache.misses() != 4000 || cache.hits() == 0)
+    throw runtime_error("Shared cache lookups were not counted");
+  if (cache.size() > 16)
+    throw runtime_error("Shared cache exceeded max entries");
+}
+
+}
+
+int main() {
+  test::suite suite("routecache");
+
+  // Cache and look up routes
+  suite.test(TEST_CASE(TestPutGet));
+
+  // Least recently used routes are evicted
+  suite.test(TEST_CASE(TestLRU));
+
+  // Cache stays within its memory limit
+  suite.test(TEST_CASE(TestMaxBytes));
+
+  // Routes expire
+  suite.test(TEST_CASE(TestTTL));
+
+  // One cache shared by several threads
+  suite.test(TEST_CASE(TestShared));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,202 @@
+#include "test.h"
+
+#include <cstdio>
+
+#include "thor/routinggraph.h"
+#include "testgraph.h"
+
+using namespace std;
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+using test::TestGraph;
+
+namespace {
+
+// Add a tile with the given nodes. Each node has an edge to each of the
+// nodes in ends (by graph index).
+void AddTile(TestGraph& graph, const uint32_t tileid,
+             const std::vector<PointLL>& lls,
+             const std::vector<std::vector<uint32_t>>& ends) {
+  graph.AddTile(tileid);
+  for (uint32_t i = 0; i < lls.size(); i++) {
+    for (auto end : ends[i]) {
+      graph.AddEdge(end);
+    }
+    graph.AddNode(lls[i]);
+  }
+}
+
+// Two tiles with nodes alternating between the west and the east of the
+// region, so curve orders differ from tile order
+void MakeGraph(TestGraph& graph) {
+  AddTile(graph, 10, { PointLL(-76.0f, 40.0f), PointLL(-70.0f, 40.0f),
+                       PointLL(-75.9f, 40.1f) },
+          { { 1, 2 }, { 3 }, { 0, RoutingGraph::kInvalidNode } });
+  AddTile(graph, 11, { PointLL(-70.1f, 40.1f), PointLL(-75.8f, 40.0f) },
+          { { 1 }, { 0, 2, 4 } });
+}
+
+// Check that GraphIds and indexes agree after reordering
+void CheckGraph(const RoutingGraph& graph, const RoutingGraph& original) {
+  if (graph.nodecount() != original.nodecount() ||
+      graph.edgecount() != original.edgecount())
+    throw runtime_error("Reorder changed the graph size");
+  for (uint32_t n = 0; n < original.nodecount(); n++) {
+    uint32_t node = graph.NodeIndex(original.nodeid(n));
+    if (graph.nodeid(node) != original.nodeid(n) ||
+        !(graph.latlng(node) == original.latlng(n)))
+      throw runtime_error("Node index does not match the node");
+
+    // Edges keep their order and end at the same nodes
+    uint32_t count = original.edge_index(n + 1) - original.edge_index(n);
+    if (graph.edge_index(node + 1) - graph.edge_index(node) != count)
+      throw runtime_error("Node has the wrong number of edges");
+    for (uint32_t i = 0; i < count; i++) {
+      uint32_t e = original.edge_index(n) + i;
+      uint32_t edge = graph.edge_index(node) + i;
+      if (graph.EdgeIndex(original.edgeid(e)) != edge ||
+          graph.edgeid(edge) != original.edgeid(e))
+        throw runtime_error("Edge index does not match the edge");
+      uint32_t end = original.edge(e).endnode;
+      if (end == RoutingGraph::kInvalidNode) {
+        if (graph.edge(edge).endnode != RoutingGraph::kInvalidNode)
+          throw runtime_error("Edge leaving the graph has an end node");
+      } else if (graph.nodeid(graph.edge(edge).endnode) != original.nodeid(end)) {
+        throw runtime_error("Edge ends at the wrong node");
+      }
+    }
+  }
+}
+
+void TestCurveKeys() {
+  // The Hilbert curve starts in the south west corner and ends in the south
+  // east corner
+  if (RoutingGraph::HilbertKey(PointLL(-180.0f, -90.0f)) != 0)
+    throw runtime_error("Hilbert curve does not start at the south west corner");
+  if (RoutingGraph::HilbertKey(PointLL(180.0f, -90.0f)) != 0xffffffff)
+    throw runtime_error("Hilbert curve does not end at the south east corner");
+  if (RoutingGraph::MortonKey(PointLL(-180.0f, -90.0f)) != 0 ||
+      RoutingGraph::MortonKey(PointLL(180.0f, 90.0f)) != 0xffffffff)
+    throw runtime_error("Morton curve does not span the world");
+
+  // Nearby points have close Hilbert keys
+  uint32_t a = RoutingGraph::HilbertKey(PointLL(-76.0f, 40.0f));
+  uint32_t b = RoutingGraph::HilbertKey(PointLL(-75.99f, 40.0f));
+  uint32_t c = RoutingGraph::HilbertKey(PointLL(-70.0f, 40.0f));
+  uint32_t near = (a > b) ? a - b : b - a;
+  uint32_t far = (a > c) ? a - c : c - a;
+  if (near >= far)
+    throw runtime_error("Hilbert keys of nearby points are not close");
+}
+
+void TestReorder() {
+  TestGraph original;
+  MakeGraph(original);
+  for (auto order : { NodeOrder::kHilbert, NodeOrder::kMorton }) {
+    TestGraph graph;
+    MakeGraph(graph);
+    graph.Reorder(order);
+    CheckGraph(graph, original);
+
+    // The western nodes are numbered together (before or after the
+    // eastern nodes)
+    bool west_first = graph.latlng(0).lng() < -73.0f;
+    for (uint32_t n = 0; n < graph.nodecount(); n++) {
+      bool west = graph.latlng(n).lng() < -73.0f;
+      if (west != (west_first ? n < 3 : n >= 2))
+        throw runtime_error("Nodes are not in curve order");
+    }
+
+    // Reordering again (and back to tile order) keeps the mapping
+    graph.Reorder(order == NodeOrder::kHilbert ?
+                    NodeOrder::kMorton : NodeOrder::kHilbert);
+    CheckGraph(graph, original);
+    graph.Reorder(NodeOrder::kTile);
+    CheckGraph(graph, original);
+    for (uint32_t n = 0; n < graph.nodecount(); n++) {
+      if (graph.nodeid(n) != original.nodeid(n))
+        throw runtime_error("Nodes are not back in tile order");
+    }
+  }
+}
+
+void TestSnapshot() {
+  const std::string file = "test/routinggraph.snapshot";
+  TestGraph original;
+  MakeGraph(original);
+  TestGraph graph;
+  MakeGraph(graph);
+  graph.Reorder(NodeOrder::kHilbert);
+  SnapshotWriter writer;
+  graph.Write(writer);
+  if (!writer.Write(file))
+    throw runtime_error("Could not write the snapshot");
+
+  // The loaded graph (in Hilbert order) maps to the original GraphIds and
+  // can be reordered
+  {
+    Snapshot snapshot;
+    RoutingGraph loaded;
+    if (!snapshot.Load(file) || !snapshot.Verify() || !loaded.Load(snapshot, true))
+      throw runtime_error("Could not load the snapshot");
+    CheckGraph(loaded, original);
+    for (uint32_t n = 0; n < graph.nodecount(); n++) {
+      if (loaded.nodeid(n) != graph.nodeid(n))
+        throw runtime_error("Loaded graph is not in Hilbert order");
+    }
+    loaded.Reorder(NodeOrder::kTile);
+    CheckGraph(loaded, original);
+  }
+
+  // A snapshot without a graph is not loaded
+  SnapshotWriter empty;
+  if (!empty.Write(file))
+    throw runtime_error("Could not write the empty snapshot");
+  Snapshot snapshot;
+  RoutingGraph loaded;
+  if (!snapshot.Load(file) || loaded.Load(snapshot) || loaded.nodecount() != 0)
+    throw runtime_error("Loaded a graph from an empty snapshot");
+  std::remove(file.c_str());
+}
+
+void TestVerifyEndNodes() {
+  // Edge to a node that is not in the graph
+  const std::string file = "test/routinggraph.snapshot";
+  TestGraph graph;
+  AddTile(graph, 10, { PointLL(-76.0f, 40.0f), PointLL(-75.9f, 40.0f) },
+          { { 1, RoutingGraph::kInvalidNode }, { 2 } });
+  SnapshotWriter writer;
+  graph.Write(writer);
+  if (!writer.Write(file))
+    throw runtime_error("Could not write the snapshot");
+
+  // The end nodes are only checked when verifying
+  Snapshot snapshot;
+  RoutingGraph loaded;
+  if (!snapshot.Load(file) || !loaded.Load(snapshot) || loaded.nodecount() != 2)
+    throw runtime_error("Could not load the snapshot");
+  if (loaded.Load(snapshot, true) || loaded.nodecount() != 0)
+    throw runtime_error("Loaded a graph with an edge to a missing node");
+  std::remove(file.c_str());
+}
+
+}
+
+int main() {
+  test::suite suite("routinggraph");
+
+  // Morton and Hilbert curve keys
+  suite.test(TEST_CASE(TestCurveKeys));
+
+  // Reorder nodes and keep the GraphId mapping
+  suite.test(TEST_CASE(TestReorder));
+
+  // Write to and load from a snapshot
+  suite.test(TEST_CASE(TestSnapshot));
+
+  // Verify end nodes when loading
+  suite.test(TEST_CASE(TestVerifyEndNodes));
+
+  return suite.tear_down();
+}
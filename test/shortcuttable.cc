@@ -0,0 +1,105 @@
+#include "test.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include "config.h"
+#include "thor/shortcuttable.h"
+
+using namespace std;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace {
+
+const std::string kTableFile = "test/shortcuts.bin";
+
+void TestWriteLoad() {
+  ShortcutTable::shortcut_map_t shortcuts;
+  shortcuts[GraphId(100, 0, 5)] = { { GraphId(2000, 2, 1), 0.25f },
+                                    { GraphId(2000, 2, 7), 0.5f },
+                                    { GraphId(2001, 2, 3), 1.0f } };
+  shortcuts[GraphId(50, 1, 1000)] = { { GraphId(4000, 2, 100000), 0.6f },
+                                      { GraphId(4000, 2, 99), 1.0f } };
+  if (!ShortcutTable::Write(kTableFile, shortcuts))
+    throw runtime_error("Failed to write shortcut table");
+
+  ShortcutTable table;
+  if (!table.Load(kTableFile))
+    throw runtime_error("Failed to load shortcut table");
+  if (table.size() != 2)
+    throw runtime_error("Shortcut table size is wrong");
+
+  for (const auto& shortcut : shortcuts) {
+    std::vector<std::pair<GraphId, float>> edges;
+    if (table.Expand(shortcut.first, edges) != shortcut.second.size())
+      throw runtime_error("Wrong number of edges for shortcut");
+    for (size_t i = 0; i < edges.size(); i++) {
+      if (edges[i].first != shortcut.second[i].first)
+        throw runtime_error("Wrong edge Id for shortcut");
+      if (fabs(edges[i].second - shortcut.second[i].second) > 0.0001f)
+        throw runtime_error("Wrong length fraction for shortcut");
+    }
+  }
+  remove(kTableFile.c_str());
+}
+
+void TestNotShortcut() {
+  ShortcutTable::shortcut_map_t shortcuts;
+  shortcuts[GraphId(100, 0, 5)] = { { GraphId(2000, 2, 1), 1.0f } };
+  ShortcutTable::Write(kTableFile, shortcuts);
+
+  ShortcutTable table;
+  table.Load(kTableFile);
+  std::vector<std::pair<GraphId, float>> edges;
+  if (table.Expand(GraphId(100, 0, 6), edges) != 0 || !edges.empty())
+    throw runtime_error("Expanded an edge that is not a shortcut");
+  if (table.Expand(GraphId(101, 0, 5), edges) != 0 || !edges.empty())
+    throw runtime_error("Expanded an edge that is not a shortcut");
+
+  // An empty table expands nothing
+  ShortcutTable empty;
+  if (empty.Expand(GraphId(100, 0, 5), edges) != 0)
+    throw runtime_error("Empty table expanded a shortcut");
+  remove(kTableFile.c_str());
+}
+
+void TestInvalidIndex() {
+  ShortcutTable::shortcut_map_t shortcuts;
+  shortcuts[GraphId(100, 0, 5)] = { { GraphId(2000, 2, 1), 1.0f },
+                                    { GraphId(2000, 2, 2), 1.0f } };
+  shortcuts[GraphId(100, 0, 6)] = { { GraphId(2000, 2, 3), 1.0f } };
+
+  // Overwrite the offset of the first index entry (after the 24 byte
+  // header and the entry's shortcut Id) so its edges run past the end
+  for (uint32_t offset : { 2u, 0xffffffffu }) {
+    ShortcutTable::Write(kTableFile, shortcuts);
+    {
+      std::fstream file(kTableFile, std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(24 + sizeof(uint64_t));
+      file.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    }
+    ShortcutTable table;
+    if (table.Load(kTableFile) || table.size() != 0)
+      throw runtime_error("Loaded a table with an entry past the edge list");
+  }
+  remove(kTableFile.c_str());
+}
+
+}
+
+int main() {
+  test::suite suite("shortcuttable");
+
+  // Write a table, map it and look up shortcuts
+  suite.test(TEST_CASE(TestWriteLoad));
+
+  // Edges not in the table are not expanded
+  suite.test(TEST_CASE(TestNotShortcut));
+
+  // Tables with index entries outside the edge list are not loaded
+  suite.test(TEST_CASE(TestInvalidIndex));
+
+  return suite.tear_down();
+}
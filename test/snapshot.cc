@@ -0,0 +1,174 @@
+#include "test.h"
+
+#include <cstdio>
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+#include "thor/snapshot.h"
+
+using namespace std;
+using namespace valhalla::thor;
+
+namespace {
+
+const std::string kSnapshotFile = "test/test.snapshot";
+const std::string kTileDir = "test/snapshot_tiles";
+
+constexpr uint32_t kNumbersTag = SnapshotTag("NUMS");
+constexpr uint32_t kTextTag = SnapshotTag("TEXT");
+
+void WriteSnapshot(const std::vector<uint32_t>& numbers, const std::string& text,
+                   const uint64_t tileset = 0) {
+  SnapshotWriter writer;
+  writer.SetTileSet(tileset);
+  writer.Add(kNumbersTag, numbers);
+  writer.Add(kTextTag, text.data(), text.size());
+  if (!writer.Write(kSnapshotFile))
+    throw runtime_error("Could not write the snapshot");
+}
+
+// Overwrite a byte of the snapshot file
+void Corrupt(const size_t offset, const char byte) {
+  std::fstream file(kSnapshotFile, std::ios::in | std::ios::out | std::ios::binary);
+  file.seekp(offset);
+  file.write(&byte, 1);
+}
+
+void TestWriteLoad() {
+  std::vector<uint32_t> numbers;
+  for (uint32_t i = 0; i < 1000; i++) {
+    numbers.push_back(i * 7);
+  }
+  WriteSnapshot(numbers, "abc");
+
+  Snapshot snapshot;
+  if (!snapshot.Load(kSnapshotFile) || snapshot.size() != 2 || !snapshot.Verify())
+    throw runtime_error("Could not load the snapshot");
+
+  // Sections are aligned and hold the data written
+  size_t size = 0;
+  const char* data = snapshot.Section(kNumbersTag, size);
+  if (data == nullptr || size != numbers.size() * sizeof(uint32_t) ||
+      reinterpret_cast<uintptr_t>(data) % 64 != 0)
+    throw runtime_error("Numbers section is wrong");
+  const uint32_t* loaded = reinterpret_cast<const uint32_t*>(data);
+  for (uint32_t i = 0; i < numbers.size(); i++) {
+    if (loaded[i] != numbers[i])
+      throw runtime_error("Numbers section has the wrong data");
+  }
+  data = snapshot.Section(kTextTag, size);
+  if (data == nullptr || std::string(data, size) != "abc")
+    throw runtime_error("Text section is wrong");
+  if (snapshot.Section(SnapshotTag("NONE"), size) != nullptr)
+    throw runtime_error("Found a section that was not written");
+  std::remove(kSnapshotFile.c_str());
+}
+
+void TestInvalid() {
+  std::vector<uint32_t> numbers(100, 5);
+
+  // Corrupt section data is found by Verify
+  WriteSnapshot(numbers, "abc");
+  Corrupt(200, 1);
+  Snapshot snapshot;
+  if (!snapshot.Load(kSnapshotFile) || snapshot.Verify())
+    throw runtime_error("Corrupt section data was not found");
+
+  // Corrupt magic, version and section table are not loaded
+  WriteSnapshot(numbers, "abc");
+  Corrupt(0, 'X');
+  if (snapshot.Load(kSnapshotFile))
+    throw runtime_error("Loaded a snapshot with a bad magic");
+  WriteSnapshot(numbers, "abc");
+  Corrupt(8, 99);
+  if (snapshot.Load(kSnapshotFile))
+    throw runtime_error("Loaded a snapshot with a different version");
+  WriteSnapshot(numbers, "abc");
+  Corrupt(40, 1);
+  if (snapshot.Load(kSnapshotFile) || snapshot.size() != 0)
+    throw runtime_error("Loaded a snapshot with a corrupt section table");
+
+  // A truncated snapshot is not loaded
+  WriteSnapshot(numbers, "abc");
+  {
+    std::ifstream in(kSnapshotFile, std::ios::in | std::ios::binary);
+    std::string contents((std::istreambuf_iterator<char>(in)),
+                         std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(kSnapshotFile, std::ios::out | std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), contents.size() - 1);
+  }
+  if (snapshot.Load(kSnapshotFile))
+    throw runtime_error("Loaded a truncated snapshot");
+  std::remove(kSnapshotFile.c_str());
+}
+
+// Write a tile file with the given contents
+void WriteTile(const std::string& file, const std::string& contents) {
+  boost::filesystem::path path(kTileDir + "/" + file);
+  boost::filesystem::create_directories(path.parent_path());
+  std::ofstream out(path.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+  out << contents;
+}
+
+void TestTileSet() {
+  boost::filesystem::remove_all(kTileDir);
+  if (Snapshot::TileSetId(kTileDir) != 0)
+    throw runtime_error("Missing tile directory has a tile set Id");
+  WriteTile("2/000/000/000.gph", "tile 0");
+  WriteTile("2/000/000/001.gph", "tile 1");
+  WriteTile("2/000/000/notes.txt", "not a tile");
+  uint64_t tileset = Snapshot::TileSetId(kTileDir);
+  if (tileset == 0 || Snapshot::TileSetId(kTileDir + "/") != tileset)
+    throw runtime_error("Wrong tile set Id");
+
+  // The snapshot loads with its own tile set (or without checking it)
+  std::vector<uint32_t> numbers(100, 5);
+  WriteSnapshot(numbers, "abc", tileset);
+  Snapshot snapshot;
+  if (!snapshot.Load(kSnapshotFile, tileset) || snapshot.tileset() != tileset ||
+      !snapshot.Load(kSnapshotFile))
+    throw runtime_error("Could not load the snapshot with its tile set");
+
+  // Files that are not tiles do not change the tile set
+  WriteTile("2/000/000/notes.txt", "still not a tile");
+  if (Snapshot::TileSetId(kTileDir) != tileset)
+    throw runtime_error("A file that is not a tile changed the tile set");
+
+  // Changed, added and removed tiles change the tile set
+  WriteTile("2/000/000/001.gph", "tile 1 changed");
+  if (Snapshot::TileSetId(kTileDir) == tileset ||
+      snapshot.Load(kSnapshotFile, Snapshot::TileSetId(kTileDir)))
+    throw runtime_error("Loaded a snapshot written from a changed tile");
+  uint64_t changed = Snapshot::TileSetId(kTileDir);
+  WriteTile("0/000/002.gph", "tile 2");
+  if (Snapshot::TileSetId(kTileDir) == changed)
+    throw runtime_error("Added tile did not change the tile set");
+  boost::filesystem::remove(kTileDir + "/0/000/002.gph");
+  if (Snapshot::TileSetId(kTileDir) != changed)
+    throw runtime_error("Removing the added tile did not restore the tile set");
+
+  // A snapshot without a tile set is not loaded when checking it
+  WriteSnapshot(numbers, "abc");
+  if (snapshot.Load(kSnapshotFile, tileset))
+    throw runtime_error("Loaded a snapshot without a tile set");
+  std::remove(kSnapshotFile.c_str());
+  boost::filesystem::remove_all(kTileDir);
+}
+
+}
+
+int main() {
+  test::suite suite("snapshot");
+
+  // Write and load sections
+  suite.test(TEST_CASE(TestWriteLoad));
+
+  // Corrupt and truncated snapshots
+  suite.test(TEST_CASE(TestInvalid));
+
+  // Snapshots are only loaded with the tile set they were written from
+  suite.test(TEST_CASE(TestTileSet));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,141 @@
+#ifndef TEST_TESTGRAPH_H_
+#define TEST_TESTGRAPH_H_
+
+#include <cstdint>
+#include <boost/property_tree/ptree.hpp>
+#include <valhalla/baldr/directededge.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/nodeinfo.h>
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/sif/edgelabel.h>
+
+#include "thor/routinggraph.h"
+
+namespace test {
+
+/**
+ * Routing graph with nodes and edges added directly rather than from tiles.
+ * Tiles are added in order, and the edges of a node are added before the
+ * node. GraphIds are the index of the node or edge within its tile.
+ */
+class TestGraph : public valhalla::thor::RoutingGraph {
+ public:
+  /**
+   * Start a tile. The nodes and edges added after it are in the tile.
+   * @param  tileid  Tile Id (on level 2).
+   */
+  void AddTile(const uint32_t tileid) {
+    tileid_ = tileid;
+    TileRange range;
+    range.tileid = valhalla::baldr::GraphId(tileid, 2, 0).value;
+    range.first_node = storage_.nodes.size();
+    range.node_count = 0;
+    range.first_edge = storage_.edges.size();
+    range.edge_count = 0;
+    storage_.tiles.push_back(range);
+    UseStorage();
+  }
+
+  /**
+   * Add an edge of the next node.
+   * @param  endnode       End node index (kInvalidNode for edges leaving
+   *                       the graph).
+   * @param  directededge  Directed edge attributes.
+   * @param  trans_up      Transition edge to another level.
+   */
+  void AddEdge(const uint32_t endnode,
+               const valhalla::baldr::DirectedEdge& directededge =
+                   valhalla::baldr::DirectedEdge(),
+               const bool trans_up = false) {
+    TileRange& range = storage_.tiles.back();
+    valhalla::thor::RoutingEdge edge{};
+    edge.endnode = endnode;
+    edge.trans_up = trans_up;
+    storage_.edges.push_back(edge);
+    storage_.directededges.push_back(directededge);
+    storage_.edge_ids.push_back(
+        valhalla::baldr::GraphId(tileid_, 2, range.edge_count++));
+  }
+
+  /**
+   * Add a node with the edges added since the previous node.
+   * @param  ll  Node location.
+   */
+  void AddNode(const valhalla::midgard::PointLL& ll) {
+    TileRange& range = storage_.tiles.back();
+    storage_.node_edges.push_back(storage_.edges.size());
+    storage_.node_lls.push_back(ll);
+    storage_.nodes.emplace_back();
+    storage_.node_ids.push_back(
+        valhalla::baldr::GraphId(tileid_, 2, range.node_count++));
+    UseStorage();
+  }
+
+  /**
+   * Get the start node of an edge.
+   * @param  edge  Edge index.
+   * @return  Returns the index of the node the edge leaves.
+   */
+  uint32_t startnode(const uint32_t edge) const {
+    uint32_t node = 0;
+    while (edge_index(node + 1) <= edge) {
+      node++;
+    }
+    return node;
+  }
+
+ private:
+  // Tile the nodes and edges are added to
+  uint32_t tileid_;
+};
+
+/**
+ * Costing that counts the edge and transition costs computed. The cost of
+ * an edge is the factor it was created with (and its time twice that). The
+ * cost of a transition is 10 * the predecessor's opp_local_idx + the edge's
+ * local index, plus the offset it was created with.
+ */
+class CountingCost : public valhalla::sif::DynamicCost {
+ public:
+  CountingCost(const float factor, const float offset = 0.0f)
+      : DynamicCost(boost::property_tree::ptree(),
+                    valhalla::sif::TravelMode::kDrive),
+        factor(factor), offset(offset), edge_calls(0), transition_calls(0) {
+  }
+  virtual bool Allowed(const valhalla::baldr::DirectedEdge* edge,
+                       const valhalla::sif::EdgeLabel& pred) const {
+    return true;
+  }
+  virtual bool Allowed(const valhalla::baldr::NodeInfo* node) const {
+    return true;
+  }
+  virtual valhalla::sif::Cost EdgeCost(const valhalla::baldr::DirectedEdge* edge,
+                                       const uint32_t density) const {
+    edge_calls++;
+    return valhalla::sif::Cost(factor, factor * 2.0f);
+  }
+  virtual valhalla::sif::Cost TransitionCost(
+      const valhalla::baldr::DirectedEdge* edge,
+      const valhalla::baldr::NodeInfo* node,
+      const valhalla::sif::EdgeLabel& pred) const {
+    transition_calls++;
+    float c = offset + 10.0f * pred.opp_local_idx() + edge->localedgeidx();
+    return valhalla::sif::Cost(c, c);
+  }
+  virtual float AStarCostFactor() const {
+    return 0.0f;
+  }
+  virtual const valhalla::sif::EdgeFilter GetFilter() const {
+    return [](const valhalla::baldr::DirectedEdge* edge) { return 0.0f; };
+  }
+
+  float factor;
+  float offset;
+  mutable uint32_t edge_calls;
+  mutable uint32_t transition_calls;
+};
+
+}
+
+#endif  // TEST_TESTGRAPH_H_
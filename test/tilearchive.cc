@@ -0,0 +1,96 @@
+#include "test.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <boost/filesystem.hpp>
+
+#include "thor/tilearchive.h"
+
+using namespace std;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace {
+
+// Directory for the files written by the tests (removed after each test)
+const std::string kTestDir = "test/tilearchive_files";
+const std::string kArchiveFile = kTestDir + "/tiles.bin";
+
+// Write a fake tile file filled with a byte value
+std::string write_tile(const std::string& name, const size_t size,
+                       const char value) {
+  boost::filesystem::create_directories(kTestDir);
+  std::string filename = kTestDir + "/" + name + ".gph";
+  std::ofstream file(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+  std::string data(size, value);
+  file.write(data.data(), data.size());
+  return filename;
+}
+
+void TestWriteFind() {
+  // Tiles are not in tile Id order and have sizes that need padding
+  std::vector<std::pair<GraphId, std::string>> tiles;
+  tiles.emplace_back(GraphId(752, 2, 0), write_tile("tile_c", 13, 'c'));
+  tiles.emplace_back(GraphId(3, 0, 0), write_tile("tile_a", 100, 'a'));
+  tiles.emplace_back(GraphId(15, 1, 0), write_tile("tile_b", 1, 'b'));
+  if (!TileArchive::Write(kArchiveFile, tiles))
+    throw runtime_error("Tile archive was not written");
+
+  TileArchive archive;
+  if (!archive.Load(kArchiveFile) || archive.size() != 3)
+    throw runtime_error("Tile archive was not loaded");
+
+  // Any GraphId within a tile finds the tile data (8 byte aligned)
+  size_t size = 0;
+  const char* data = archive.Find(GraphId(752, 2, 1234), size);
+  if (data == nullptr || size != 13 || data[0] != 'c' || data[12] != 'c' ||
+      reinterpret_cast<uintptr_t>(data) % 8 != 0)
+    throw runtime_error("Tile c was not found");
+  data = archive.Find(GraphId(3, 0, 0), size);
+  if (data == nullptr || size != 100 || data[99] != 'a' ||
+      reinterpret_cast<uintptr_t>(data) % 8 != 0)
+    throw runtime_error("Tile a was not found");
+  data = archive.Find(GraphId(15, 1, 5), size);
+  if (data == nullptr || size != 1 || data[0] != 'b')
+    throw runtime_error("Tile b was not found");
+
+  // Tiles not in the archive
+  if (archive.Find(GraphId(15, 2, 0), size) != nullptr ||
+      archive.Find(GraphId(4, 0, 0), size) != nullptr)
+    throw runtime_error("Found a tile that is not in the archive");
+  boost::filesystem::remove_all(kTestDir);
+}
+
+void TestInvalid() {
+  // Missing files are not written or loaded
+  std::vector<std::pair<GraphId, std::string>> tiles;
+  tiles.emplace_back(GraphId(1, 0, 0), kTestDir + "/no_such_tile.gph");
+  if (TileArchive::Write(kTestDir + "/invalid_tiles.bin", tiles))
+    throw runtime_error("Wrote an archive with a missing tile");
+  TileArchive archive;
+  if (archive.Load(kTestDir + "/no_such_archive.bin") || archive.size() != 0)
+    throw runtime_error("Loaded a missing archive");
+
+  // Files that are not tile archives are not loaded
+  std::string filename = write_tile("not_an_archive", 64, 'x');
+  size_t size = 0;
+  if (archive.Load(filename) || archive.Find(GraphId(1, 0, 0), size) != nullptr)
+    throw runtime_error("Loaded an invalid archive");
+  boost::filesystem::remove_all(kTestDir);
+}
+
+}
+
+int main() {
+  test::suite suite("tilearchive");
+
+  // Pack tiles into an archive, map it and find tiles
+  suite.test(TEST_CASE(TestWriteFind));
+
+  // Missing and invalid files
+  suite.test(TEST_CASE(TestInvalid));
+
+  return suite.tear_down();
+}
@@ -0,0 +1,182 @@
+#include "test.h"
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "thor/memorytile.h"
+#include "thor/searchtilecache.h"
+#include "thor/tilemanifest.h"
+
+using namespace std;
+using namespace valhalla::baldr;
+using namespace valhalla::thor;
+
+namespace {
+
+const std::string kManifestFile = "test/tiles.manifest";
+
+// Tile cache that records the tiles preloaded
+class PreloadCache : public TileCache {
+ public:
+  virtual const GraphTile* Get(const GraphId& id) {
+    return nullptr;
+  }
+
+  virtual void Preload(const std::vector<GraphId>& tileids) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& tileid : tileids) {
+      if (!preloaded.insert(tileid.value).second)
+        throw runtime_error("Tile was preloaded twice");
+    }
+  }
+
+  std::unordered_set<uint64_t> preloaded;
+
+ protected:
+  std::mutex mutex_;
+};
+
+// Tile cache of empty tiles. Tile i is 1000 * (i + 1) bytes.
+class SizedCache : public TileCache {
+ public:
+  virtual const GraphTile* Get(const GraphId& id) {
+    gets[id.Tile_Base().value]++;
+    auto& tile = tiles_[id.Tile_Base().value];
+    if (!tile) {
+      size_t size = 1000 * (id.tileid() + 1);
+      std::shared_ptr<char> data(new char[size](), [](char* p) { delete [] p; });
+      tile.reset(new MemoryTile(data, size));
+    }
+    return tile.get();
+  }
+
+  virtual void Preload(const std::vector<GraphId>& tileids) {
+  }
+
+  std::unordered_map<uint64_t, uint32_t> gets;
+
+ protected:
+  std::unordered_map<uint64_t, std::unique_ptr<MemoryTile>> tiles_;
+};
+
+void TestTop() {
+  TileManifest manifest;
+  for (uint32_t i = 0; i < 10; i++) {
+    // Tile i is used i + 1 times (using different GraphIds in the tile)
+    for (uint32_t n = 0; n <= i; n++) {
+      manifest.Record(GraphId(100 + i, 2, n), 1000 * (i + 1));
+    }
+  }
+  if (manifest.size() != 10)
+    throw runtime_error("Wrong number of tiles recorded");
+
+  // Most used first, limited by count
+  auto top = manifest.Top(3, 1000000);
+  if (top.size() != 3 || top[0].tileid != GraphId(109, 2, 0) ||
+      top[0].count != 10 || top[0].size != 10000 ||
+      top[2].tileid != GraphId(107, 2, 0))
+    throw runtime_error("Wrong top tiles");
+
+  // Limited by size - tiles that do not fit are skipped
+  top = manifest.Top(10, 20000);
+  if (top.size() != 3 || top[0].tileid != GraphId(109, 2, 0) ||
+      top[1].tileid != GraphId(108, 2, 0) || top[2].tileid != GraphId(100, 2, 0))
+    throw runtime_error("Wrong top tiles within the size budget");
+}
+
+void TestWriteLoad() {
+  TileManifest manifest;
+  manifest.Record(GraphId(5, 0, 0), 500);
+  for (uint32_t n = 0; n < 6; n++) {
+    manifest.Record(GraphId(77, 1, n), 700);
+  }
+  if (!manifest.Write(kManifestFile))
+    throw runtime_error("Manifest was not written");
+
+  // Loaded counts are halved and added to recorded counts
+  TileManifest loaded;
+  loaded.Record(GraphId(5, 0, 3), 500);
+  if (!loaded.Load(kManifestFile) || loaded.size() != 2)
+    throw runtime_error("Manifest was not loaded");
+  auto top = loaded.Top(10, 1000000);
+  if (top[0].tileid != GraphId(77, 1, 0) || top[0].count != 3 ||
+      top[0].size != 700 || top[1].tileid != GraphId(5, 0, 0) ||
+      top[1].count != 2)
+    throw runtime_error("Loaded manifest is wrong");
+
+  if (loaded.Load("test/no_such.manifest"))
+    throw runtime_error("Loaded a missing manifest");
+  std::remove(kManifestFile.c_str());
+}
+
+void TestWarmup() {
+  TileManifest manifest;
+  for (uint32_t i = 0; i < 1000; i++) {
+    manifest.Record(GraphId(i, 2, 0), 100);
+  }
+  PreloadCache cache;
+  TileManifest::Warmup(cache, manifest.Top(500, 1000000), 4);
+  if (cache.preloaded.size() != 500)
+    throw runtime_error("Wrong number of tiles preloaded");
+}
+
+void TestSearchUse() {
+  std::stringstream json;
+  json << "{\"tile_dir\": \"test/tiles\", \"levels\": ["
+          "{\"name\": \"local\", \"level\": 2, \"size\": 0.25}]}";
+  boost::property_tree::ptree config;
+  boost::property_tree::read_json(json, config);
+  GraphReader reader(config);
+
+  // Six tiles used in turn - more than the search cache holds, so every use
+  // is resolved by the shared cache
+  TileManifest manifest;
+  SizedCache cache;
+  SearchTileCache search;
+  search.SetManifest(&manifest);
+  search.Init(reader, &cache);
+  for (uint32_t n = 0; n < 3; n++) {
+    for (uint32_t i = 0; i < 6; i++) {
+      search.Get(GraphId(i, 2, n));
+    }
+  }
+  if (manifest.size() != 0)
+    throw runtime_error("Tile use was recorded during the search");
+
+  // The use is recorded once the search is done, and only once
+  search.Clear();
+  search.Clear();
+  auto top = manifest.Top(10, 1000000);
+  if (top.size() != 6)
+    throw runtime_error("Wrong number of tiles recorded");
+  for (const auto& entry : top) {
+    if (entry.count != 3 || entry.count != cache.gets[entry.tileid.value] ||
+        entry.size != 1000 * (entry.tileid.tileid() + 1))
+      throw runtime_error("Wrong tile use recorded");
+  }
+}
+
+}
+
+int main() {
+  test::suite suite("tilemanifest");
+
+  // Most used tiles within a budget
+  suite.test(TEST_CASE(TestTop));
+
+  // Write and load manifests
+  suite.test(TEST_CASE(TestWriteLoad));
+
+  // Preload tiles on several threads
+  suite.test(TEST_CASE(TestWarmup));
+
+  // Tile use of a search is recorded after the search
+  suite.test(TEST_CASE(TestSearchUse));
+
+  return suite.tear_down();
+}
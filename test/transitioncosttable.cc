@@ -0,0 +1,114 @@
+#include "test.h"
+
+#include <array>
+#include <valhalla/sif/edgelabel.h>
+
+#include "thor/transitioncosttable.h"
+#include "testgraph.h"
+
+using namespace std;
+using namespace valhalla::midgard;
+using namespace valhalla::baldr;
+using namespace valhalla::sif;
+using namespace valhalla::thor;
+using test::CountingCost;
+using test::TestGraph;
+
+namespace {
+
+// Add a node with its edges: end node, local edge index, index of the
+// opposing edge at the end node and its local edge index
+void AddNode(TestGraph& graph,
+             const std::vector<std::array<uint32_t, 4>>& edges) {
+  for (const auto& e : edges) {
+    DirectedEdge directededge;
+    directededge.set_localedgeidx(e[1]);
+    directededge.set_opp_index(e[2]);
+    directededge.set_opp_local_idx(e[3]);
+    graph.AddEdge(e[0], directededge);
+  }
+  graph.AddNode(PointLL(-76.0f, 40.0f));
+}
+
+// Routing graph of one tile: nodes A - B - C with an edge each way between
+// them. Edges in graph order: A->B, B->A, B->C, C->B.
+void MakeGraph(TestGraph& graph) {
+  graph.AddTile(10);
+  AddNode(graph, { { 1, 0, 0, 0 } });
+  AddNode(graph, { { 0, 0, 0, 0 }, { 2, 1, 0, 0 } });
+  AddNode(graph, { { 1, 0, 1, 1 } });
+}
+
+void TestRows() {
+  TestGraph graph;
+  MakeGraph(graph);
+  std::shared_ptr<CountingCost> cost(new CountingCost(1.0f, 0.0f));
+  std::shared_ptr<DynamicCost> costing(cost);
+  TransitionCostTable table;
+  table.Customize(graph, costing, 1, true);
+  if (table.size() != 6 || table.fingerprint() != 1 || cost->transition_calls != 6 ||
+      table.computed() != 3)
+    throw runtime_error("Eager customization did not compute all matrices");
+
+  // Rows at B: from A (local index 0) and from C (local index 1)
+  const Cost* row = table.Row(1, 0, 0, graph, *cost);
+  if (row == nullptr || row[0].cost != 0.0f || row[1].cost != 1.0f)
+    throw runtime_error("Wrong transition costs from A");
+  row = table.Row(1, 3, 1, graph, *cost);
+  if (row == nullptr || row[0].cost != 10.0f || row[1].cost != 11.0f)
+    throw runtime_error("Wrong transition costs from C");
+  if (cost->transition_calls != 6)
+    throw runtime_error("Transition costs were recomputed");
+
+  // No rows for other predecessors or local indices
+  if (table.Row(1, 3, 0, graph, *cost) != nullptr ||
+      table.Row(1, 0, 2, graph, *cost) != nullptr)
+    throw runtime_error("Found a row for the wrong predecessor");
+}
+
+void TestIncremental() {
+  TestGraph graph;
+  MakeGraph(graph);
+  std::shared_ptr<CountingCost> cost1(new CountingCost(1.0f, 0.0f));
+  std::shared_ptr<CountingCost> cost2(new CountingCost(1.0f, 100.0f));
+  std::shared_ptr<DynamicCost> costing1(cost1), costing2(cost2);
+  TransitionCostTable table;
+  table.Customize(graph, costing1, 1, false);
+  if (cost1->transition_calls != 0 || table.size() != 0)
+    throw runtime_error("Lazy customization computed transition costs");
+
+  // Reading a row computes the node's matrix once
+  table.Row(1, 0, 0, graph, *cost1);
+  table.Row(1, 3, 1, graph, *cost1);
+  if (cost1->transition_calls != 4 || table.computed() != 1)
+    throw runtime_error("Matrix was not computed once when read");
+  if (table.size() != 4)
+    throw runtime_error("Storage was not allocated for the computed matrix only");
+  table.Customize(graph, costing1, 1, false);
+  table.Row(1, 0, 0, graph, *cost1);
+  if (cost1->transition_calls != 4)
+    throw runtime_error("Matrix was recomputed for the same fingerprint");
+
+  // New costing options: matrices are recomputed when read
+  table.Customize(graph, costing2, 2, false);
+  const Cost* row = table.Row(1, 3, 1, graph, *cost2);
+  if (row == nullptr || row[1].cost != 111.0f || cost2->transition_calls != 4 ||
+      table.computed() != 1)
+    throw runtime_error("Matrix was not recomputed for new options");
+  if (table.size() != 4)
+    throw runtime_error("Recomputed matrix was allocated again");
+}
+
+}
+
+int main() {
+  test::suite suite("transitioncosttable");
+
+  // Rows of transition costs per incoming edge
+  suite.test(TEST_CASE(TestRows));
+
+  // Recompute matrices when read after the options change
+  suite.test(TEST_CASE(TestIncremental));
+
+  return suite.tear_down();
+}
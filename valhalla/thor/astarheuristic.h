@@ -1,6 +1,7 @@
 #ifndef VALHALLA_THOR_ASTARHEURISTIC_H_
 #define VALHALLA_THOR_ASTARHEURISTIC_H_
 
+#include <cstdint>
 #include <valhalla/midgard/distanceapproximator.h>
 #include <valhalla/midgard/pointll.h>
 #include <valhalla/midgard/util.h>
@@ -59,10 +60,31 @@ class AStarHeuristic {
    */
   float Get(const midgard::PointLL& ll) const;
 
+  /**
+   * Get the distances to the destination and the A* heuristics for a batch
+   * of lat,lngs (e.g. the end nodes of all edges leaving a node). Evaluates
+   * 4 lat,lngs at a time with SSE when available. Results are identical to
+   * calling GetDistance and Get(distance) for each lat,lng.
+   * @param  lls         Array of lat,lngs.
+   * @param  n           Number of lat,lngs.
+   * @param  distances   Output: distance (meters) to the destination for
+   *                     each lat,lng. Must hold n values.
+   * @param  heuristics  Output: estimated cost to the destination for each
+   *                     lat,lng. Must hold n values.
+   */
+  void Get(const midgard::PointLL* lls, const uint32_t n, float* distances,
+           float* heuristics) const;
+
  private:
   midgard::DistanceApproximator distapprox_;  // Distance approximation
   float costfactor_;    // Cost factor - ensures the cost estimate
                         // underestimates the true cost.
+
+  // Destination and meters per degree of longitude at the destination. Used
+  // by the batch method (same approximation as the distance approximator).
+  float destlat_;
+  float destlng_;
+  float mperlngdeg_;
 };
 
 }
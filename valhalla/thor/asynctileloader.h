@@ -0,0 +1,154 @@
+#ifndef VALHALLA_THOR_ASYNCTILELOADER_H_
+#define VALHALLA_THOR_ASYNCTILELOADER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/baldr/tilehierarchy.h>
+#include <valhalla/thor/tileloader.h>
+
+struct io_uring;
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Loads batches of tile files with the reads in flight concurrently, so a
+ * batch of cold tiles costs about one storage round trip rather than one
+ * per tile. This matters most on network attached or spinning storage.
+ * Reads are submitted through io_uring when thor is built with liburing
+ * and the kernel supports it, otherwise they are spread over a pool of
+ * reader threads. Batches come from tile cache preloads (the prefetcher
+ * and startup warm-up).
+ */
+class AsyncTileLoader : public TileLoader {
+ public:
+  /**
+   * Constructor. Starts the reader threads.
+   * @param  hierarchy     Tile hierarchy (tile directory and levels).
+   * @param  threads       Number of reader threads (used when io_uring is
+   *                       not available). 0 reads on the calling thread.
+   * @param  queue_depth   Maximum number of reads in flight per batch with
+   *                       io_uring.
+   * @param  use_io_uring  Use io_uring if it is available.
+   */
+  AsyncTileLoader(const baldr::TileHierarchy& hierarchy,
+                  const uint32_t threads = 8,
+                  const uint32_t queue_depth = 64,
+                  const bool use_io_uring = true);
+
+  /**
+   * Destructor. Stops the reader threads.
+   */
+  virtual ~AsyncTileLoader();
+
+  /**
+   * Load a tile.
+   * @param  tileid  Tile base GraphId.
+   * @return  Returns the tile (owned by the caller) or nullptr if the tile
+   *          does not exist.
+   */
+  virtual baldr::GraphTile* Load(const baldr::GraphId& tileid);
+
+  /**
+   * Load a batch of tiles with the reads in flight concurrently.
+   * @param  tileids  Tile base GraphIds.
+   * @param  tiles    Returns the tiles in the same order (owned by the
+   *                  caller, nullptr for tiles that do not exist).
+   */
+  virtual void LoadBatch(const std::vector<baldr::GraphId>& tileids,
+                         std::vector<baldr::GraphTile*>& tiles);
+
+  /**
+   * Returns true if reads are submitted through io_uring.
+   * @return  Returns true if io_uring is used.
+   */
+  bool uses_io_uring() const;
+
+ protected:
+  // A tile file read within a batch
+  struct TileRead {
+    enum class Status { kPending, kDone, kMissing };
+
+    std::string file;
+    std::shared_ptr<char> data;
+    size_t size;
+    Status status;
+
+    TileRead()
+        : size(0),
+          status(Status::kPending) {
+    }
+  };
+
+  /**
+   * Read a whole tile file (blocking). Called on the reader threads.
+   * @param  file  Tile file.
+   * @param  data  Returns the file contents.
+   * @param  size  Returns the file size.
+   * @return  Returns false if the file does not exist or could not be read.
+   */
+  virtual bool ReadFile(const std::string& file, std::shared_ptr<char>& data,
+                        size_t& size);
+
+  /**
+   * Read the pending reads of a batch on the reader threads and wait for
+   * them to complete.
+   * @param  reads  Tile reads of the batch.
+   */
+  void ReadThreads(std::vector<TileRead>& reads);
+
+  /**
+   * Read the pending reads of a batch through io_uring. Reads that could
+   * not be completed are left pending.
+   * @param  reads  Tile reads of the batch.
+   */
+  void ReadIoUring(std::vector<TileRead>& reads);
+
+  /**
+   * Get a ring for a batch (rings are not shared by concurrent batches).
+   * @return  Returns a ring or nullptr if io_uring is not available.
+   */
+  io_uring* AcquireRing();
+
+  /**
+   * Return a ring after a batch.
+   * @param  ring  Ring.
+   */
+  void ReleaseRing(io_uring* ring);
+
+  /**
+   * Reader thread - reads files from the queue until stopped.
+   */
+  void Run();
+
+  baldr::TileHierarchy hierarchy_;
+  uint32_t queue_depth_;
+  bool use_io_uring_;
+
+  // Rings not in use by a batch
+  std::mutex rings_mutex_;
+  std::vector<io_uring*> rings_;
+
+  // Reader thread queue. Each read carries the count of outstanding reads
+  // of its batch.
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::condition_variable finished_;
+  std::deque<std::pair<TileRead*, uint32_t*>> queue_;
+  bool done_;
+  std::vector<std::thread> threads_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_ASYNCTILELOADER_H_
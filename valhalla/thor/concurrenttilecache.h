@@ -0,0 +1,210 @@
+#ifndef VALHALLA_THOR_CONCURRENTTILECACHE_H_
+#define VALHALLA_THOR_CONCURRENTTILECACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/baldr/tilehierarchy.h>
+#include <valhalla/thor/tilecache.h>
+#include <valhalla/thor/tileloader.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Thread safe tile cache with a lock-free lookup path. Each hierarchy level
+ * has an array of atomic tile pointers indexed directly by tile Id, so a
+ * lookup of a cached tile is a single atomic load. Tiles are immutable once
+ * published. Loading a tile takes one of a set of striped locks so each
+ * tile is loaded once. Evicted tiles are reclaimed using epochs: a tile is
+ * freed only after every reader that was inside a read section when it was
+ * evicted has ended that section.
+ *
+ * The cache can be limited in size. When the cached tiles exceed the limit
+ * tiles are evicted using the CLOCK algorithm (lookups set a referenced
+ * flag, and a referenced tile gets a second chance before it is evicted).
+ * Tiles on the highway level are pinned (never evicted) since nearly every
+ * long route uses them.
+ */
+class ConcurrentTileCache : public TileCache {
+ public:
+  /**
+   * Constructor.
+   * @param  hierarchy  Tile hierarchy (tile directory and levels).
+   * @param  max_bytes  Maximum size of the cached tiles (pinned tiles
+   *                    count towards it but are not evicted). 0 is
+   *                    unlimited.
+   * @param  loader     Loader used to read tiles (not owned). If nullptr
+   *                    tiles are read from the tile files.
+   * @param  max_readers  Maximum number of registered readers (e.g. one
+   *                      per search thread).
+   */
+  ConcurrentTileCache(const baldr::TileHierarchy& hierarchy,
+                      const size_t max_bytes = 0,
+                      TileLoader* loader = nullptr,
+                      const uint32_t max_readers = kDefaultMaxReaders);
+
+  /**
+   * Destructor. Frees all tiles (there must be no active readers).
+   */
+  virtual ~ConcurrentTileCache();
+
+  /**
+   * Get the graph tile containing the given GraphId, loading it if needed.
+   * @param  id  GraphId of a node or directed edge (or a tile base).
+   * @return  Returns the graph tile or nullptr if it could not be found.
+   */
+  virtual const baldr::GraphTile* Get(const baldr::GraphId& id);
+
+  /**
+   * Load tiles that are not cached using the loader's batch load.
+   * @param  tileids  Tile base GraphIds.
+   */
+  virtual void Preload(const std::vector<baldr::GraphId>& tileids);
+
+  /**
+   * Register a reader. Reuses a released reader Id if there is one. Throws
+   * if max_readers readers are registered.
+   * @return  Returns the reader Id.
+   */
+  virtual uint32_t RegisterReader();
+
+  /**
+   * Release a reader Id for reuse.
+   * @param  reader  Reader Id.
+   */
+  virtual void ReleaseReader(const uint32_t reader);
+
+  /**
+   * Begin a read section.
+   * @param  reader  Reader Id.
+   */
+  virtual void BeginRead(const uint32_t reader);
+
+  /**
+   * End a read section.
+   * @param  reader  Reader Id.
+   */
+  virtual void EndRead(const uint32_t reader);
+
+  /**
+   * Get statistics about the cache.
+   * @return  Returns the cache statistics.
+   */
+  virtual TileCacheStats stats() const;
+
+  /**
+   * Evict a tile. The tile is freed once no reader can be using it.
+   * @param  id  GraphId within the tile.
+   * @return  Returns true if the tile was cached.
+   */
+  bool Evict(const baldr::GraphId& id);
+
+  /**
+   * Free evicted tiles that no reader can be using.
+   */
+  void Reclaim();
+
+  /**
+   * Get the total size (bytes) of the cached tiles (not including evicted
+   * tiles waiting to be freed).
+   * @return  Returns the size of the cached tiles.
+   */
+  size_t size() const;
+
+ protected:
+  // Default maximum number of readers and number of load locks
+  static constexpr uint32_t kDefaultMaxReaders = 64;
+  static constexpr uint32_t kLoadLocks = 64;
+
+  // Number of hit counters (threads add to different counters so lookups
+  // do not contend on one cache line)
+  static constexpr uint32_t kHitCounters = 16;
+
+  // Reader epoch when not in a read section
+  static constexpr uint64_t kInactive = ~0ull;
+
+  /**
+   * Add a newly loaded tile to the tiles that can be evicted and evict
+   * tiles if the cache is over its size limit.
+   * @param  id  Tile base GraphId.
+   */
+  void Loaded(const baldr::GraphId& id);
+
+  /**
+   * Evict tiles using the CLOCK algorithm until the cache is below its low
+   * water mark. Requires clock_mutex_ to be held.
+   */
+  void EvictToFit();
+
+  /**
+   * Retire an evicted tile and free any retired tiles no longer in use.
+   * @param  tile  Evicted tile.
+   */
+  void Retire(const baldr::GraphTile* tile);
+
+  /**
+   * Free retired tiles no reader can be using. Requires retired_mutex_ to
+   * be held.
+   */
+  void FreeRetired();
+
+  baldr::TileHierarchy hierarchy_;
+
+  // Tile loader (file_loader_ is used if no loader is given)
+  std::unique_ptr<TileLoader> file_loader_;
+  TileLoader* loader_;
+
+  // Tile slots per level (indexed by tile Id), referenced flags per slot and
+  // the number of tiles per level. Tiles that do not exist point to missing_.
+  std::unique_ptr<std::atomic<const baldr::GraphTile*>[]> slots_[8];
+  std::unique_ptr<std::atomic<bool>[]> referenced_[8];
+  uint32_t tilecounts_[8];
+  const baldr::GraphTile missing_;
+
+  // Locks serializing loads (a tile always uses the same lock)
+  std::mutex load_mutexes_[kLoadLocks];
+
+  // Size limit, pinned level, tiles that can be evicted and the clock hand
+  size_t max_bytes_;
+  uint32_t pinned_level_;
+  std::mutex clock_mutex_;
+  std::vector<baldr::GraphId> evictable_;
+  size_t hand_;
+
+  // Global epoch, epoch announced by each reader (kInactive if not reading)
+  // and read section depth of each reader (only used by its thread). The
+  // reader table has max_readers_ entries of which the first readers_ have
+  // been handed out. Released reader Ids are kept for reuse.
+  std::atomic<uint64_t> epoch_;
+  uint32_t max_readers_;
+  std::unique_ptr<std::atomic<uint64_t>[]> reader_epochs_;
+  std::unique_ptr<uint32_t[]> reader_depths_;
+  std::atomic<uint32_t> readers_;
+  std::mutex reader_mutex_;
+  std::vector<uint32_t> free_readers_;
+
+  // Evicted tiles with the epoch they were evicted in
+  std::mutex retired_mutex_;
+  std::vector<std::pair<const baldr::GraphTile*, uint64_t>> retired_;
+
+  // Statistics. Hit counters are padded to a cache line each.
+  struct HitCounter {
+    std::atomic<uint64_t> count;
+    char padding[64 - sizeof(std::atomic<uint64_t>)];
+  };
+  HitCounter hits_[kHitCounters];
+  std::atomic<uint64_t> misses_;
+  std::atomic<uint64_t> evictions_;
+  std::atomic<size_t> size_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_CONCURRENTTILECACHE_H_
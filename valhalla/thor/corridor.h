@@ -0,0 +1,59 @@
+#ifndef VALHALLA_THOR_CORRIDOR_H_
+#define VALHALLA_THOR_CORRIDOR_H_
+
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/tilehierarchy.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Graph tiles (at each hierarchy level) within a distance of a route. Used
+ * to restrict a search to the area around a coarse route found first (see
+ * PathAlgorithm::GetBestPathCorridor).
+ */
+class Corridor {
+ public:
+  /**
+   * Constructor (empty corridor).
+   */
+  Corridor();
+
+  /**
+   * Form the corridor around a route.
+   * @param  hierarchy  Tile hierarchy (tiling per level).
+   * @param  shape      Lat,lngs along the route (e.g. its nodes).
+   * @param  radius     Distance (meters) from the route to include.
+   */
+  void Build(const baldr::TileHierarchy& hierarchy,
+             const std::vector<midgard::PointLL>& shape, const float radius);
+
+  /**
+   * Check if a node or edge is in the corridor.
+   * @param  id  Node or edge Id.
+   * @return  Returns true if the tile of the Id is in the corridor.
+   */
+  bool Contains(const baldr::GraphId& id) const {
+    return tiles_.find(id.Tile_Base().value) != tiles_.end();
+  }
+
+  /**
+   * Get the number of tiles in the corridor.
+   * @return  Returns the number of tiles (over all levels).
+   */
+  uint32_t size() const;
+
+ protected:
+  // Base Ids of the tiles in the corridor
+  std::unordered_set<uint64_t> tiles_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_CORRIDOR_H_
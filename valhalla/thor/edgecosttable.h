@@ -0,0 +1,105 @@
+#ifndef VALHALLA_THOR_EDGECOSTTABLE_H_
+#define VALHALLA_THOR_EDGECOSTTABLE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <valhalla/baldr/directededge.h>
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/thor/routinggraph.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Edge costs of a routing graph for one costing (the customization of the
+ * graph for the costing options). Searches on the routing graph read the
+ * cost of an edge from the table instead of calling the costing. Costs are
+ * those of DynamicCost::EdgeCost with the density of the edge's start node,
+ * so paths are the same as without the table.
+ *
+ * The table is keyed by a fingerprint of the costing options. When the
+ * options change the costs are recomputed incrementally: entries carry the
+ * generation they were computed in and stale entries are recomputed when a
+ * search first reads them, so a new costing only pays for the edges its
+ * searches reach. The table is not thread safe (use one per search thread)
+ * except when eagerly customized: searches then only read it, so one table
+ * can be shared by searches on several threads until it is customized
+ * again.
+ */
+class EdgeCostTable {
+ public:
+  /**
+   * Constructor (empty table).
+   */
+  EdgeCostTable();
+
+  /**
+   * Customize the table for a costing. Does nothing if the table is
+   * already customized for the fingerprint. Otherwise all entries become
+   * stale and are recomputed when read, or are all computed now if eager.
+   * @param  graph        Routing graph.
+   * @param  costing      Costing method.
+   * @param  fingerprint  Fingerprint of the costing options.
+   * @param  eager        Compute the cost of all edges now.
+   */
+  void Customize(const RoutingGraph& graph,
+                 const std::shared_ptr<sif::DynamicCost>& costing,
+                 const uint64_t fingerprint, const bool eager);
+
+  /**
+   * Get the cost of an edge, computing it if stale.
+   * @param  edge          Edge index in the routing graph.
+   * @param  directededge  Directed edge record of the edge.
+   * @param  density       Density of the edge's start node.
+   * @param  costing       Costing method (of the table's fingerprint).
+   * @return  Returns the edge cost.
+   */
+  const sif::Cost& Get(const uint32_t edge,
+                       const baldr::DirectedEdge* directededge,
+                       const uint32_t density,
+                       const sif::DynamicCost& costing) {
+    Entry& entry = entries_[edge];
+    if (entry.generation != generation_) {
+      entry.cost = costing.EdgeCost(directededge, density);
+      entry.generation = generation_;
+      computed_++;
+    }
+    return entry.cost;
+  }
+
+  /**
+   * Get the fingerprint the table is customized for.
+   * @return  Returns the fingerprint.
+   */
+  uint64_t fingerprint() const;
+
+  /**
+   * Get the number of entries (edges).
+   * @return  Returns the number of entries.
+   */
+  uint32_t size() const;
+
+  /**
+   * Get the number of edge costs computed since the last customization.
+   * @return  Returns the number of edge costs computed.
+   */
+  uint64_t computed() const;
+
+ protected:
+  struct Entry {
+    sif::Cost cost;
+    uint32_t generation;
+  };
+
+  uint64_t fingerprint_;
+  uint32_t generation_;
+  uint64_t computed_;
+  std::vector<Entry> entries_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_EDGECOSTTABLE_H_
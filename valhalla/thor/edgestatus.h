@@ -2,6 +2,8 @@
 #define VALHALLA_THOR_EDGESTATUS_H_
 
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <valhalla/baldr/graphid.h>
 
 namespace valhalla {
@@ -73,6 +75,47 @@ class EdgeStatus {
   std::unordered_map<baldr::GraphId, EdgeStatusInfo> edgestatus_;
 };
 
+/**
+ * Edge status for densely numbered edges (e.g. RoutingGraph edge indexes)
+ * held in an array rather than a map. Entries are stamped with the search
+ * generation so Init does not need to clear the array.
+ */
+class DenseEdgeStatus {
+ public:
+  DenseEdgeStatus();
+
+  /**
+   * Initialize the status to unreached for all edges.
+   * @param  edgecount  Number of edges.
+   */
+  void Init(const uint32_t edgecount);
+
+  /**
+   * Set the status of a directed edge given its index.
+   * @param  edge     Index of the directed edge to set.
+   * @param  set      Label set for this directed edge.
+   * @param  index    Index of the edge label.
+   */
+  void Set(const uint32_t edge, const EdgeSet set, const uint32_t index) {
+    status_[edge] = std::make_pair(generation_, EdgeStatusInfo(set, index));
+  }
+
+  /**
+   * Get the status info of a directed edge given its index.
+   * @param   edge  Index of the directed edge.
+   * @return  Returns edge status info.
+   */
+  EdgeStatusInfo Get(const uint32_t edge) const {
+    return (status_[edge].first == generation_) ?
+              status_[edge].second : EdgeStatusInfo();
+  }
+
+ private:
+  // Current generation and the generation and status of each edge
+  uint32_t generation_;
+  std::vector<std::pair<uint32_t, EdgeStatusInfo>> status_;
+};
+
 }
 }
 
@@ -0,0 +1,47 @@
+#ifndef VALHALLA_THOR_MEMORYTILE_H_
+#define VALHALLA_THOR_MEMORYTILE_H_
+
+#include <cstddef>
+#include <memory>
+#include <valhalla/baldr/graphtile.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Graph tile over tile data that is already in memory (e.g. a tile in a
+ * memory mapped tile archive or a tile file read asynchronously). The data
+ * is not copied.
+ */
+class MemoryTile : public baldr::GraphTile {
+ public:
+  /**
+   * Constructor. Sets the pointers into the tile data in the same way as
+   * loading a tile file. If the data is not a valid tile the tile is empty
+   * (size() is 0).
+   * @param  data  Tile data (at least 8 byte aligned).
+   * @param  size  Size of the tile data in bytes.
+   */
+  MemoryTile(const char* data, const size_t size);
+
+  /**
+   * Constructor. Shares ownership of the tile data, which is freed with the
+   * last owner.
+   * @param  data  Tile data (at least 8 byte aligned).
+   * @param  size  Size of the tile data in bytes.
+   */
+  MemoryTile(const std::shared_ptr<char>& data, const size_t size);
+
+ protected:
+  /**
+   * Set the pointers into the tile data (graphtile_). Resets the data if it
+   * is not a valid tile.
+   * @param  size  Size of the tile data in bytes.
+   */
+  void Init(const size_t size);
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_MEMORYTILE_H_
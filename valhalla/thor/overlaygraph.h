@@ -0,0 +1,160 @@
+#ifndef VALHALLA_THOR_OVERLAYGRAPH_H_
+#define VALHALLA_THOR_OVERLAYGRAPH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <valhalla/thor/partition.h>
+#include <valhalla/thor/routinggraph.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Topology of a multi-level partition overlay (customizable route
+ * planning) of a routing graph. The overlay is edge based so turn costs
+ * and turn dependent access are handled exactly: the boundary points of a
+ * cell are the edges that cross its boundary. An edge entering a cell is
+ * an entry of the cell and an edge leaving it an exit. Each cell has a
+ * clique from each entry to each exit, whose costs depend on the costing
+ * and are computed by the customization (see OverlayMetric). Shortcut
+ * edges are not part of the overlay.
+ *
+ * The topology only depends on the graph and the partition, so it is
+ * built once and shared by all costings (and threads).
+ */
+class OverlayGraph {
+ public:
+  /**
+   * Constructor (empty overlay).
+   */
+  OverlayGraph();
+
+  /**
+   * Build the overlay of a partitioned graph. The graph and partition must
+   * outlive the overlay.
+   * @param  graph      Routing graph.
+   * @param  partition  Partition of the graph's nodes.
+   */
+  void Build(const RoutingGraph& graph, const Partition& partition);
+
+  /**
+   * Get the routing graph.
+   * @return  Returns the graph.
+   */
+  const RoutingGraph& graph() const {
+    return *graph_;
+  }
+
+  /**
+   * Get the partition.
+   * @return  Returns the partition.
+   */
+  const Partition& partition() const {
+    return *partition_;
+  }
+
+  /**
+   * Get the number of levels.
+   * @return  Returns the number of levels.
+   */
+  uint32_t levels() const {
+    return levels_.size();
+  }
+
+  /**
+   * Get the number of entries of a cell.
+   * @param  level  Level.
+   * @param  cell   Cell.
+   * @return  Returns the number of entries.
+   */
+  uint32_t entry_count(const uint32_t level, const uint32_t cell) const {
+    return levels_[level].entry_offsets[cell + 1] -
+           levels_[level].entry_offsets[cell];
+  }
+
+  /**
+   * Get the entries (edge indexes) of a cell.
+   * @param  level  Level.
+   * @param  cell   Cell.
+   * @return  Returns the entries.
+   */
+  const uint32_t* entries(const uint32_t level, const uint32_t cell) const {
+    return levels_[level].entries.data() + levels_[level].entry_offsets[cell];
+  }
+
+  /**
+   * Get the number of exits of a cell.
+   * @param  level  Level.
+   * @param  cell   Cell.
+   * @return  Returns the number of exits.
+   */
+  uint32_t exit_count(const uint32_t level, const uint32_t cell) const {
+    return levels_[level].exit_offsets[cell + 1] -
+           levels_[level].exit_offsets[cell];
+  }
+
+  /**
+   * Get the exits (edge indexes) of a cell.
+   * @param  level  Level.
+   * @param  cell   Cell.
+   * @return  Returns the exits.
+   */
+  const uint32_t* exits(const uint32_t level, const uint32_t cell) const {
+    return levels_[level].exits.data() + levels_[level].exit_offsets[cell];
+  }
+
+  /**
+   * Get the index of an edge among the entries of the cell it enters.
+   * @param  level  Level.
+   * @param  edge   Edge index.
+   * @return  Returns the entry index or kInvalidNode if the edge does not
+   *          cross a cell boundary of the level.
+   */
+  uint32_t entry_index(const uint32_t level, const uint32_t edge) const {
+    return levels_[level].entry_index[edge];
+  }
+
+  /**
+   * Get the index of an edge among the exits of the cell it leaves.
+   * @param  level  Level.
+   * @param  edge   Edge index.
+   * @return  Returns the exit index or kInvalidNode if the edge does not
+   *          cross a cell boundary of the level.
+   */
+  uint32_t exit_index(const uint32_t level, const uint32_t edge) const {
+    return levels_[level].exit_index[edge];
+  }
+
+  /**
+   * Get the offset of the clique of a cell in the clique costs of its
+   * level. The clique is an entry_count x exit_count matrix (row major).
+   * @param  level  Level.
+   * @param  cell   Cell (cellcount gives the size of all cliques).
+   * @return  Returns the offset.
+   */
+  uint64_t clique_offset(const uint32_t level, const uint32_t cell) const {
+    return levels_[level].clique_offsets[cell];
+  }
+
+ protected:
+  // Boundary edges of the cells of a level
+  struct Level {
+    std::vector<uint32_t> entry_offsets;    // Per cell (cellcount + 1)
+    std::vector<uint32_t> entries;
+    std::vector<uint32_t> exit_offsets;     // Per cell (cellcount + 1)
+    std::vector<uint32_t> exits;
+    std::vector<uint64_t> clique_offsets;   // Per cell (cellcount + 1)
+    std::vector<uint32_t> entry_index;      // Per edge
+    std::vector<uint32_t> exit_index;       // Per edge
+  };
+
+  const RoutingGraph* graph_;
+  const Partition* partition_;
+  std::vector<Level> levels_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_OVERLAYGRAPH_H_
@@ -0,0 +1,115 @@
+#ifndef VALHALLA_THOR_OVERLAYMETRIC_H_
+#define VALHALLA_THOR_OVERLAYMETRIC_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/thor/overlaygraph.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Clique costs of a partition overlay for one costing (the customization
+ * step of customizable route planning). The clique of a cell holds the
+ * cost from each entry to each exit of the cell: the cost of the best path
+ * inside the cell starting after the entry edge, including the edge and
+ * transition costs of the following edges up to and including the exit.
+ * Lowest level cliques are found by searching the cell in the routing
+ * graph and higher level cliques by searching the cliques of the level
+ * below, so customizing is fast enough to do for each set of costing
+ * options (no contraction order depends on the costs).
+ *
+ * Cells of a level are customized in parallel. Costings must therefore be
+ * safe to call from several threads (the sif costings have no mutable
+ * state). Paths inside cells assume that the costing only depends on the
+ * edges and the node, not on the cost of the path so far.
+ */
+class OverlayMetric {
+ public:
+  // Cost of exits that cannot be reached from an entry
+  static constexpr float kUnreachable = std::numeric_limits<float>::max();
+
+  /**
+   * Constructor (not customized).
+   */
+  OverlayMetric();
+
+  /**
+   * Customize the overlay for a costing. Does nothing if already customized
+   * for the fingerprint.
+   * @param  overlay      Overlay graph.
+   * @param  costing      Costing method.
+   * @param  fingerprint  Fingerprint of the costing options.
+   * @param  threads      Number of threads to use.
+   */
+  void Customize(const OverlayGraph& overlay,
+                 const std::shared_ptr<sif::DynamicCost>& costing,
+                 const uint64_t fingerprint, const uint32_t threads);
+
+  /**
+   * Get the fingerprint the metric is customized for.
+   * @return  Returns the fingerprint (0 if not customized).
+   */
+  uint64_t fingerprint() const;
+
+  /**
+   * Get the clique costs from an entry to the exits of the cell it enters.
+   * @param  overlay  Overlay graph.
+   * @param  level    Level.
+   * @param  edge     Edge index of the entry.
+   * @return  Returns the costs in the order of the cell's exits.
+   */
+  const sif::Cost* Row(const OverlayGraph& overlay, const uint32_t level,
+                       const uint32_t edge) const {
+    const RoutingGraph& graph = overlay.graph();
+    uint32_t cell = overlay.partition().cell(level, graph.edge(edge).endnode);
+    return &costs_[level][overlay.clique_offset(level, cell) +
+                          static_cast<uint64_t>(overlay.entry_index(level, edge)) *
+                          overlay.exit_count(level, cell)];
+  }
+
+  /**
+   * Unpack a clique arc into the edges of the routing graph it stands for
+   * by searching the cell in the graph.
+   * @param  overlay  Overlay graph.
+   * @param  costing  Costing method (of the metric's fingerprint).
+   * @param  level    Level of the clique.
+   * @param  entry    Edge index of the entry.
+   * @param  exit     Edge index of the exit.
+   * @param  edges    Returns the edges after the entry up to and including
+   *                  the exit, with the cost from the end of the entry to
+   *                  the end of each edge.
+   * @return  Returns false if the exit is not reached.
+   */
+  bool Unpack(const OverlayGraph& overlay, const sif::DynamicCost& costing,
+              const uint32_t level, const uint32_t entry, const uint32_t exit,
+              std::vector<std::pair<uint32_t, sif::Cost>>& edges) const;
+
+ protected:
+  /**
+   * Customize the cells of a level (called by each thread).
+   * @param  overlay  Overlay graph.
+   * @param  costing  Costing method.
+   * @param  level    Level.
+   * @param  next     Next cell to customize (shared by the threads).
+   */
+  void CustomizeCells(const OverlayGraph& overlay,
+                      const sif::DynamicCost& costing, const uint32_t level,
+                      std::atomic<uint32_t>* next);
+
+  uint64_t fingerprint_;
+
+  // Clique costs of each level (see OverlayGraph::clique_offset)
+  std::vector<std::vector<sif::Cost>> costs_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_OVERLAYMETRIC_H_
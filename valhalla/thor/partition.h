@@ -0,0 +1,124 @@
+#ifndef VALHALLA_THOR_PARTITION_H_
+#define VALHALLA_THOR_PARTITION_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <valhalla/thor/routinggraph.h>
+#include <valhalla/thor/snapshot.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Multi-level partition of the nodes of a routing graph into cells, the
+ * offline step of the partition overlay (see OverlayGraph). Cells are
+ * nested: each cell of a level is the union of cells of the level below.
+ *
+ * Cells are formed by recursive coordinate bisection: the nodes are split
+ * at the median of the longer side of their bounding box until a part has
+ * no more nodes than the cell size of the level. This is simpler than the
+ * cut-minimizing partitioners used by customizable route planning and
+ * gives more boundary edges per cell, which only costs customization time
+ * and overlay size. Nodes connected by transition edges (the same location
+ * on different hierarchy levels) are kept in the same cell so transition
+ * edges never cross a cell boundary.
+ *
+ * A partition refers to nodes by index, so it must be built after the
+ * graph is reordered (or rebuilt if the graph changes).
+ */
+class Partition {
+ public:
+  /**
+   * Constructor (no levels).
+   */
+  Partition();
+
+  /**
+   * Partition the nodes of a graph.
+   * @param  graph       Routing graph.
+   * @param  cell_sizes  Maximum number of node locations per cell of each
+   *                     level, lowest level first (increasing).
+   */
+  void Build(const RoutingGraph& graph,
+             const std::vector<uint32_t>& cell_sizes);
+
+  /**
+   * Add the partition to a snapshot. The partition must not change until
+   * the snapshot is written.
+   * @param  writer  Snapshot writer.
+   */
+  void Write(SnapshotWriter& writer) const;
+
+  /**
+   * Load the partition from a snapshot (the cells are copied).
+   * @param  snapshot   Loaded snapshot.
+   * @param  nodecount  Number of nodes of the graph the partition is for.
+   * @return  Returns false if the snapshot has no partition or it is for
+   *          a graph with a different number of nodes.
+   */
+  bool Load(const Snapshot& snapshot, const uint32_t nodecount);
+
+  /**
+   * Get the number of levels.
+   * @return  Returns the number of levels.
+   */
+  uint32_t levels() const {
+    return cell_sizes_.size();
+  }
+
+  /**
+   * Get the number of cells of a level.
+   * @param  level  Level.
+   * @return  Returns the number of cells.
+   */
+  uint32_t cellcount(const uint32_t level) const {
+    return cell_counts_[level];
+  }
+
+  /**
+   * Get the cell of a node.
+   * @param  level  Level.
+   * @param  node   Node index.
+   * @return  Returns the cell index within the level.
+   */
+  uint32_t cell(const uint32_t level, const uint32_t node) const {
+    return cells_[static_cast<size_t>(level) * nodecount_ + node];
+  }
+
+ protected:
+  /**
+   * Split a range of locations into cells of a level and the cells of the
+   * levels below.
+   * @param  lls    Lat,lng of each location.
+   * @param  locs   Locations (reordered in place).
+   * @param  begin  First location of the range.
+   * @param  end    End of the range.
+   * @param  level  Level.
+   * @param  loc_cells  Cells of the locations (level major).
+   */
+  void Split(const std::vector<midgard::PointLL>& lls,
+             std::vector<uint32_t>& locs, const uint32_t begin,
+             const uint32_t end, const uint32_t level,
+             std::vector<uint32_t>& loc_cells);
+
+  // Snapshot header
+  static constexpr uint32_t kPartitionVersion = 1;
+  struct Header {
+    uint32_t version;
+    uint32_t levels;
+    uint32_t nodecount;
+    uint32_t spare;
+  };
+  mutable Header header_;
+
+  uint32_t nodecount_;
+  std::vector<uint32_t> cell_sizes_;
+  std::vector<uint32_t> cell_counts_;
+  std::vector<uint32_t> cells_;   // Cell of each node (level major)
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_PARTITION_H_
@@ -1,7 +1,9 @@
 #ifndef VALHALLA_THOR_PATHALGORITHM_H_
 #define VALHALLA_THOR_PATHALGORITHM_H_
 
+#include <chrono>
 #include <vector>
+#include <limits>
 #include <map>
 #include <unordered_map>
 #include <utility>
@@ -14,8 +16,21 @@
 #include <valhalla/sif/hierarchylimits.h>
 #include <valhalla/thor/adjacencylist.h>
 #include <valhalla/thor/astarheuristic.h>
+#include <valhalla/thor/corridor.h>
+#include <valhalla/thor/edgecosttable.h>
 #include <valhalla/thor/edgestatus.h>
+#include <valhalla/thor/overlaygraph.h>
+#include <valhalla/thor/overlaymetric.h>
+#include <valhalla/thor/pathcost.h>
 #include <valhalla/thor/pathinfo.h>
+#include <valhalla/thor/routinggraph.h>
+#include <valhalla/thor/searchstats.h>
+#include <valhalla/thor/transitioncosttable.h>
+#include <valhalla/thor/searchtilecache.h>
+#include <valhalla/thor/shortcuttable.h>
+#include <valhalla/thor/tilecache.h>
+#include <valhalla/thor/tilemanifest.h>
+#include <valhalla/thor/tileprefetcher.h>
 
 namespace valhalla {
 namespace thor {
@@ -42,13 +57,193 @@ class PathAlgorithm {
    * @param  dest    Destination location
    * @param  graphreader  Graph reader for accessing routing graph.
    * @param  costing  Costing method.
+   * @param  warm_start_key  Key identifying the costing (e.g. a fingerprint
+   *                  of the costing options). When warm start is enabled
+   *                  and the key and origin edges match the previous search,
+   *                  the search tree retained from that search is reused.
+   *                  0 never reuses or retains the search tree.
+   * @param  cost_bound  Upper bound of the path cost (e.g. the cost of a
+   *                  path found by a cheaper search). Edges whose cost plus
+   *                  (unweighted) A* heuristic exceeds it are not labeled,
+   *                  which does not change the path as long as the bound is
+   *                  at least its cost. If the bound is too low no path is
+   *                  found. Bounded searches are not warm started.
    * @return  Returns the path edges (and elapsed time/modes at end of
    *          each edge).
    */
   std::vector<PathInfo> GetBestPath(const baldr::PathLocation& origin,
+          const baldr::PathLocation& dest, baldr::GraphReader& graphreader,
+          const std::shared_ptr<sif::DynamicCost>& costing,
+          const uint64_t warm_start_key = 0,
+          const float cost_bound = std::numeric_limits<float>::max());
+
+  /**
+   * Form path between an origin and destination location with a search
+   * bounded by the cost of a coarse route (see GetBestPath and the coarse
+   * route of GetBestPathCorridor). Falls back to the unbounded search if
+   * the bounded search finds no path. The search statistics count the
+   * expansions of all searches.
+   * @param  origin  Origin location
+   * @param  dest    Destination location
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  costing  Costing method.
+   * @return  Returns the path edges (and elapsed time/modes at end of
+   *          each edge).
+   */
+  std::vector<PathInfo> GetBestPathBounded(const baldr::PathLocation& origin,
           const baldr::PathLocation& dest, baldr::GraphReader& graphreader,
           const std::shared_ptr<sif::DynamicCost>& costing);
 
+  /**
+   * Find the cost and length of the best path between an origin and
+   * destination location without forming the path (one search, see
+   * GetBestPath). Used for time and distance only requests.
+   * @param  origin  Origin location
+   * @param  dest    Destination location
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  costing  Costing method.
+   * @param  pathcost  Returns the cost, elapsed time and length of the path
+   *                  from the origin to the destination location.
+   * @param  warm_start_key  Key identifying the costing (see GetBestPath).
+   * @return  Returns false if no path is found.
+   */
+  bool GetBestCost(const baldr::PathLocation& origin,
+          const baldr::PathLocation& dest, baldr::GraphReader& graphreader,
+          const std::shared_ptr<sif::DynamicCost>& costing, PathCost& pathcost,
+          const uint64_t warm_start_key = 0);
+
+  /**
+   * Form a path from a new position to the destination of a previous route
+   * (e.g. after a driver deviates from the route). The search stops once it
+   * has found the best way to join the remainder of the previous route -
+   * each edge of the previous route is a destination whose cost to reach
+   * the final destination is known - and the suffix of the previous route
+   * is spliced onto the path found. Falls back to GetBestPath if the
+   * previous route does not end at the destination.
+   * @param  position  New position (origin of the new path)
+   * @param  dest      Destination location
+   * @param  path      Previous route to the destination (as returned by
+   *                   GetBestPath with the same costing).
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  costing  Costing method.
+   * @return  Returns the path edges (and elapsed time/modes at end of
+   *          each edge).
+   */
+  std::vector<PathInfo> GetBestPathReroute(const baldr::PathLocation& position,
+          const baldr::PathLocation& dest, const std::vector<PathInfo>& path,
+          baldr::GraphReader& graphreader,
+          const std::shared_ptr<sif::DynamicCost>& costing);
+
+  /**
+   * Form path between an origin and destination location in two phases.
+   * The first phase finds a coarse route that mostly uses the highway
+   * level: the arterial and local levels stop expanding once the search has
+   * transitioned up from them (except near the destination). The second
+   * phase is the search of GetBestPath restricted to the tiles within a
+   * corridor around the coarse route. If it finds no path the search is run
+   * again without the corridor. The search statistics count the expansions
+   * of all phases.
+   * @param  origin  Origin location
+   * @param  dest    Destination location
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  costing  Costing method.
+   * @param  radius   Width (meters) of the corridor on each side of the
+   *                  coarse route.
+   * @return  Returns the path edges (and elapsed time/modes at end of
+   *          each edge).
+   */
+  std::vector<PathInfo> GetBestPathCorridor(const baldr::PathLocation& origin,
+          const baldr::PathLocation& dest, baldr::GraphReader& graphreader,
+          const std::shared_ptr<sif::DynamicCost>& costing,
+          const float radius);
+
+  /**
+   * Form path between an origin and destination location with an anytime
+   * search (anytime repairing A*). The first iteration is a weighted A*
+   * search (see SetEpsilon) that finds a path quickly. Each further
+   * iteration lowers epsilon and continues from the labels of the previous
+   * ones: the edge labels are kept, the frontier is re-sorted for the new
+   * weight and settled edges that were since reached at lower cost are
+   * searched again. Iterations continue until epsilon reaches 0 (the path
+   * of GetBestPath) or the deadline, when the best path found so far is
+   * returned.
+   * @param  origin    Origin location
+   * @param  dest      Destination location
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  costing   Costing method.
+   * @param  deadline  Time by which to return the best path found.
+   * @param  epsilon   Suboptimality allowed in the first iteration.
+   * @param  bound     Returns the suboptimality bound of the path: it costs
+   *                   at most (1 + bound) times the path of GetBestPath
+   *                   (heuristic if hierarchy limits prune, see
+   *                   SetEpsilon). 0 if it is that path. The epsilon of an iteration
+   *                   once it settles a destination edge (the deadline may
+   *                   end the iteration early).
+   * @param  cost_bound  Labels whose cost plus the unweighted heuristic
+   *                     exceed this are not added (as in GetBestPath).
+   * @return  Returns the path edges (and elapsed time/modes at end of
+   *          each edge). Empty if no path was found before the deadline.
+   */
+  std::vector<PathInfo> GetBestPathAnytime(const baldr::PathLocation& origin,
+          const baldr::PathLocation& dest, baldr::GraphReader& graphreader,
+          const std::shared_ptr<sif::DynamicCost>& costing,
+          const std::chrono::steady_clock::time_point& deadline,
+          const float epsilon, float& bound,
+          const float cost_bound = std::numeric_limits<float>::max());
+
+  /**
+   * Form path between an origin and destination location on a flattened
+   * routing graph (see RoutingGraph) rather than on the graph tiles. The
+   * search is the same as GetBestPath (without warm start) so the path is
+   * identical as long as the search stays within the region of the graph.
+   * Falls back to GetBestPath for loops and for locations whose edges are
+   * not in the graph.
+   * @param  origin  Origin location
+   * @param  dest    Destination location
+   * @param  graph   Routing graph.
+   * @param  graphreader  Graph reader (used for the locations and to form
+   *                      the path).
+   * @param  costing  Costing method.
+   * @param  edgecosts  Edge costs of the graph customized for the costing
+   *                    (see EdgeCostTable::Customize). nullptr computes
+   *                    edge costs with the costing.
+   * @param  transitioncosts  Transition costs of the graph customized for
+   *                    the costing (see TransitionCostTable::Customize).
+   *                    nullptr computes transition costs with the costing.
+   * @return  Returns the path edges (and elapsed time/modes at end of
+   *          each edge).
+   */
+  std::vector<PathInfo> GetBestPath(const baldr::PathLocation& origin,
+          const baldr::PathLocation& dest, const RoutingGraph& graph,
+          baldr::GraphReader& graphreader,
+          const std::shared_ptr<sif::DynamicCost>& costing,
+          EdgeCostTable* edgecosts = nullptr,
+          TransitionCostTable* transitioncosts = nullptr);
+
+  /**
+   * Form path between an origin and destination location on a partition
+   * overlay of a routing graph (customizable route planning). The search is
+   * an A* over graph edges near the origin and destination and over the
+   * cell cliques elsewhere: from an edge entering a cell that holds neither
+   * location it continues from the exits of the highest such cell. Paths
+   * are optimal for the costing (there are no hierarchy limits), so they
+   * can differ from those of the tile search. Clique arcs on the path are
+   * unpacked into graph edges. Falls back to GetBestPath for loops and for
+   * locations whose edges are not in the graph.
+   * @param  origin  Origin location
+   * @param  dest    Destination location
+   * @param  overlay  Overlay graph.
+   * @param  metric   Overlay customized for the costing.
+   * @param  graphreader  Graph reader (used for the locations).
+   * @param  costing  Costing method.
+   * @return  Returns the path edges (and elapsed time/modes at end of
+   *          each edge).
+   */
+  std::vector<PathInfo> GetBestPath(const baldr::PathLocation& origin,
+          const baldr::PathLocation& dest, const OverlayGraph& overlay,
+          const OverlayMetric& metric, baldr::GraphReader& graphreader,
+          const std::shared_ptr<sif::DynamicCost>& costing);
+
   /**
    * Form multi-modal path between and origin and destination location using
    * the supplied costing method.
@@ -68,6 +263,96 @@ class PathAlgorithm {
    */
   void Clear();
 
+  /**
+   * Get statistics about the most recent search (valid until Clear is
+   * called).
+   * @return  Returns the search statistics.
+   */
+  SearchStats stats() const;
+
+  /**
+   * Set a tile prefetcher. GetBestPath periodically passes the position of
+   * its current best label to the prefetcher so tiles ahead of the search
+   * frontier are loaded in the background.
+   * @param  prefetcher  Tile prefetcher (not owned). nullptr disables
+   *                     prefetching.
+   */
+  void SetPrefetcher(TilePrefetcher* prefetcher);
+
+  /**
+   * Set a shortcut table. When set, shortcut edges on the path are unpacked
+   * into the edges they replace when the path is formed.
+   * @param  shortcuts  Shortcut table (not owned). nullptr leaves shortcut
+   *                    edges on the path.
+   */
+  void SetShortcutTable(const ShortcutTable* shortcuts);
+
+  /**
+   * Set a tile cache shared with searches on other threads. Tiles needed
+   * by the search (the expansion, origin and destination edges and path
+   * forming) are taken from it rather than from the graph reader. Each
+   * search is a read section on the shared cache. A reader is registered
+   * on the cache once (setting the same cache again has no effect) and is
+   * released when the cache is replaced or the PathAlgorithm destroyed.
+   * @param  tilecache  Shared tile cache (not owned). nullptr uses the
+   *                    graph reader.
+   */
+  void SetTileCache(TileCache* tilecache);
+
+  /**
+   * Get the shared tile cache (nullptr if not set).
+   * @return  Returns the shared tile cache.
+   */
+  TileCache* tile_cache() const {
+    return shared_tilecache_;
+  }
+
+  /**
+   * Get the reader Id of this search on the shared tile cache, e.g. to
+   * read the tiles of a formed path within a read section.
+   * @return  Returns the reader Id.
+   */
+  uint32_t tile_cache_reader() const {
+    return shared_tilecache_reader_;
+  }
+
+  /**
+   * Set a manifest to record the tiles used by searches in (see
+   * TileManifest).
+   * @param  manifest  Tile manifest (not owned). nullptr disables recording.
+   */
+  void SetTileManifest(TileManifest* manifest);
+
+  /**
+   * Enable reuse of the search tree between routes from the same origin.
+   * When enabled the edge labels of a search are kept until the next call
+   * to GetBestPath. If that call has the same origin edges and warm start
+   * key, a destination already inside the settled region is answered
+   * immediately and otherwise the search resumes from the retained frontier
+   * after re-prioritizing it for the new destination. Callers must not call
+   * Clear between such routes (Clear discards the retained tree).
+   * @param  max_labels  Maximum number of edge labels to retain. A larger
+   *                     tree is discarded. 0 disables warm start.
+   */
+  void SetWarmStart(const uint32_t max_labels);
+
+  /**
+   * Set the suboptimality allowed for faster searches (weighted A*). The A*
+   * heuristic is inflated by a factor of 1 + epsilon, which draws the
+   * search towards the destination so it expands fewer edge labels. Since
+   * the heuristic never overestimates the remaining cost, the path found
+   * costs at most (1 + epsilon) times the optimal path when the hierarchy
+   * limits do not prune the search (e.g. short routes or a single level).
+   * Hierarchy limits depend on the order edges are expanded, so once they
+   * prune, the weighted search may prune different edges than the search
+   * with epsilon 0 and the bound is only a heuristic. Applies to
+   * the tile, routing graph and overlay searches; multimodal searches do
+   * not use A*. A search tree retained for warm start is only reused with
+   * the same epsilon.
+   * @param  epsilon  Suboptimality allowed (0 for the regular A* search).
+   */
+  void SetEpsilon(const float epsilon);
+
  protected:
   // Allow transitions (set from the costing model)
   bool allow_transitions_;
@@ -81,8 +366,10 @@ class PathAlgorithm {
   // Hierarchy limits.
   std::vector<sif::HierarchyLimits> hierarchy_limits_;
 
-  // A* heuristic
+  // A* heuristic and the suboptimality allowed (the heuristic is weighted
+  // by 1 + epsilon)
   AStarHeuristic astarheuristic_;
+  float epsilon_;
 
   // List of edge labels
   uint64_t edgelabel_index_;
@@ -94,12 +381,250 @@ class PathAlgorithm {
   // Edge status
   EdgeStatus* edgestatus_;
 
+  // Recently used graph tiles (avoids GraphReader lookups in the expansion)
+  // and the tile cache shared between threads (optional, not owned)
+  SearchTileCache tilecache_;
+  TileCache* shared_tilecache_;
+  uint32_t shared_tilecache_reader_;
+
+  // Number of edge labels expanded
+  uint32_t expansions_;
+
+  // Upper bound of the path cost of the current search and the number of
+  // edges not labeled because of it
+  float cost_bound_;
+  uint32_t pruned_;
+
+  // Corridor searches: the search is for the coarse route (lower levels
+  // stop expanding once left) and the corridor the search is restricted to
+  // (not restricted if nullptr)
+  bool coarse_;
+  const Corridor* corridor_;
+  Corridor search_corridor_;
+
+  // Only the cost of the path is needed - the path is not formed
+  bool cost_only_;
+
+  // Tile prefetcher (optional, not owned)
+  TilePrefetcher* prefetcher_;
+
+  // Shortcut table (optional, not owned) and edges of an unpacked shortcut
+  const ShortcutTable* shortcuts_;
+  std::vector<std::pair<baldr::GraphId, float>> shortcut_edges_;
+
+  // Warm start: maximum labels to retain, key and origin edges of the
+  // retained search tree, and labels that were settled without being fully
+  // expanded (hierarchy limits or completion). Key is 0 if there is no
+  // retained tree.
+  uint32_t warm_start_max_labels_;
+  uint64_t warm_start_key_;
+  float warm_start_epsilon_;
+  std::vector<std::pair<baldr::GraphId, float>> warm_start_origin_;
+  std::vector<uint32_t> deferred_;
+
   // Destinations, id and cost
   std::unordered_map<baldr::GraphId, sif::Cost> destinations_;
 
   // Destination that was last found with its true cost + partial cost
   std::pair<uint32_t, sif::Cost> best_destination_;
 
+  // Edges of the previous route when rerouting: index along the previous
+  // route and cost from the end of the edge to the destination
+  std::unordered_map<baldr::GraphId, std::pair<uint32_t, sif::Cost>> reroute_edges_;
+
+  // Edges leaving the node being expanded. These are collected so the A*
+  // heuristic can be computed for all of their end nodes in one batch and
+  // are then added to the adjacency list in their original order. Transition
+  // edges keep the predecessor's distance so are not in the batch (the
+  // lat,lngs, distances and heuristics are of the other candidates).
+  struct ExpansionCandidate {
+    baldr::GraphId edgeid;
+    const baldr::DirectedEdge* directededge;
+    sif::Cost cost;
+    uint32_t walking_distance;
+  };
+  std::vector<ExpansionCandidate> candidates_;
+  std::vector<midgard::PointLL> candidate_lls_;
+  std::vector<float> candidate_dists_;
+  std::vector<float> candidate_heuristics_;
+
+  // Anytime searches: iteration each edge label was settled in (kUnsettled
+  // if not settled), the current iteration and the labels settled in it
+  // that were since reached at lower cost
+  static constexpr uint32_t kUnsettled = ~0u;
+  std::vector<uint32_t> settled_;
+  uint32_t iteration_;
+  std::vector<uint32_t> improved_;
+
+  // Routing graph searches: edge status by edge index, edge index of each
+  // edge label and edges leaving the node being expanded
+  struct GraphCandidate {
+    uint32_t edge;
+    sif::Cost cost;
+    uint32_t walking_distance;
+  };
+  DenseEdgeStatus graph_edgestatus_;
+  std::vector<uint32_t> graph_label_edges_;
+  std::vector<GraphCandidate> graph_candidates_;
+
+  // Overlay searches: level of the clique arc each edge label was reached
+  // by (kGraphArc for graph edges), cells holding the origin or destination
+  // at each level and the edges of an unpacked clique arc
+  static constexpr uint8_t kGraphArc = 0xff;
+  std::vector<uint8_t> overlay_label_levels_;
+  std::vector<std::vector<uint32_t>> endpoint_cells_;
+  std::vector<std::pair<uint32_t, sif::Cost>> unpacked_edges_;
+
+  /**
+   * A* search kernel used by GetBestPath (and to reroute).
+   * @param  origin  Origin location
+   * @param  dest    Destination location (already updated for node dests)
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  costing  Costing method.
+   * @param  loop_edge_info  PathInfo representing the loop edge (invalid if
+   *                         none).
+   * @param  warm_start  Resume the retained search tree rather than start
+   *                     a new search.
+   * @return  Returns the path edges (and elapsed time/modes at end of
+   *          each edge).
+   */
+  std::vector<PathInfo> AStar(const baldr::PathLocation& origin,
+          const baldr::PathLocation& dest, baldr::GraphReader& graphreader,
+          const std::shared_ptr<sif::DynamicCost>& costing,
+          const PathInfo& loop_edge_info, const bool warm_start);
+
+  /**
+   * Get the cost bound labels are pruned with: cost_bound_ widened by the
+   * cost of the destination edges (their labels end past the destination,
+   * where the heuristic does not bound the cost).
+   * @param  dest  Destination location (already updated for node dests)
+   * @param  cost  Costing method.
+   * @return  Returns the prune cost (max float if not bounded).
+   */
+  float PruneCost(const baldr::PathLocation& dest,
+                  const sif::DynamicCost& cost);
+
+  /**
+   * Expand the edges leaving the end node of a settled label - the
+   * relaxation shared by AStar and GetBestPathAnytime. Lower cost paths to
+   * labeled edges update their labels, transition edges are handled and
+   * the other edges are labeled with the A* heuristic (computed for all of
+   * them at once). Edges outside the corridor and labels whose cost plus
+   * the unweighted heuristic exceeds the prune cost are skipped.
+   * @param  predindex   Index of the label being expanded.
+   * @param  pred        Label being expanded (a copy).
+   * @param  tile        Tile of the label's end node.
+   * @param  nodeinfo    End node of the label.
+   * @param  cost        Costing method.
+   * @param  prune_cost  Cost bound (see PruneCost).
+   * @param  heuristic_scale  Scale from the weighted A* heuristic to the
+   *                          unweighted one (1 / (1 + epsilon)).
+   * @tparam anytime  Anytime search: settled edges reached at lower cost
+   *                  are searched again and new labels are recorded as not
+   *                  settled (settled_).
+   */
+  template <bool anytime>
+  void Expand(const uint32_t predindex, const sif::EdgeLabel& pred,
+              const baldr::GraphTile* tile, const baldr::NodeInfo* nodeinfo,
+              const sif::DynamicCost& cost, const float prune_cost,
+              const float heuristic_scale);
+
+  /**
+   * A* search kernel used by GetBestPath on a routing graph. This is the
+   * AStar expansion with nodes and edges addressed by their index in the
+   * graph, so it needs no tile lookups. The kernel is instantiated per
+   * source of edge costs (the costing or the customized tables) so costs
+   * read from the tables are not computed through sif::DynamicCost.
+   * @param  origin  Origin location (edges must be in the graph)
+   * @param  dest    Destination location (already updated for node dests)
+   * @param  graph   Routing graph.
+   * @param  graphreader  Graph reader (used to form the path).
+   * @param  costing  Costing method.
+   * @param  costs   Edge cost source (edge plus transition cost of the
+   *                 edges leaving a node).
+   * @return  Returns the path edges (and elapsed time/modes at end of
+   *          each edge).
+   */
+  template <class costs_t>
+  std::vector<PathInfo> AStarGraph(const baldr::PathLocation& origin,
+          const baldr::PathLocation& dest, const RoutingGraph& graph,
+          baldr::GraphReader& graphreader,
+          const std::shared_ptr<sif::DynamicCost>& costing, costs_t& costs);
+
+  /**
+   * Form the path of an overlay search, unpacking clique arcs.
+   * @param   dest     Index in the edge labels of the destination edge.
+   * @param   overlay  Overlay graph.
+   * @param   metric   Overlay customized for the costing.
+   * @param   costing  Costing method.
+   * @return  Returns the path edges (and elapsed time/modes at end of
+   *          each edge).
+   */
+  std::vector<PathInfo> FormOverlayPath(const uint32_t dest,
+          const OverlayGraph& overlay, const OverlayMetric& metric,
+          const std::shared_ptr<sif::DynamicCost>& costing);
+
+  /**
+   * Check if the retained search tree can be reused for a route. If not,
+   * any retained tree is discarded and the key and origin of the new
+   * search are recorded.
+   * @param  origin  Origin location
+   * @param  warm_start_key  Key identifying the costing.
+   * @param  loop_edge_info  PathInfo representing the loop edge (invalid if
+   *                         none). Loop routes are never warm started.
+   * @return  Returns true if the retained search tree can be reused.
+   */
+  bool CanWarmStart(const baldr::PathLocation& origin,
+                    const uint64_t warm_start_key,
+                    const PathInfo& loop_edge_info);
+
+  /**
+   * Prepare the retained search tree for a new destination. Destination
+   * edges that are already settled are taken as found. The A* heuristic is
+   * re-initialized and a new adjacency list is formed from the temporarily
+   * labeled edges and the settled labels whose expansion was cut short,
+   * with sort costs computed for the new destination.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  dest     Destination location (already updated for node dests)
+   * @param  costing  Costing method.
+   * @return  Returns true if all destination edges are already settled (the
+   *          path can be formed immediately).
+   */
+  bool ResumeSearch(baldr::GraphReader& graphreader,
+                    const baldr::PathLocation& dest,
+                    const std::shared_ptr<sif::DynamicCost>& costing);
+
+  /**
+   * Prepare the next iteration of an anytime search. The A* heuristic is
+   * weighted for the new epsilon and a new adjacency list is formed from
+   * the temporarily labeled edges and the settled edges that were reached
+   * at lower cost after they were expanded (these become temporary again).
+   * @param  destll   Lat,lng of the destination.
+   * @param  costing  Costing method.
+   * @param  epsilon  Suboptimality allowed in the iteration.
+   * @param  improved Labels of settled edges reached at lower cost (cleared).
+   * @return  Returns false if there are no labels left to search.
+   */
+  bool Reprioritize(const PointLL& destll,
+                    const std::shared_ptr<sif::DynamicCost>& costing,
+                    const float epsilon, std::vector<uint32_t>& improved);
+
+  /**
+   * Set the edges of a previous route as destinations for rerouting. The
+   * cost along the previous route is computed with the costing method and
+   * the cost from the end of each edge to the destination is kept.
+   * @param  graphreader  Graph reader for accessing routing graph.
+   * @param  dest     Destination location (already updated for node dests)
+   * @param  path     Previous route.
+   * @param  costing  Costing method.
+   * @return  Returns false if the previous route cannot be used (does not
+   *          end at the destination or its tiles are not found).
+   */
+  bool SetRerouteEdges(baldr::GraphReader& graphreader,
+                       const baldr::PathLocation& dest,
+                       const std::vector<PathInfo>& path,
+                       const std::shared_ptr<sif::DynamicCost>& costing);
+
   /**
    * Initializes the hierarch limits, A* heuristic, and adjacency list.
    * @param  origll  Lat,lng of the origin.
@@ -0,0 +1,27 @@
+#ifndef VALHALLA_THOR_PATHCOST_H_
+#define VALHALLA_THOR_PATHCOST_H_
+
+#include <valhalla/sif/dynamiccost.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Cost and length of a path from the origin to the destination location,
+ * for requests that need the time and distance but not the path itself
+ * (see PathAlgorithm::GetBestCost).
+ */
+struct PathCost {
+  sif::Cost cost;          // Cost and elapsed time (seconds) of the path
+  float length;            // Length of the path in meters
+
+  PathCost()
+      : cost(0.0f, 0.0f),
+        length(0.0f) {
+  }
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_PATHCOST_H_
@@ -0,0 +1,118 @@
+#ifndef VALHALLA_THOR_ROUTECACHE_H_
+#define VALHALLA_THOR_ROUTECACHE_H_
+
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/pathlocation.h>
+#include <valhalla/thor/pathinfo.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * LRU cache of path results. Routes are keyed by the correlated origin and
+ * destination edges (with the percent along each edge quantized) and a
+ * fingerprint of the costing options used. The cached value is the path
+ * (list of PathInfo) so the trip path is still built with the locations of
+ * the request being answered. Entries expire after a time to live and the
+ * cache is bounded by both entry count and memory use. The cache is thread
+ * safe (a mutex guards the entries) so one cache is shared by the worker
+ * threads of a service.
+ */
+class RouteCache {
+ public:
+  /**
+   * Constructor.
+   * @param  max_entries  Maximum number of cached routes. 0 disables the
+   *                      cache.
+   * @param  max_bytes    Maximum (approximate) memory used by cached routes.
+   * @param  ttl          Time to live of a cached route in seconds.
+   */
+  RouteCache(const size_t max_entries, const size_t max_bytes,
+             const uint32_t ttl);
+
+  /**
+   * Form the cache key for a route request. Returns an empty key if the
+   * route should not be cached (origin and destination share an edge).
+   * @param  origin   Correlated origin location.
+   * @param  dest     Correlated destination location.
+   * @param  costing_fingerprint  Hash of the costing method and its options.
+   * @return  Returns the cache key.
+   */
+  static std::string Key(const baldr::PathLocation& origin,
+                         const baldr::PathLocation& dest,
+                         const uint64_t costing_fingerprint);
+
+  /**
+   * Get a cached route. Expired entries are removed.
+   * @param  key   Cache key.
+   * @param  path  Returns the cached path if found.
+   * @return  Returns true if the route was found.
+   */
+  bool Get(const std::string& key, std::vector<PathInfo>& path);
+
+  /**
+   * Add a route to the cache, evicting the least recently used routes if
+   * the cache is full.
+   * @param  key   Cache key.
+   * @param  path  Path to cache.
+   */
+  void Put(const std::string& key, const std::vector<PathInfo>& path);
+
+  /**
+   * Remove all cached routes (counters are kept).
+   */
+  void Clear();
+
+  /**
+   * Is the cache enabled.
+   * @return  Returns true if routes are cached.
+   */
+  bool enabled() const;
+
+  size_t size() const;        // Number of cached routes
+  size_t bytes() const;       // Approximate memory used by cached routes
+  uint64_t hits() const;      // Number of lookups that found a route
+  uint64_t misses() const;    // Number of lookups that did not
+  uint64_t evictions() const; // Number of routes evicted (LRU or expired)
+
+ protected:
+  struct Entry {
+    std::string key;
+    std::vector<PathInfo> path;
+    std::chrono::steady_clock::time_point expires;
+    size_t bytes;
+  };
+
+  /**
+   * Remove an entry.
+   * @param  it  Entry to remove.
+   */
+  void Remove(std::list<Entry>::iterator it);
+
+  size_t max_entries_;
+  size_t max_bytes_;
+  std::chrono::seconds ttl_;
+
+  // Entries in most recently used order and a map from key to entry (and
+  // the counters) guarded by the mutex
+  mutable std::mutex mutex_;
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+
+  size_t bytes_;
+  uint64_t hits_;
+  uint64_t misses_;
+  uint64_t evictions_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_ROUTECACHE_H_
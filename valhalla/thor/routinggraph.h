@@ -0,0 +1,342 @@
+#ifndef VALHALLA_THOR_ROUTINGGRAPH_H_
+#define VALHALLA_THOR_ROUTINGGRAPH_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <valhalla/midgard/aabb2.h>
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/baldr/directededge.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/nodeinfo.h>
+#include <valhalla/thor/snapshot.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Packed attributes of an edge in the routing graph: the end node index
+ * and the flags the expansion checks before costing the edge.
+ */
+struct RoutingEdge {
+  uint32_t endnode;          // Index of the end node (kInvalidNode if the
+                             // end node is outside of the graph)
+  uint8_t shortcut;          // Shortcut mask
+  uint8_t superseded;        // Superseded (by shortcut) mask
+  uint8_t trans_up   : 1;    // Transition up the hierarchy
+  uint8_t trans_down : 1;    // Transition down the hierarchy
+  uint8_t is_shortcut : 1;   // Shortcut edge
+  uint8_t spare      : 5;
+  uint8_t spare2;
+};
+
+/**
+ * Order of the nodes in the routing graph. Tile order numbers nodes by
+ * tile and then by their index in the tile. The space-filling curve orders
+ * number nodes along a Morton (Z-order) or Hilbert curve over their
+ * lat,lng so geographically close nodes - and their edges - are close in
+ * memory, including across tile borders.
+ */
+enum class NodeOrder {
+  kTile,
+  kMorton,
+  kHilbert
+};
+
+/**
+ * Routable graph of a region (all hierarchy levels) flattened from the
+ * graph tiles into compressed sparse row (CSR) form. Nodes are numbered in
+ * tile order and the edges leaving node i are edges [edge_index(i),
+ * edge_index(i + 1)). Node coordinates and the packed edge attributes are
+ * held in their own arrays so the expansion touches little memory per
+ * edge, and nodes and edges are addressed by index rather than by GraphId,
+ * so no tile lookups are needed during a search. Copies of the NodeInfo
+ * and DirectedEdge records are kept for costing. GraphIds map to indexes
+ * through the tile ranges and indexes map back to GraphIds for forming
+ * the path. Nodes are in tile order after Build and can be renumbered
+ * with Reorder.
+ *
+ * A graph can be written to a snapshot (see Snapshot) and loaded from it.
+ * A loaded graph uses the arrays of the memory mapped snapshot in place.
+ */
+class RoutingGraph {
+ public:
+  // Index of nodes (and edges) not in the graph
+  static constexpr uint32_t kInvalidNode = 0xffffffff;
+
+  /**
+   * Constructor (empty graph).
+   */
+  RoutingGraph();
+
+  // The arrays may point to the graph's own storage, so graphs are not
+  // copied
+  RoutingGraph(const RoutingGraph&) = delete;
+  RoutingGraph& operator=(const RoutingGraph&) = delete;
+
+  /**
+   * Build the graph from the tiles (all levels) intersecting a region. Use
+   * bounds covering the world for the whole dataset. Edges that end
+   * outside the region are kept with an invalid end node.
+   * @param  reader  Graph reader.
+   * @param  region  Bounding box of the region.
+   * @return  Returns false if the tiles could not be flattened.
+   */
+  bool Build(baldr::GraphReader& reader,
+             const midgard::AABB2<midgard::PointLL>& region);
+
+  /**
+   * Add the arrays of the graph to a snapshot. The graph must not change
+   * until the snapshot is written.
+   * @param  writer  Snapshot writer.
+   */
+  void Write(SnapshotWriter& writer) const;
+
+  /**
+   * Load the graph from a snapshot. The arrays are used in place, so the
+   * snapshot must outlive the graph (or the next Build or Load).
+   * @param  snapshot  Loaded snapshot.
+   * @param  verify    Check that every edge ends at a node of the graph
+   *                   (this reads all of the edges).
+   * @return  Returns false if the snapshot has no graph, the graph was
+   *          written with different record layouts or it is invalid.
+   */
+  bool Load(const Snapshot& snapshot, const bool verify = false);
+
+  /**
+   * Renumber the nodes (and their edges) in the given order. Edges stay
+   * grouped by their start node in their original order, so searches on
+   * the graph are unchanged other than in their memory access pattern.
+   * @param  order  Node order.
+   */
+  void Reorder(const NodeOrder order);
+
+  /**
+   * Get the Morton (Z-order) curve key of a lat,lng. The lat,lng is
+   * quantized to a 65536 x 65536 grid over the world.
+   * @param  ll  Lat,lng.
+   * @return  Returns the key.
+   */
+  static uint32_t MortonKey(const midgard::PointLL& ll);
+
+  /**
+   * Get the Hilbert curve key of a lat,lng. The lat,lng is quantized to a
+   * 65536 x 65536 grid over the world. Consecutive keys are adjacent grid
+   * cells.
+   * @param  ll  Lat,lng.
+   * @return  Returns the key.
+   */
+  static uint32_t HilbertKey(const midgard::PointLL& ll);
+
+  /**
+   * Get the number of nodes.
+   * @return  Returns the number of nodes.
+   */
+  uint32_t nodecount() const {
+    return node_lls_.size;
+  }
+
+  /**
+   * Get the number of directed edges.
+   * @return  Returns the number of edges.
+   */
+  uint32_t edgecount() const {
+    return edges_.size;
+  }
+
+  /**
+   * Get the index of the first edge leaving a node. The edges of node i
+   * end at edge_index(i + 1).
+   * @param  node  Node index (up to nodecount()).
+   * @return  Returns the edge index.
+   */
+  uint32_t edge_index(const uint32_t node) const {
+    return node_edges_[node];
+  }
+
+  /**
+   * Get the lat,lng of a node.
+   * @param  node  Node index.
+   * @return  Returns the lat,lng.
+   */
+  const midgard::PointLL& latlng(const uint32_t node) const {
+    return node_lls_[node];
+  }
+
+  /**
+   * Get the node record of a node (for costing).
+   * @param  node  Node index.
+   * @return  Returns the node info.
+   */
+  const baldr::NodeInfo* nodeinfo(const uint32_t node) const {
+    return &nodes_[node];
+  }
+
+  /**
+   * Get the GraphId of a node.
+   * @param  node  Node index.
+   * @return  Returns the GraphId.
+   */
+  const baldr::GraphId& nodeid(const uint32_t node) const {
+    return node_ids_[node];
+  }
+
+  /**
+   * Get the packed attributes of an edge.
+   * @param  edge  Edge index.
+   * @return  Returns the edge.
+   */
+  const RoutingEdge& edge(const uint32_t edge) const {
+    return edges_[edge];
+  }
+
+  /**
+   * Get the directed edge record of an edge (for costing).
+   * @param  edge  Edge index.
+   * @return  Returns the directed edge.
+   */
+  const baldr::DirectedEdge* directededge(const uint32_t edge) const {
+    return &directededges_[edge];
+  }
+
+  /**
+   * Get the GraphId of an edge.
+   * @param  edge  Edge index.
+   * @return  Returns the GraphId.
+   */
+  const baldr::GraphId& edgeid(const uint32_t edge) const {
+    return edge_ids_[edge];
+  }
+
+  /**
+   * Get the index of a node.
+   * @param  nodeid  GraphId of the node.
+   * @return  Returns the node index or kInvalidNode if the node is not in
+   *          the graph.
+   */
+  uint32_t NodeIndex(const baldr::GraphId& nodeid) const;
+
+  /**
+   * Get the index of a directed edge.
+   * @param  edgeid  GraphId of the edge.
+   * @return  Returns the edge index or kInvalidNode if the edge is not in
+   *          the graph.
+   */
+  uint32_t EdgeIndex(const baldr::GraphId& edgeid) const;
+
+ protected:
+  // Range of node and edge indexes of a tile
+  struct TileRange {
+    uint64_t tileid;       // Tile base GraphId
+    uint32_t first_node;
+    uint32_t node_count;
+    uint32_t first_edge;
+    uint32_t edge_count;
+  };
+
+  // Array used in place: built by the graph or a section of a snapshot
+  template <class T>
+  struct Array {
+    const T* data;
+    uint32_t size;
+
+    Array() : data(nullptr), size(0) {
+    }
+    const T& operator[](const uint32_t i) const {
+      return data[i];
+    }
+    bool empty() const {
+      return size == 0;
+    }
+    void assign(const std::vector<T>& v) {
+      data = v.data();
+      size = v.size();
+    }
+  };
+
+  // Tile ranges sorted by tile id
+  Array<TileRange> tiles_;
+
+  // Nodes: first edge (nodecount + 1 entries), lat,lng, node record and
+  // GraphId
+  Array<uint32_t> node_edges_;
+  Array<midgard::PointLL> node_lls_;
+  Array<baldr::NodeInfo> nodes_;
+  Array<baldr::GraphId> node_ids_;
+
+  // Edges: packed attributes, directed edge record and GraphId
+  Array<RoutingEdge> edges_;
+  Array<baldr::DirectedEdge> directededges_;
+  Array<baldr::GraphId> edge_ids_;
+
+  // Index of each node and edge (in tile order) in the current order.
+  // Empty while the graph is in tile order.
+  Array<uint32_t> node_rank_;
+  Array<uint32_t> edge_rank_;
+
+  // Snapshot record of the graph: layout version and the sizes of the
+  // copied tile records (these must match when loading)
+  static constexpr uint32_t kGraphVersion = 1;
+  struct GraphHeader {
+    uint32_t version;
+    uint32_t nodeinfo_size;
+    uint32_t directededge_size;
+    uint32_t spare;
+  };
+  mutable GraphHeader graph_header_;
+
+  // Arrays built by the graph (empty if loaded from a snapshot)
+  struct Storage {
+    std::vector<TileRange> tiles;
+    std::vector<uint32_t> node_edges;
+    std::vector<midgard::PointLL> node_lls;
+    std::vector<baldr::NodeInfo> nodes;
+    std::vector<baldr::GraphId> node_ids;
+    std::vector<RoutingEdge> edges;
+    std::vector<baldr::DirectedEdge> directededges;
+    std::vector<baldr::GraphId> edge_ids;
+    std::vector<uint32_t> node_rank;
+    std::vector<uint32_t> edge_rank;
+  };
+  Storage storage_;
+
+  /**
+   * Use the arrays built by the graph.
+   */
+  void UseStorage();
+
+  /**
+   * Find the range of a tile.
+   * @param  id  GraphId within the tile.
+   * @return  Returns the tile range or nullptr if the tile is not in the
+   *          graph.
+   */
+  const TileRange* FindTile(const baldr::GraphId& id) const;
+
+  /**
+   * Point an array at a section of a snapshot.
+   * @param  snapshot  Loaded snapshot.
+   * @param  tag       Section tag.
+   * @param  array     Array to set.
+   * @return  Returns false if the section is missing or is not a whole
+   *          number of elements.
+   */
+  template <class T>
+  static bool LoadArray(const Snapshot& snapshot, const uint32_t tag,
+                        Array<T>& array) {
+    size_t size = 0;
+    const char* data = snapshot.Section(tag, size);
+    if (data == nullptr || size % sizeof(T) != 0) {
+      return false;
+    }
+    array.data = reinterpret_cast<const T*>(data);
+    array.size = size / sizeof(T);
+    return true;
+  }
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_ROUTINGGRAPH_H_
@@ -0,0 +1,37 @@
+#ifndef VALHALLA_THOR_SEARCHSTATS_H_
+#define VALHALLA_THOR_SEARCHSTATS_H_
+
+#include <cstdint>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Statistics about the most recent path search. Used by the benchmark
+ * tools (pathtest) and for logging.
+ */
+struct SearchStats {
+  uint32_t expansions;    // Number of edge labels removed from the
+                          // adjacency list and expanded
+  uint32_t labels;        // Number of edge labels created
+  uint32_t pruned;        // Number of edges not labeled because they
+                          // cannot lead to a path within the cost bound
+  uint32_t tile_lookups;  // Number of graph tile lookups by the search
+  uint32_t tile_reads;    // Number of those passed on to the GraphReader
+                          // (GraphReader::GetGraphTile calls)
+  float path_cost;        // Cost of the path found (0 if none or trivial)
+
+  SearchStats()
+      : expansions(0),
+        labels(0),
+        pruned(0),
+        tile_lookups(0),
+        tile_reads(0),
+        path_cost(0.0f) {
+  }
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_SEARCHSTATS_H_
@@ -0,0 +1,144 @@
+#ifndef VALHALLA_THOR_SEARCHTILECACHE_H_
+#define VALHALLA_THOR_SEARCHTILECACHE_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/thor/tilecache.h>
+#include <valhalla/thor/tilemanifest.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Small cache of the most recently used graph tiles, carried by a single
+ * search. Consecutive lookups during expansion almost always hit one of a
+ * handful of tiles, so resolving them here avoids a lookup into the
+ * GraphReader's tile cache for most calls. Tiles that could not be found
+ * are cached as well (as nullptr). Not thread safe - each search owns one.
+ */
+class SearchTileCache {
+ public:
+  /**
+   * Constructor.
+   */
+  SearchTileCache();
+
+  /**
+   * Set the graph reader (or shared tile cache) used to resolve cache misses
+   * and clear the cache.
+   * @param  graphreader  Graph reader.
+   * @param  shared       Tile cache shared between threads (optional). If
+   *                      set, misses are resolved from it rather than from
+   *                      the graph reader.
+   */
+  void Init(baldr::GraphReader& graphreader, TileCache* shared = nullptr);
+
+  /**
+   * Set a manifest to record tile use in. Each lookup resolved outside of
+   * this cache is counted and the counts are added to the manifest at once
+   * (see Flush) so the manifest's locks are not taken during the search.
+   * @param  manifest  Tile manifest (not owned). nullptr disables recording.
+   */
+  void SetManifest(TileManifest* manifest);
+
+  /**
+   * Add the tile use counted since the last flush to the manifest. Called
+   * by Init and Clear, i.e. once per search.
+   */
+  void Flush();
+
+  /**
+   * Clear the cached tiles and the lookup counts (after flushing the tile
+   * use to the manifest).
+   */
+  void Clear();
+
+  /**
+   * Get the graph tile containing the given GraphId.
+   * @param  id  GraphId of a node or directed edge (or a tile base).
+   * @return  Returns the graph tile or nullptr if it could not be found.
+   */
+  const baldr::GraphTile* Get(const baldr::GraphId& id) {
+    lookups_++;
+    uint64_t tileid = id.Tile_Base().value;
+    for (uint32_t i = 0; i < kCacheSize; i++) {
+      if (tileids_[i] == tileid) {
+        return tiles_[i];
+      }
+    }
+
+    // Not cached - get it from the shared cache or the graph reader and
+    // replace the oldest entry
+    reads_++;
+    const baldr::GraphTile* tile = (shared_ != nullptr) ?
+              shared_->Get(id) : graphreader_->GetGraphTile(id);
+    if (manifest_ != nullptr && tile != nullptr) {
+      TileUse& use = uses_[tileid];
+      use.tileid = id;
+      use.count++;
+      use.size = tile->size();
+    }
+    tileids_[next_] = tileid;
+    tiles_[next_] = tile;
+    next_ = (next_ + 1) % kCacheSize;
+    return tile;
+  }
+
+  /**
+   * Get the number of tile lookups since the last Clear/Init.
+   * @return  Returns the number of lookups.
+   */
+  uint32_t lookups() const {
+    return lookups_;
+  }
+
+  /**
+   * Get the number of lookups that were passed on to the graph reader
+   * (GetGraphTile calls) or shared cache since the last Clear/Init.
+   * @return  Returns the number of GraphReader lookups.
+   */
+  uint32_t reads() const {
+    return reads_;
+  }
+
+ protected:
+  // Number of tiles kept (last N)
+  static constexpr uint32_t kCacheSize = 4;
+
+  // Graph reader and shared tile cache (optional) used to resolve misses
+  baldr::GraphReader* graphreader_;
+  TileCache* shared_;
+
+  // Records tile use (optional) and the use counted since the last flush
+  struct TileUse {
+    baldr::GraphId tileid;
+    uint32_t count;
+    uint32_t size;
+
+    TileUse()
+        : count(0),
+          size(0) {
+    }
+  };
+  TileManifest* manifest_;
+  std::unordered_map<uint64_t, TileUse> uses_;
+
+  // Tile base Ids and the cached tiles. Empty entries have an invalid Id.
+  uint64_t tileids_[kCacheSize];
+  const baldr::GraphTile* tiles_[kCacheSize];
+
+  // Next entry to replace (round robin - the oldest entry)
+  uint32_t next_;
+
+  // Lookup counts
+  uint32_t lookups_;
+  uint32_t reads_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_SEARCHTILECACHE_H_
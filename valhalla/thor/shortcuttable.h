@@ -0,0 +1,115 @@
+#ifndef VALHALLA_THOR_SHORTCUTTABLE_H_
+#define VALHALLA_THOR_SHORTCUTTABLE_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Table mapping shortcut edges to the directed edges (on the local level)
+ * that they replace. The table is built offline (see shortcutbuilder) and
+ * memory mapped at runtime so shortcuts can be unpacked at path formation
+ * with a single lookup rather than recovered by walking the local graph.
+ *
+ * File layout (all values little endian):
+ *   header:  8 byte magic, uint32 version, uint32 shortcut count,
+ *            uint64 edge count
+ *   index:   shortcut count x { uint64 shortcut id, uint32 offset,
+ *            uint32 count } sorted by shortcut id
+ *   edges:   edge count x uint64. The low 48 bits hold the edge id and the
+ *            high 16 bits the fraction of the shortcut length at the end of
+ *            the edge (scaled to 65535).
+ * Ids are packed as tileid | level << 24 | id << 27.
+ */
+class ShortcutTable {
+ public:
+  // Shortcut edges: shortcut Id mapped to the list of edges that make up
+  // the shortcut (in path order) along with the fraction of the shortcut
+  // length at the end of each edge.
+  using shortcut_map_t = std::map<baldr::GraphId,
+                     std::vector<std::pair<baldr::GraphId, float>>>;
+
+  /**
+   * Constructor.
+   */
+  ShortcutTable();
+
+  /**
+   * Destructor. Unmaps the table.
+   */
+  virtual ~ShortcutTable();
+
+  /**
+   * Memory map a shortcut table file.
+   * @param  filename  Shortcut table file.
+   * @return  Returns true if the table was loaded.
+   */
+  bool Load(const std::string& filename);
+
+  /**
+   * Get the edges that make up a shortcut edge.
+   * @param  shortcutid  GraphId of the shortcut edge.
+   * @param  edges       Edges along the shortcut (in path order) with the
+   *                     fraction of the shortcut length at the end of each
+   *                     edge. Edges are appended.
+   * @return  Returns the number of edges added (0 if the edge is not a
+   *          shortcut in the table).
+   */
+  uint32_t Expand(const baldr::GraphId& shortcutid,
+         std::vector<std::pair<baldr::GraphId, float>>& edges) const;
+
+  /**
+   * Get the number of shortcuts in the table.
+   * @return  Returns the number of shortcuts.
+   */
+  uint32_t size() const;
+
+  /**
+   * Write a shortcut table file.
+   * @param  filename   Output file.
+   * @param  shortcuts  Shortcut edges and their constituent edges.
+   * @return  Returns true if the file was written.
+   */
+  static bool Write(const std::string& filename,
+                    const shortcut_map_t& shortcuts);
+
+ protected:
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t shortcut_count;
+    uint64_t edge_count;
+  };
+
+  struct IndexEntry {
+    uint64_t shortcutid;
+    uint32_t offset;
+    uint32_t count;
+  };
+
+  // Memory mapped file
+  void* data_;
+  size_t size_;
+
+  // Pointers into the mapped file
+  const Header* header_;
+  const IndexEntry* index_;
+  const uint64_t* edges_;
+
+  /**
+   * Unmap the file (if mapped).
+   */
+  void Unload();
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_SHORTCUTTABLE_H_
@@ -0,0 +1,199 @@
+#ifndef VALHALLA_THOR_SNAPSHOT_H_
+#define VALHALLA_THOR_SNAPSHOT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Make a section tag from 4 characters.
+ * @param  tag  4 character tag (e.g. "RGND").
+ * @return  Returns the tag.
+ */
+constexpr uint32_t SnapshotTag(const char (&tag)[5]) {
+  return uint32_t(uint8_t(tag[0])) | (uint32_t(uint8_t(tag[1])) << 8) |
+         (uint32_t(uint8_t(tag[2])) << 16) | (uint32_t(uint8_t(tag[3])) << 24);
+}
+
+/**
+ * Snapshot of routing data derived from the tiles (e.g. a RoutingGraph).
+ * Snapshots are written once offline (see routingsnapshot) and memory
+ * mapped at startup. The data of a snapshot is a set of tagged sections
+ * holding arrays that are used in place, so loading does no parsing or
+ * copying, only sections that are used are read from disk and the page
+ * cache is shared by all processes using the snapshot. All offsets are
+ * from the start of the file so a snapshot does not depend on where it is
+ * mapped.
+ *
+ * Load checks the header and section table, and can check that the
+ * snapshot was written from the tiles in use (see TileSetId). Each section
+ * also has a checksum which Verify checks (this reads the whole file).
+ *
+ * File layout (all values little endian):
+ *   header:    8 byte magic, uint32 version, uint32 section count,
+ *              uint64 file size, uint64 checksum of the section table,
+ *              uint64 tile set Id (0 if not recorded)
+ *   table:     section count x { uint32 tag, uint32 spare, uint64 offset,
+ *              uint64 size, uint64 checksum }
+ *   sections:  section data, each starting at a 64 byte aligned offset
+ */
+class Snapshot {
+ public:
+  /**
+   * Constructor.
+   */
+  Snapshot();
+
+  /**
+   * Destructor. Unmaps the snapshot.
+   */
+  virtual ~Snapshot();
+
+  /**
+   * Memory map a snapshot file and check its header and section table.
+   * @param  filename  Snapshot file.
+   * @param  tileset   Tile set Id of the tiles in use (see TileSetId). If
+   *                   not 0 the snapshot must have been written from the
+   *                   same tile set.
+   * @return  Returns true if the snapshot was loaded.
+   */
+  bool Load(const std::string& filename, const uint64_t tileset = 0);
+
+  /**
+   * Check the checksums of all sections.
+   * @return  Returns true if all sections are intact.
+   */
+  bool Verify() const;
+
+  /**
+   * Find the data of a section.
+   * @param  tag   Section tag.
+   * @param  size  Returns the size of the section in bytes.
+   * @return  Returns the section data (64 byte aligned) or nullptr if the
+   *          snapshot has no such section.
+   */
+  const char* Section(const uint32_t tag, size_t& size) const;
+
+  /**
+   * Get the number of sections.
+   * @return  Returns the number of sections.
+   */
+  uint32_t size() const;
+
+  /**
+   * Get the Id of the tile set the snapshot was written from.
+   * @return  Returns the tile set Id (0 if not recorded).
+   */
+  uint64_t tileset() const;
+
+  /**
+   * Compute the checksum (64 bit FNV-1a) of some data.
+   * @param  data  Data.
+   * @param  size  Size of the data in bytes.
+   * @return  Returns the checksum.
+   */
+  static uint64_t Checksum(const char* data, const size_t size);
+
+  /**
+   * Compute the Id of a tile set: a checksum of the tile directory and the
+   * path, size and modification time of each tile file in it. This stats
+   * every tile file but does not read them.
+   * @param  tile_dir  Tile directory of the tile hierarchy.
+   * @return  Returns the tile set Id (0 if the directory has no tiles).
+   */
+  static uint64_t TileSetId(const std::string& tile_dir);
+
+ protected:
+  friend class SnapshotWriter;
+
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t section_count;
+    uint64_t file_size;
+    uint64_t table_checksum;
+    uint64_t tileset;
+  };
+
+  struct SectionEntry {
+    uint32_t tag;
+    uint32_t spare;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t checksum;
+  };
+
+  // Memory mapped file
+  void* data_;
+  size_t size_;
+
+  // Pointers into the mapped file
+  const Header* header_;
+  const SectionEntry* sections_;
+
+  /**
+   * Unmap the file (if mapped).
+   */
+  void Unload();
+};
+
+/**
+ * Writes a snapshot file from sections added in memory.
+ */
+class SnapshotWriter {
+ public:
+  /**
+   * Constructor.
+   */
+  SnapshotWriter();
+
+  /**
+   * Set the Id of the tile set the snapshot is written from.
+   * @param  tileset  Tile set Id (see Snapshot::TileSetId).
+   */
+  void SetTileSet(const uint64_t tileset);
+
+  /**
+   * Add a section. The data is not copied and must remain valid until the
+   * snapshot is written.
+   * @param  tag   Section tag (unique within the snapshot).
+   * @param  data  Section data.
+   * @param  size  Size of the section in bytes.
+   */
+  void Add(const uint32_t tag, const void* data, const size_t size);
+
+  /**
+   * Add a section holding an array.
+   * @param  tag    Section tag (unique within the snapshot).
+   * @param  array  Array (must remain valid until the snapshot is written).
+   */
+  template <class T>
+  void Add(const uint32_t tag, const std::vector<T>& array) {
+    Add(tag, array.data(), array.size() * sizeof(T));
+  }
+
+  /**
+   * Write the snapshot file. The file is written under a temporary name
+   * and renamed, so processes never map a partly written snapshot.
+   * @param  filename  Output file.
+   * @return  Returns true if the file was written.
+   */
+  bool Write(const std::string& filename) const;
+
+ protected:
+  struct Section {
+    uint32_t tag;
+    const char* data;
+    size_t size;
+  };
+  std::vector<Section> sections_;
+  uint64_t tileset_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_SNAPSHOT_H_
@@ -0,0 +1,72 @@
+#ifndef VALHALLA_THOR_SYNCHRONIZEDTILECACHE_H_
+#define VALHALLA_THOR_SYNCHRONIZEDTILECACHE_H_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/baldr/tilehierarchy.h>
+#include <valhalla/thor/tilecache.h>
+#include <valhalla/thor/tileloader.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Thread safe tile cache guarded by a mutex. Tiles are loaded outside of
+ * the lock so a thread reading a tile from disk does not block lookups of
+ * cached tiles by other threads. Tiles are kept for the life of the cache
+ * (nothing is evicted) so returned tiles remain valid.
+ */
+class SynchronizedTileCache : public TileCache {
+ public:
+  /**
+   * Constructor.
+   * @param  hierarchy  Tile hierarchy (tile directory and levels).
+   * @param  loader     Loader used to read tiles (not owned). If nullptr
+   *                    tiles are read from the tile files.
+   */
+  SynchronizedTileCache(const baldr::TileHierarchy& hierarchy,
+                        TileLoader* loader = nullptr);
+
+  /**
+   * Get the graph tile containing the given GraphId, loading it if needed.
+   * @param  id  GraphId of a node or directed edge (or a tile base).
+   * @return  Returns the graph tile or nullptr if it could not be found.
+   */
+  virtual const baldr::GraphTile* Get(const baldr::GraphId& id);
+
+  /**
+   * Load tiles that are not cached using the loader's batch load.
+   * @param  tileids  Tile base GraphIds.
+   */
+  virtual void Preload(const std::vector<baldr::GraphId>& tileids);
+
+  /**
+   * Get statistics about the cache (there are no evictions).
+   * @return  Returns the cache statistics.
+   */
+  virtual TileCacheStats stats() const;
+
+ protected:
+  baldr::TileHierarchy hierarchy_;
+
+  // Tile loader (file_loader_ is used if no loader is given)
+  std::unique_ptr<TileLoader> file_loader_;
+  TileLoader* loader_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<uint64_t, std::unique_ptr<const baldr::GraphTile>> tiles_;
+  size_t size_;
+  uint64_t hits_;
+  uint64_t misses_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_SYNCHRONIZEDTILECACHE_H_
@@ -0,0 +1,127 @@
+#ifndef VALHALLA_THOR_TILEARCHIVE_H_
+#define VALHALLA_THOR_TILEARCHIVE_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/thor/tileloader.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * All tiles of a tile hierarchy packed into one file with an index of tile
+ * offsets. The archive is built offline (see tilearchiver) and memory
+ * mapped at runtime, so opening it does not depend on the number of tiles,
+ * tiles are accessed in place (no copy) and the page cache is shared by all
+ * processes using the archive.
+ *
+ * File layout (all values little endian):
+ *   header:  8 byte magic, uint32 version, uint32 tile count
+ *   index:   tile count x { uint64 tile id, uint64 offset, uint64 size }
+ *            sorted by tile id (GraphId value of the tile base)
+ *   tiles:   tile data, each starting at an 8 byte aligned offset from the
+ *            start of the file
+ */
+class TileArchive {
+ public:
+  /**
+   * Constructor.
+   */
+  TileArchive();
+
+  /**
+   * Destructor. Unmaps the archive.
+   */
+  virtual ~TileArchive();
+
+  /**
+   * Memory map a tile archive file.
+   * @param  filename  Tile archive file.
+   * @return  Returns true if the archive was loaded.
+   */
+  bool Load(const std::string& filename);
+
+  /**
+   * Find the data of a tile.
+   * @param  tileid  GraphId within the tile.
+   * @param  size    Returns the size of the tile data.
+   * @return  Returns the tile data or nullptr if the tile is not in the
+   *          archive.
+   */
+  const char* Find(const baldr::GraphId& tileid, size_t& size) const;
+
+  /**
+   * Get the number of tiles in the archive.
+   * @return  Returns the number of tiles.
+   */
+  uint32_t size() const;
+
+  /**
+   * Write a tile archive file.
+   * @param  filename  Output file.
+   * @param  tiles     Tile base GraphIds and the tile files to pack.
+   * @return  Returns true if the file was written.
+   */
+  static bool Write(const std::string& filename,
+      const std::vector<std::pair<baldr::GraphId, std::string>>& tiles);
+
+ protected:
+  struct Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t tile_count;
+  };
+
+  struct IndexEntry {
+    uint64_t tileid;
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  // Memory mapped file
+  void* data_;
+  size_t size_;
+
+  // Pointers into the mapped file
+  const Header* header_;
+  const IndexEntry* index_;
+
+  /**
+   * Unmap the file (if mapped).
+   */
+  void Unload();
+};
+
+/**
+ * Loads graph tiles from a tile archive. Tiles reference the mapped archive
+ * data (no copy) so the archive must outlive them.
+ */
+class ArchiveTileLoader : public TileLoader {
+ public:
+  /**
+   * Constructor.
+   * @param  archive  Loaded tile archive.
+   */
+  ArchiveTileLoader(const TileArchive& archive);
+
+  /**
+   * Load a tile from the archive.
+   * @param  tileid  Tile base GraphId.
+   * @return  Returns the tile (owned by the caller) or nullptr if the tile
+   *          is not in the archive.
+   */
+  virtual baldr::GraphTile* Load(const baldr::GraphId& tileid);
+
+ protected:
+  const TileArchive& archive_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_TILEARCHIVE_H_
@@ -0,0 +1,175 @@
+#ifndef VALHALLA_THOR_TILECACHE_H_
+#define VALHALLA_THOR_TILECACHE_H_
+
+#include <cstdint>
+#include <vector>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphreader.h>
+#include <valhalla/baldr/graphtile.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Tile cache statistics (since the cache was created).
+ */
+struct TileCacheStats {
+  uint64_t hits;        // Lookups of a cached tile
+  uint64_t misses;      // Lookups that loaded a tile
+  uint64_t evictions;   // Tiles evicted
+  uint64_t bytes;       // Size of the cached tiles
+
+  TileCacheStats()
+      : hits(0),
+        misses(0),
+        evictions(0),
+        bytes(0) {
+  }
+};
+
+/**
+ * Interface to a cache of graph tiles that is shared by searches running
+ * on different threads. Implementations must be thread safe. Caches that
+ * evict tiles must not free a tile while a reader that may be using it is
+ * inside a read section (BeginRead/EndRead). Caches that never evict can
+ * ignore read sections.
+ */
+class TileCache {
+ public:
+  virtual ~TileCache() {
+  }
+
+  /**
+   * Get the graph tile containing the given GraphId, loading it if needed.
+   * The tile may only be used within a read section.
+   * @param  id  GraphId of a node or directed edge (or a tile base).
+   * @return  Returns the graph tile or nullptr if it could not be found.
+   */
+  virtual const baldr::GraphTile* Get(const baldr::GraphId& id) = 0;
+
+  /**
+   * Load tiles into the cache ahead of their use (e.g. tiles ahead of a
+   * search frontier). Tiles that are cached are skipped. The default gets
+   * the tiles one at a time - caches with a batch loader read the tiles
+   * concurrently.
+   * @param  tileids  Tile base GraphIds.
+   */
+  virtual void Preload(const std::vector<baldr::GraphId>& tileids) {
+    for (const auto& tileid : tileids) {
+      Get(tileid);
+    }
+  }
+
+  /**
+   * Register a reader (e.g. a search context). Each reader is used by one
+   * thread at a time.
+   * @return  Returns the reader Id.
+   */
+  virtual uint32_t RegisterReader() {
+    return 0;
+  }
+
+  /**
+   * Release a reader Id so a later RegisterReader can reuse it. The reader
+   * must not be in a read section.
+   * @param  reader  Reader Id.
+   */
+  virtual void ReleaseReader(const uint32_t reader) {
+  }
+
+  /**
+   * Begin a read section. Tiles got within the section remain valid until
+   * the matching EndRead. Sections may be nested.
+   * @param  reader  Reader Id.
+   */
+  virtual void BeginRead(const uint32_t reader) {
+  }
+
+  /**
+   * End a read section.
+   * @param  reader  Reader Id.
+   */
+  virtual void EndRead(const uint32_t reader) {
+  }
+
+  /**
+   * Get statistics about the cache.
+   * @return  Returns the cache statistics.
+   */
+  virtual TileCacheStats stats() const {
+    return TileCacheStats();
+  }
+};
+
+/**
+ * Read section on a tile cache for the life of the object.
+ */
+class TileCacheReadGuard {
+ public:
+  TileCacheReadGuard(TileCache* tilecache, const uint32_t reader)
+      : tilecache_(tilecache),
+        reader_(reader) {
+    if (tilecache_ != nullptr) {
+      tilecache_->BeginRead(reader_);
+    }
+  }
+
+  ~TileCacheReadGuard() {
+    if (tilecache_ != nullptr) {
+      tilecache_->EndRead(reader_);
+    }
+  }
+
+ protected:
+  TileCache* tilecache_;
+  uint32_t reader_;
+};
+
+/**
+ * Get the graph tile containing the given GraphId from the tile cache or,
+ * if there is no tile cache, from the graph reader. Searches use this
+ * outside of the expansion (origin and destination edges, path forming,
+ * trip path building) so those reads share the cached tiles rather than
+ * loading copies into a per-thread GraphReader. Tiles from the cache may
+ * only be used within a read section.
+ * @param  graphreader  Graph reader.
+ * @param  tilecache    Tile cache (optional).
+ * @param  id           GraphId of a node or directed edge (or a tile base).
+ * @return  Returns the graph tile or nullptr if it could not be found.
+ */
+inline const baldr::GraphTile* GetGraphTile(baldr::GraphReader& graphreader,
+                                            TileCache* tilecache,
+                                            const baldr::GraphId& id) {
+  return (tilecache != nullptr) ?
+      tilecache->Get(id) : graphreader.GetGraphTile(id);
+}
+
+/**
+ * Get the opposing directed edge of a directed edge, reading tiles as
+ * GetGraphTile does.
+ * @param  graphreader  Graph reader.
+ * @param  tilecache    Tile cache (optional).
+ * @param  edgeid       GraphId of the directed edge.
+ * @return  Returns the opposing edge Id (invalid if a tile is missing).
+ */
+inline baldr::GraphId GetOpposingEdgeId(baldr::GraphReader& graphreader,
+                                        TileCache* tilecache,
+                                        const baldr::GraphId& edgeid) {
+  const baldr::GraphTile* tile = GetGraphTile(graphreader, tilecache, edgeid);
+  if (tile == nullptr) {
+    return baldr::GraphId();
+  }
+  const baldr::DirectedEdge* edge = tile->directededge(edgeid);
+  baldr::GraphId endnode = edge->endnode();
+  const baldr::GraphTile* endtile = GetGraphTile(graphreader, tilecache, endnode);
+  if (endtile == nullptr) {
+    return baldr::GraphId();
+  }
+  return baldr::GraphId(endnode.tileid(), endnode.level(),
+             endtile->node(endnode)->edge_index() + edge->opp_index());
+}
+
+}
+}
+
+#endif  // VALHALLA_THOR_TILECACHE_H_
@@ -0,0 +1,65 @@
+#ifndef VALHALLA_THOR_TILELOADER_H_
+#define VALHALLA_THOR_TILELOADER_H_
+
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/graphtile.h>
+#include <valhalla/baldr/tilehierarchy.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Loads graph tiles for a tile cache. Implementations must be thread safe.
+ */
+class TileLoader {
+ public:
+  virtual ~TileLoader() {
+  }
+
+  /**
+   * Load a tile.
+   * @param  tileid  Tile base GraphId.
+   * @return  Returns the tile (owned by the caller) or nullptr if the tile
+   *          does not exist.
+   */
+  virtual baldr::GraphTile* Load(const baldr::GraphId& tileid) = 0;
+
+  /**
+   * Load a batch of tiles. The default loads the tiles one at a time.
+   * @param  tileids  Tile base GraphIds.
+   * @param  tiles    Returns the tiles in the same order (owned by the
+   *                  caller, nullptr for tiles that do not exist).
+   */
+  virtual void LoadBatch(const std::vector<baldr::GraphId>& tileids,
+                         std::vector<baldr::GraphTile*>& tiles);
+};
+
+/**
+ * Loads graph tiles from the tile files in the tile hierarchy directory.
+ */
+class FileTileLoader : public TileLoader {
+ public:
+  /**
+   * Constructor.
+   * @param  hierarchy  Tile hierarchy (tile directory and levels).
+   */
+  FileTileLoader(const baldr::TileHierarchy& hierarchy);
+
+  /**
+   * Load a tile from its file.
+   * @param  tileid  Tile base GraphId.
+   * @return  Returns the tile (owned by the caller) or nullptr if the tile
+   *          does not exist.
+   */
+  virtual baldr::GraphTile* Load(const baldr::GraphId& tileid);
+
+ protected:
+  baldr::TileHierarchy hierarchy_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_TILELOADER_H_
@@ -0,0 +1,133 @@
+#ifndef VALHALLA_THOR_TILEMANIFEST_H_
+#define VALHALLA_THOR_TILEMANIFEST_H_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/thor/tilecache.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Record of which tiles searches use and how often. The service records
+ * tile use while it runs and periodically writes the manifest. On startup
+ * the manifest of the previous run is loaded and the most used tiles are
+ * preloaded into the shared tile cache before requests are taken, so the
+ * first requests after a restart do not all run against a cold cache.
+ * Counts from a loaded manifest carry over (halved, so tiles that are no
+ * longer used age out), so the manifest reflects use across restarts.
+ *
+ * The manifest file is text, one tile per line (most used first):
+ *   <level> <tile id> <count> <size in bytes>
+ */
+class TileManifest {
+ public:
+  /**
+   * Use of one tile.
+   */
+  struct Entry {
+    baldr::GraphId tileid;
+    uint64_t count;
+    uint32_t size;
+
+    Entry(const baldr::GraphId& id, const uint64_t c, const uint32_t s)
+        : tileid(id),
+          count(c),
+          size(s) {
+    }
+  };
+
+  /**
+   * Constructor.
+   */
+  TileManifest();
+
+  /**
+   * Record uses of a tile. Thread safe.
+   * @param  tileid  GraphId within the tile.
+   * @param  size    Size of the tile in bytes.
+   * @param  count   Number of uses.
+   */
+  void Record(const baldr::GraphId& tileid, const size_t size,
+              const uint64_t count = 1);
+
+  /**
+   * Load a manifest file, adding its counts (halved) to the recorded
+   * counts.
+   * @param  filename  Manifest file.
+   * @return  Returns false if the file could not be read.
+   */
+  bool Load(const std::string& filename);
+
+  /**
+   * Write the manifest to a file (replacing it atomically). Thread safe.
+   * @param  filename  Manifest file.
+   * @return  Returns true if the file was written.
+   */
+  bool Write(const std::string& filename) const;
+
+  /**
+   * Get the most used tiles within a tile count and size budget.
+   * @param  max_tiles  Maximum number of tiles.
+   * @param  max_bytes  Maximum total size of the tiles.
+   * @return  Returns the tiles, most used first.
+   */
+  std::vector<Entry> Top(const uint32_t max_tiles,
+                         const size_t max_bytes) const;
+
+  /**
+   * Get the number of tiles recorded.
+   * @return  Returns the number of tiles.
+   */
+  size_t size() const;
+
+  /**
+   * Preload tiles into a tile cache using several threads.
+   * @param  tilecache  Tile cache.
+   * @param  tiles      Tiles to preload.
+   * @param  threads    Number of threads.
+   */
+  static void Warmup(TileCache& tilecache, const std::vector<Entry>& tiles,
+                     const uint32_t threads);
+
+ protected:
+  // Tiles per batch when warming up
+  static constexpr uint32_t kWarmupBatchSize = 64;
+
+  // Counts are striped over several maps so threads recording different
+  // tiles do not contend on one lock
+  static constexpr uint32_t kStripes = 16;
+
+  struct Usage {
+    baldr::GraphId tileid;
+    uint64_t count;
+    uint32_t size;
+
+    Usage()
+        : count(0),
+          size(0) {
+    }
+  };
+
+  /**
+   * Get all recorded tiles sorted by count (most used first).
+   * @return  Returns the tiles.
+   */
+  std::vector<Entry> Sorted() const;
+
+  mutable std::mutex mutexes_[kStripes];
+  std::unordered_map<uint64_t, Usage> usage_[kStripes];
+
+  // Serializes writes of the manifest file
+  mutable std::mutex write_mutex_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_TILEMANIFEST_H_
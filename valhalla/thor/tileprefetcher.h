@@ -0,0 +1,116 @@
+#ifndef VALHALLA_THOR_TILEPREFETCHER_H_
+#define VALHALLA_THOR_TILEPREFETCHER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <valhalla/midgard/pointll.h>
+#include <valhalla/baldr/graphid.h>
+#include <valhalla/baldr/tilehierarchy.h>
+#include <valhalla/thor/tilecache.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Background prefetching of graph tiles ahead of the search frontier. The
+ * search periodically reports the position of its current best label and
+ * the destination. The tiles (at each hierarchy level) around that position
+ * and ahead of it in the direction of the destination are read by a
+ * background thread so that they are resident by the time the search
+ * reaches them. This overlaps disk I/O for cold tiles with the search.
+ * When given a shared tile cache, tiles are loaded into that cache rather
+ * than only read into the page cache, in batches of all pending tiles.
+ */
+class TilePrefetcher {
+ public:
+  /**
+   * Constructor. Starts the background thread.
+   * @param  hierarchy  Tile hierarchy (tile directory and tiling per level).
+   * @param  tilecache  Shared tile cache to load tiles into (optional, not
+   *                    owned).
+   */
+  TilePrefetcher(const baldr::TileHierarchy& hierarchy,
+                 TileCache* tilecache = nullptr);
+
+  /**
+   * Destructor. Stops the background thread (pending requests are dropped).
+   */
+  virtual ~TilePrefetcher();
+
+  /**
+   * Request tiles around and ahead of the search frontier. Returns
+   * immediately - tiles are read in the background. Tiles that are pending
+   * are not queued again. With a shared tile cache, tiles still resident
+   * are not read again (the cache skips them). Without one, the most
+   * recently read tiles are not read again.
+   * @param  frontier  Lat,lng of the current best label (end node).
+   * @param  dest      Lat,lng of the destination.
+   */
+  void Prefetch(const midgard::PointLL& frontier,
+                const midgard::PointLL& dest);
+
+  /**
+   * Get the number of tiles that have been read by the prefetcher.
+   * @return  Returns the number of tiles prefetched.
+   */
+  uint32_t prefetched() const;
+
+ protected:
+  // Maximum number of pending requests. Older requests are dropped since
+  // the frontier has moved on.
+  static constexpr uint32_t kMaxPending = 64;
+
+  // Number of recently read tiles that are not read again (without a shared
+  // tile cache, which knows which tiles are resident)
+  static constexpr uint32_t kMaxRecent = 1024;
+
+  /**
+   * Read a tile file (so it is in the page cache). Called on the background
+   * thread when there is no shared tile cache.
+   * @param  tileid  Tile base GraphId.
+   */
+  virtual void Load(const baldr::GraphId& tileid);
+
+  /**
+   * Queue a tile unless it is pending or was recently read. Requires mutex_
+   * to be held.
+   * @param  tileid  Tile base GraphId.
+   */
+  void Queue(const baldr::GraphId& tileid);
+
+  /**
+   * Background thread - reads tiles from the queue until stopped. With a
+   * shared tile cache all pending tiles are preloaded as a batch.
+   */
+  void Run();
+
+  baldr::TileHierarchy hierarchy_;
+  TileCache* tilecache_;
+
+  // Read buffer (only used by the background thread)
+  std::vector<char> buffer_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<baldr::GraphId> pending_;
+
+  // Tiles that are pending, being read or recently read (not queued again)
+  // and the recently read tiles, oldest first
+  std::unordered_set<uint64_t> requested_;
+  std::deque<uint64_t> recent_;
+  bool done_;
+  std::atomic<uint32_t> prefetched_;
+  std::thread thread_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_TILEPREFETCHER_H_
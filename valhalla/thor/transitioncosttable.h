@@ -0,0 +1,144 @@
+#ifndef VALHALLA_THOR_TRANSITIONCOSTTABLE_H_
+#define VALHALLA_THOR_TRANSITIONCOSTTABLE_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <valhalla/sif/dynamiccost.h>
+#include <valhalla/thor/routinggraph.h>
+
+namespace valhalla {
+namespace thor {
+
+/**
+ * Transition (turn) costs of a routing graph for one costing. Each node has
+ * a matrix of costs with a row per incoming edge, indexed by the local index
+ * of its opposing edge at the node (the predecessor's opp_local_idx), and a
+ * column per outgoing edge of the node. Searches on the routing graph read
+ * the row of the predecessor instead of calling DynamicCost::TransitionCost
+ * for each outgoing edge.
+ *
+ * Costs are computed with an edge label of the incoming edge, so they are
+ * only used when the predecessor is that (regular) edge. Predecessors that
+ * are origin edges, shortcuts or transition edges have no row and the
+ * search calls the costing. This assumes the costing's transition cost
+ * depends only on the edges and the node, not on the cost or distance of
+ * the path so far (true of the sif costings).
+ *
+ * The table is keyed by a fingerprint of the costing options. When the
+ * options change all matrices become stale and a node's matrix is
+ * recomputed when a search first expands the node. Storage for a node's
+ * matrix is allocated when the matrix is first computed, so a lazily
+ * customized table only holds the matrices of nodes searches expanded.
+ * The table is not thread safe (use one per search thread) except when
+ * eagerly customized: searches then only read it, so one table can be
+ * shared by searches on several threads until it is customized again.
+ */
+class TransitionCostTable {
+ public:
+  /**
+   * Constructor (empty table).
+   */
+  TransitionCostTable();
+
+  /**
+   * Customize the table for a costing. Does nothing if the table is
+   * already customized for the fingerprint. Otherwise all matrices become
+   * stale and are recomputed when read, or are all computed now if eager.
+   * Sets up the matrix layout if the table was built for another graph.
+   * @param  graph        Routing graph.
+   * @param  costing      Costing method.
+   * @param  fingerprint  Fingerprint of the costing options.
+   * @param  eager        Compute the matrices of all nodes now.
+   */
+  void Customize(const RoutingGraph& graph,
+                 const std::shared_ptr<sif::DynamicCost>& costing,
+                 const uint64_t fingerprint, const bool eager);
+
+  /**
+   * Get the transition costs from an incoming edge to the outgoing edges of
+   * a node, computing the node's matrix if stale.
+   * @param  node       Node index in the routing graph.
+   * @param  prededge   Edge index of the predecessor (ending at the node).
+   * @param  local_idx  Local index of the predecessor's opposing edge at
+   *                    the node (opp_local_idx of the predecessor label).
+   * @param  graph      Routing graph (the table was customized for).
+   * @param  costing    Costing method (of the table's fingerprint).
+   * @return  Returns the costs of the node's outgoing edges in graph order
+   *          (index by edge - graph.edge_index(node)), or nullptr if the
+   *          table has no row for the predecessor. The row is valid until
+   *          the next call to Row or Customize.
+   */
+  const sif::Cost* Row(const uint32_t node, const uint32_t prededge,
+                       const uint32_t local_idx, const RoutingGraph& graph,
+                       const sif::DynamicCost& costing) {
+    if (local_idx >= first_row_[node + 1] - first_row_[node] ||
+        incoming_[first_row_[node] + local_idx] != prededge) {
+      return nullptr;
+    }
+    if (generations_[node] != generation_) {
+      Compute(node, graph, costing);
+    }
+    return &costs_[offsets_[node] + local_idx *
+                   (graph.edge_index(node + 1) - graph.edge_index(node))];
+  }
+
+  /**
+   * Get the fingerprint the table is customized for.
+   * @return  Returns the fingerprint.
+   */
+  uint64_t fingerprint() const;
+
+  /**
+   * Get the number of transition costs the table has storage for (the
+   * matrices computed since the layout was set up).
+   * @return  Returns the number of transition costs.
+   */
+  uint64_t size() const;
+
+  /**
+   * Get the number of node matrices computed since the last customization.
+   * @return  Returns the number of matrices computed.
+   */
+  uint64_t computed() const;
+
+ protected:
+  /**
+   * Set up the rows of all nodes and release the matrices.
+   * @param  graph  Routing graph.
+   */
+  void Layout(const RoutingGraph& graph);
+
+  /**
+   * Compute the matrix of a node, allocating it if needed.
+   * @param  node     Node index in the routing graph.
+   * @param  graph    Routing graph.
+   * @param  costing  Costing method.
+   */
+  void Compute(const uint32_t node, const RoutingGraph& graph,
+               const sif::DynamicCost& costing);
+
+  // Offset of a node's matrix that has not been allocated
+  static constexpr uint64_t kUnallocated = ~0ull;
+
+  uint64_t fingerprint_;
+  uint32_t generation_;
+  uint64_t computed_;
+
+  // Per node: first row (incoming edge, with an entry past the last node)
+  // and offset of the node's matrix in costs_ (kUnallocated if none).
+  std::vector<uint32_t> first_row_;
+  std::vector<uint64_t> offsets_;
+
+  // Incoming edge of each row (kInvalidNode if none), generation each node's
+  // matrix was computed in and the allocated matrices.
+  std::vector<uint32_t> incoming_;
+  std::vector<uint32_t> generations_;
+  std::vector<sif::Cost> costs_;
+};
+
+}
+}
+
+#endif  // VALHALLA_THOR_TRANSITIONCOSTTABLE_H_
@@ -9,6 +9,7 @@
 #include <valhalla/proto/trippath.pb.h>
 #include <valhalla/baldr/pathlocation.h>
 #include <valhalla/thor/pathinfo.h>
+#include <valhalla/thor/tilecache.h>
 
 namespace valhalla {
 namespace thor {
@@ -31,11 +32,16 @@ class TripPathBuilder {
   /**
    * Format the trip path output given the edges on the path.
    * For now just return length. TODO - modify to return trip path.
+   * @param  tilecache  Tile cache shared with the search (optional). If
+   *                    set, tiles are read from it (within a read section
+   *                    for the given reader) rather than the graph reader.
+   * @param  reader     Reader Id on the tile cache.
    */
   static odin::TripPath Build(baldr::GraphReader& graphreader,
              const std::vector<PathInfo>& path,
              const baldr::PathLocation& origin,
-             const baldr::PathLocation& dest);
+             const baldr::PathLocation& dest,
+             TileCache* tilecache = nullptr, const uint32_t reader = 0);
 
   /**
    * Add trip edge. (TODO more comments)